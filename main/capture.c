@@ -0,0 +1,247 @@
+#include "capture.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#define NO_BUFFER   -1
+#define MAX_CAPTURE 9999
+
+static const char* TAG = "capture";
+
+static SemaphoreHandle_t capture_mutex = NULL;
+static SemaphoreHandle_t stopped       = NULL;  // Given by the writer task once the file is closed
+static TaskHandle_t      writer_task   = NULL;
+static FILE*             file          = NULL;
+static bool              active        = false;
+static bool              stopping      = false;
+static capture_stats_t   stats         = {0};
+
+// Double buffering, frames are appended to the current buffer while the writer task writes out the pending one
+static uint8_t* buffers[2]     = {0};
+static size_t   buffer_fill[2] = {0};
+static int      current        = 0;
+static int      pending        = NO_BUFFER;
+
+// Hand the current buffer to the writer task, must be called with the mutex held
+static bool swap_buffers(void) {
+    if (pending != NO_BUFFER) {
+        return false;
+    }
+    pending              = current;
+    current             ^= 1;
+    buffer_fill[current] = 0;
+    return true;
+}
+
+static void write_pending(void) {
+    xSemaphoreTake(capture_mutex, portMAX_DELAY);
+    int index = pending;
+    xSemaphoreGive(capture_mutex);
+    if (index == NO_BUFFER) {
+        return;
+    }
+
+    int64_t start = esp_timer_get_time();
+    size_t  size  = buffer_fill[index];
+    if (fwrite(buffers[index], 1, size, file) != size) {
+        ESP_LOGE(TAG, "Failed to write capture");
+    }
+    fflush(file);
+    fsync(fileno(file));
+    uint32_t duration = (uint32_t)(esp_timer_get_time() - start);
+
+    xSemaphoreTake(capture_mutex, portMAX_DELAY);
+    stats.bytes += size;
+    stats.writes++;
+    if (duration > stats.max_write_us) {
+        stats.max_write_us = duration;
+    }
+    pending = NO_BUFFER;
+    xSemaphoreGive(capture_mutex);
+}
+
+static void capture_task(void* arg) {
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CAPTURE_FLUSH_INTERVAL_MS));
+        if (file == NULL) {
+            continue;
+        }
+
+        write_pending();
+
+        // Write out a partially filled buffer as well, so a capture survives a reset with little loss
+        xSemaphoreTake(capture_mutex, portMAX_DELAY);
+        bool stop = stopping;
+        if (buffer_fill[current] > 0) {
+            swap_buffers();
+        }
+        xSemaphoreGive(capture_mutex);
+        write_pending();
+
+        if (stop) {
+            fclose(file);
+            file = NULL;
+            xSemaphoreGive(stopped);
+        }
+    }
+}
+
+static bool allocate_buffers(void) {
+    for (size_t i = 0; i < 2; i++) {
+        if (buffers[i] == NULL) {
+            buffers[i] = heap_caps_malloc(CAPTURE_BUFFER_SIZE, MALLOC_CAP_SPIRAM);
+        }
+        if (buffers[i] == NULL) {
+            buffers[i] = malloc(CAPTURE_BUFFER_SIZE);
+        }
+        if (buffers[i] == NULL) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static FILE* create_file(char* out_path, size_t max_length) {
+    char path[64];
+    for (unsigned int i = 0; i <= MAX_CAPTURE; i++) {
+        snprintf(path, sizeof(path), "%s/cap_%04u.mcp", CAPTURE_BASE_PATH, i);
+        struct stat st;
+        if (stat(path, &st) == 0) {
+            continue;
+        }
+        FILE* new_file = fopen(path, "wb");
+        if (new_file != NULL && out_path != NULL) {
+            snprintf(out_path, max_length, "%s", path);
+        }
+        return new_file;
+    }
+    return NULL;
+}
+
+esp_err_t capture_start(char* out_path, size_t max_length) {
+    if (active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (capture_mutex == NULL) {
+        capture_mutex = xSemaphoreCreateMutex();
+        stopped       = xSemaphoreCreateBinary();
+        if (capture_mutex == NULL || stopped == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if (!allocate_buffers()) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (writer_task == NULL && xTaskCreate(capture_task, "capture", CAPTURE_TASK_STACK, NULL, CAPTURE_TASK_PRIORITY,
+                                           &writer_task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    FILE* new_file = create_file(out_path, max_length);
+    if (new_file == NULL) {
+        ESP_LOGE(TAG, "Failed to create capture file");
+        return ESP_FAIL;
+    }
+
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    capture_file_header_t header = {
+        .magic       = CAPTURE_MAGIC,
+        .version     = CAPTURE_VERSION,
+        .header_size = sizeof(capture_file_header_t),
+        .start_time  = now.tv_sec > 0 ? (uint64_t)now.tv_sec * 1000000 + now.tv_usec : 0,
+    };
+    if (fwrite(&header, sizeof(header), 1, new_file) != 1) {
+        fclose(new_file);
+        return ESP_FAIL;
+    }
+
+    xSemaphoreTake(capture_mutex, portMAX_DELAY);
+    file           = new_file;
+    current        = 0;
+    pending        = NO_BUFFER;
+    buffer_fill[0] = 0;
+    buffer_fill[1] = 0;
+    stopping       = false;
+    active         = true;
+    memset(&stats, 0, sizeof(capture_stats_t));
+    xSemaphoreGive(capture_mutex);
+    return ESP_OK;
+}
+
+void capture_stop(void) {
+    if (!active) {
+        return;
+    }
+    xSemaphoreTake(capture_mutex, portMAX_DELAY);
+    active   = false;
+    stopping = true;
+    xSemaphoreGive(capture_mutex);
+    xTaskNotifyGive(writer_task);
+    xSemaphoreTake(stopped, portMAX_DELAY);
+}
+
+bool capture_is_active(void) {
+    return active;
+}
+
+void capture_frame(const packet_rx_info_t* rx, int64_t timestamp, bool transmitted, const uint8_t* data,
+                   uint8_t length) {
+    if (!active) {
+        return;
+    }
+
+    capture_record_header_t header = {
+        .timestamp = timestamp,
+        .rssi      = rx != NULL ? rx->rssi : CAPTURE_RSSI_UNKNOWN,
+        .snr       = rx != NULL ? rx->snr : CAPTURE_SNR_UNKNOWN,
+        .flags     = transmitted ? CAPTURE_FLAG_TX : 0,
+        .length    = length,
+    };
+    size_t size = sizeof(header) + length;
+
+    xSemaphoreTake(capture_mutex, portMAX_DELAY);
+    if (!active) {
+        xSemaphoreGive(capture_mutex);
+        return;
+    }
+    if (buffer_fill[current] + size > CAPTURE_BUFFER_SIZE) {
+        if (!swap_buffers()) {
+            // The writer has not caught up, drop instead of blocking the packet path
+            stats.dropped++;
+            xSemaphoreGive(capture_mutex);
+            return;
+        }
+        xTaskNotifyGive(writer_task);
+    }
+    uint8_t* position = &buffers[current][buffer_fill[current]];
+    memcpy(position, &header, sizeof(header));
+    memcpy(position + sizeof(header), data, length);
+    buffer_fill[current] += size;
+    stats.frames++;
+    xSemaphoreGive(capture_mutex);
+}
+
+void capture_get_stats(capture_stats_t* out_stats) {
+    if (capture_mutex == NULL) {
+        memset(out_stats, 0, sizeof(capture_stats_t));
+        return;
+    }
+    xSemaphoreTake(capture_mutex, portMAX_DELAY);
+    *out_stats = stats;
+    xSemaphoreGive(capture_mutex);
+}
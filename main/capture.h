@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "capture_format.h"
+#include "esp_err.h"
+#include "message_store.h"
+#include "packet_pool.h"
+
+#define CAPTURE_BASE_PATH         MESSAGE_STORE_BASE_PATH  // Next to the message store on the FAT partition
+#define CAPTURE_BUFFER_SIZE       4096                     // Bytes per buffer, one is filled while the other is written
+#define CAPTURE_FLUSH_INTERVAL_MS 2000                     // Partially filled buffers are written out after this time
+#define CAPTURE_TASK_STACK        3072
+#define CAPTURE_TASK_PRIORITY     2
+
+typedef struct {
+    uint32_t frames;        // Frames recorded
+    uint32_t dropped;       // Frames dropped because both buffers were full
+    uint64_t bytes;         // Bytes written to the file
+    uint32_t writes;        // Buffers written to the file
+    uint32_t max_write_us;  // Longest time a buffer write took
+} capture_stats_t;
+
+// Start recording frames to a new file in CAPTURE_BASE_PATH, the message store must have been initialized. The name of
+// the file is returned in out_path when it is not NULL.
+esp_err_t capture_start(char* out_path, size_t max_length);
+
+// Write out what is still buffered and close the file
+void capture_stop(void);
+
+bool capture_is_active(void);
+
+// Record a frame. Only copies into a RAM buffer, the file is written by a background task, so this is safe to call
+// from the packet path. RSSI and SNR are taken from rx, pass NULL for transmitted frames.
+void capture_frame(const packet_rx_info_t* rx, int64_t timestamp, bool transmitted, const uint8_t* data,
+                   uint8_t length);
+
+void capture_get_stats(capture_stats_t* out_stats);
@@ -0,0 +1,28 @@
+#pragma once
+
+// On-disk layout of raw frame captures, shared by the firmware and the host tools. A capture file is a file header
+// followed by records, each record is a record header followed by the raw frame. All fields are little endian.
+
+#include <stdint.h>
+
+#define CAPTURE_MAGIC          0x5043434D  // "MCCP"
+#define CAPTURE_VERSION        1
+#define CAPTURE_FLAG_TX        0x01  // Frame was transmitted by us, RSSI and SNR are unknown
+#define CAPTURE_RSSI_UNKNOWN   INT16_MIN
+#define CAPTURE_SNR_UNKNOWN    INT8_MIN
+#define CAPTURE_MAX_FRAME_SIZE 255
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;  // Size of this header, readers skip fields they do not know
+    uint64_t start_time;   // Unix time in microseconds at which the capture started, 0 when the clock was not set
+} capture_file_header_t;
+
+typedef struct __attribute__((packed)) {
+    int64_t timestamp;  // Microseconds since boot (esp_timer)
+    int16_t rssi;       // dBm
+    int8_t  snr;        // dB * 4
+    uint8_t flags;
+    uint8_t length;  // Length of the frame that follows
+} capture_record_header_t;
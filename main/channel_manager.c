@@ -0,0 +1,181 @@
+#include "channel_manager.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "device_settings.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "hex.h"
+#include "meshcore/channels.h"
+#include "meshcore/trace.h"
+#include "perf_counters.h"
+
+static const char* TAG = "channels";
+
+// Stored subscription, the key material is derived again when loading
+typedef struct __attribute__((packed)) {
+    char    name[MESHCORE_CHANNEL_NAME_SIZE + sizeof('\0')];
+    uint8_t secret_length;  // 0 for an unused record
+    uint8_t secret[MESHCORE_CHANNEL_MAX_SECRET_SIZE];
+} channel_record_t;
+
+static const uint8_t default_secret[] = {0x8b, 0x33, 0x87, 0xe9, 0xc5, 0xcd, 0xea, 0x6a,
+                                         0xc9, 0xe5, 0xed, 0xba, 0xa1, 0x15, 0xcd, 0x72};
+
+static meshcore_channels_t channels = {0};
+static SemaphoreHandle_t   mutex    = NULL;  // Held by the meshcore task while decrypting, by the UI for changes
+
+static void fill_info(const meshcore_channel_t* channel, channel_info_t* out_info) {
+    if (out_info != NULL) {
+        snprintf(out_info->name, sizeof(out_info->name), "%s", channel->name);
+        memcpy(out_info->id, channel->id, sizeof(out_info->id));
+        out_info->hash = channel->hash;
+    }
+}
+
+// Call with the mutex held
+static esp_err_t save(void) {
+    channel_record_t records[MESHCORE_MAX_CHANNELS] = {0};
+    for (size_t i = 0; i < MESHCORE_MAX_CHANNELS; i++) {
+        const meshcore_channel_t* channel = &channels.channels[i];
+        if (channel->valid) {
+            memcpy(records[i].name, channel->name, sizeof(records[i].name));
+            memcpy(records[i].secret, channel->secret, channel->secret_length);
+            records[i].secret_length = channel->secret_length;
+        }
+    }
+    esp_err_t res = device_settings_set_meshcore_channels(records, sizeof(records));
+    if (res != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to store channels: %s", esp_err_to_name(res));
+    }
+    return res;
+}
+
+esp_err_t channel_manager_init(void) {
+    mutex = xSemaphoreCreateMutex();
+    if (mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    meshcore_channels_init(&channels);
+
+    channel_record_t records[MESHCORE_MAX_CHANNELS];
+    if (device_settings_get_meshcore_channels(records, sizeof(records)) == ESP_OK) {
+        for (size_t i = 0; i < MESHCORE_MAX_CHANNELS; i++) {
+            if (records[i].secret_length == 0) {
+                continue;
+            }
+            records[i].name[MESHCORE_CHANNEL_NAME_SIZE] = '\0';
+            if (meshcore_channels_add(&channels, records[i].name, records[i].secret, records[i].secret_length) ==
+                NULL) {
+                ESP_LOGW(TAG, "Ignoring stored channel %s", records[i].name);
+            }
+        }
+    }
+
+    if (channels.count == 0) {
+        meshcore_channels_add(&channels, CHANNEL_MANAGER_DEFAULT_NAME, default_secret, sizeof(default_secret));
+    }
+
+    ESP_LOGI(TAG, "%u channels", (unsigned int)channels.count);
+    return ESP_OK;
+}
+
+esp_err_t channel_manager_join(const char* name, const char* secret_hex, channel_info_t* out_info) {
+    if (name == NULL || name[0] == '\0' || strlen(name) > MESHCORE_CHANNEL_NAME_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t secret[MESHCORE_CHANNEL_MAX_SECRET_SIZE];
+    uint8_t secret_length = 0;
+    if (secret_hex == NULL) {
+        if (name[0] != '#') {
+            return ESP_ERR_INVALID_ARG;
+        }
+        secret_length = meshcore_channel_hashtag_secret(name, secret);
+    } else if (hex_to_bytes(secret_hex, secret, MESHCORE_CIPHER_KEY_SIZE)) {
+        secret_length = MESHCORE_CIPHER_KEY_SIZE;
+    } else if (hex_to_bytes(secret_hex, secret, MESHCORE_CHANNEL_MAX_SECRET_SIZE)) {
+        secret_length = MESHCORE_CHANNEL_MAX_SECRET_SIZE;
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    uint8_t             count   = channels.count;
+    meshcore_channel_t* channel = meshcore_channels_add(&channels, name, secret, secret_length);
+    esp_err_t           res     = ESP_ERR_NO_MEM;
+    if (channel != NULL) {
+        fill_info(channel, out_info);
+        res = channels.count != count ? save() : ESP_OK;
+    }
+    xSemaphoreGive(mutex);
+    return res;
+}
+
+esp_err_t channel_manager_leave(const char* name, channel_info_t* out_info) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    meshcore_channel_t* channel = meshcore_channels_find_by_name(&channels, name);
+    esp_err_t           res     = ESP_ERR_NOT_FOUND;
+    if (channel != NULL) {
+        fill_info(channel, out_info);
+        meshcore_channels_remove(&channels, channel);
+        res = save();
+    }
+    xSemaphoreGive(mutex);
+    return res;
+}
+
+size_t channel_manager_list(channel_info_t* out_info, size_t max_count) {
+    size_t count = 0;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (size_t i = 0; i < MESHCORE_MAX_CHANNELS && count < max_count; i++) {
+        if (channels.channels[i].valid) {
+            fill_info(&channels.channels[i], &out_info[count++]);
+        }
+    }
+    xSemaphoreGive(mutex);
+    return count;
+}
+
+bool channel_manager_get_name(const uint8_t* id, char* out_name, size_t max_length) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    meshcore_channel_t* channel = meshcore_channels_find_by_id(&channels, id);
+    if (channel != NULL) {
+        snprintf(out_name, max_length, "%s", channel->name);
+    }
+    xSemaphoreGive(mutex);
+    return channel != NULL;
+}
+
+bool channel_manager_decrypt(uint8_t hash, const uint8_t* mac, uint8_t* data, uint8_t length,
+                             channel_info_t* out_info) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    // Channels sharing the hash have their MACs calculated together
+    uint32_t            start   = perf_begin();
+    meshcore_channel_t* channel = meshcore_channels_find_by_mac(&channels, hash, mac, data, length);
+    perf_end(PERF_STAGE_MAC, start);
+    if (channel == NULL) {
+        MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_DEBUG, MESHCORE_TRACE_CRYPTO, "MAC mismatch (channel hash %02X)", hash);
+    } else {
+        start = perf_begin();
+        meshcore_key_decrypt(&channel->key, data, length);
+        perf_end(PERF_STAGE_DECRYPT, start);
+        fill_info(channel, out_info);
+    }
+    xSemaphoreGive(mutex);
+    return channel != NULL;
+}
+
+bool channel_manager_encrypt(const uint8_t* id, uint8_t* data, uint8_t length, size_t capacity, uint8_t* out_length,
+                             uint8_t* out_mac) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    meshcore_channel_t* channel = meshcore_channels_find_by_id(&channels, id);
+    bool                encrypted =
+        channel != NULL &&
+        meshcore_key_encrypt_then_mac(&channel->key, data, length, capacity, out_length, out_mac) == 0;
+    xSemaphoreGive(mutex);
+    return encrypted;
+}
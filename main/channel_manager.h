@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "meshcore/channels.h"
+
+#define CHANNEL_MANAGER_DEFAULT_NAME "Public"
+
+typedef struct {
+    char    name[MESHCORE_CHANNEL_NAME_SIZE + sizeof('\0')];
+    uint8_t id[MESHCORE_CHANNEL_ID_SIZE];  // Tells channels apart, several can share the hash
+    uint8_t hash;
+} channel_info_t;
+
+// Load the subscribed channels from NVS, the public channel is added when none were stored
+esp_err_t channel_manager_init(void);
+
+// Subscribe to a channel. Without a secret the name must be a #hashtag and the secret is derived from it, otherwise the
+// secret is given as 32 or 64 hex digits. The subscription is stored in NVS.
+esp_err_t channel_manager_join(const char* name, const char* secret_hex, channel_info_t* out_info);
+
+// Unsubscribe from a channel by name
+esp_err_t channel_manager_leave(const char* name, channel_info_t* out_info);
+
+// Copy the subscribed channels, returns the number copied
+size_t channel_manager_list(channel_info_t* out_info, size_t max_count);
+
+// Name of the channel with the id, false when there is none
+bool channel_manager_get_name(const uint8_t* id, char* out_name, size_t max_length);
+
+// Try the keys of all channels with the hash and decrypt the data in-place with the first one whose MAC matches, the
+// matching channel is copied to out_info (may be NULL). Returns false when no channel matched, the data is left
+// untouched then.
+bool channel_manager_decrypt(uint8_t hash, const uint8_t* mac, uint8_t* data, uint8_t length,
+                             channel_info_t* out_info);
+
+// Encrypt data in-place for the channel with the id and calculate its MAC, the channel hash is the first byte of the id
+bool channel_manager_encrypt(const uint8_t* id, uint8_t* data, uint8_t length, size_t capacity, uint8_t* out_length,
+                             uint8_t* out_mac);
@@ -0,0 +1,223 @@
+#include "chat_arena.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define RECORD_FLAG_SENT     0x01
+#define RECORD_FLAG_REPEATED 0x02
+#define RECORD_FLAG_DIRECT   0x04
+#define EVICT_MINIMUM        (CHAT_ARENA_SIZE / 8)  // Evict in chunks so the arena is not shifted on every append
+
+// Record header, followed by the text without terminator
+typedef struct __attribute__((packed)) {
+    uint8_t  text_length;
+    uint8_t  name_id;
+    uint8_t  flags;
+    uint8_t  channel_hash;
+    uint32_t timestamp;
+    uint32_t received_at;
+} record_header_t;
+
+static size_t record_size(const uint8_t* record) {
+    return sizeof(record_header_t) + ((const record_header_t*)record)->text_length;
+}
+
+static bool find_record(const chat_arena_t* arena, size_t index, size_t* out_offset) {
+    if (index >= arena->count) {
+        return false;
+    }
+    size_t offset = 0;
+    for (size_t i = 0; i < index; i++) {
+        offset += record_size(&arena->data[offset]);
+    }
+    *out_offset = offset;
+    return true;
+}
+
+static void name_release(chat_arena_t* arena, uint8_t id) {
+    if (id < CHAT_ARENA_MAX_NAMES && arena->names[id].references > 0) {
+        arena->names[id].references--;
+    }
+}
+
+// Drop unreferenced names and close the gaps they leave in the pool
+static void name_compact(chat_arena_t* arena) {
+    char   pool[CHAT_ARENA_NAME_POOL_SIZE];
+    size_t used = 0;
+    for (size_t i = 0; i < CHAT_ARENA_MAX_NAMES; i++) {
+        chat_arena_name_t* name = &arena->names[i];
+        if (name->references == 0) {
+            name->length = 0;
+            continue;
+        }
+        memcpy(&pool[used], &arena->name_pool[name->offset], name->length);
+        name->offset  = used;
+        used         += name->length;
+    }
+    memcpy(arena->name_pool, pool, used);
+    arena->name_pool_used = used;
+}
+
+static int find_name_slot(chat_arena_t* arena, size_t length) {
+    if (arena->name_pool_used + length > CHAT_ARENA_NAME_POOL_SIZE) {
+        return -1;
+    }
+    int unreferenced = -1;
+    for (size_t i = 0; i < CHAT_ARENA_MAX_NAMES; i++) {
+        if (arena->names[i].length == 0) {
+            return i;
+        }
+        if (arena->names[i].references == 0 && unreferenced < 0) {
+            unreferenced = i;
+        }
+    }
+    return unreferenced;
+}
+
+static uint8_t name_intern(chat_arena_t* arena, const char* name, size_t length) {
+    if (length == 0) {
+        return CHAT_ARENA_NO_NAME;
+    }
+
+    for (size_t i = 0; i < CHAT_ARENA_MAX_NAMES; i++) {
+        chat_arena_name_t* entry = &arena->names[i];
+        if (entry->length == length && memcmp(&arena->name_pool[entry->offset], name, length) == 0) {
+            entry->references++;
+            return i;
+        }
+    }
+
+    int slot = find_name_slot(arena, length);
+    if (slot < 0) {
+        name_compact(arena);
+        slot = find_name_slot(arena, length);
+        if (slot < 0) {
+            return CHAT_ARENA_NO_NAME;
+        }
+    }
+
+    chat_arena_name_t* entry = &arena->names[slot];
+    memcpy(&arena->name_pool[arena->name_pool_used], name, length);
+    entry->offset          = arena->name_pool_used;
+    entry->length          = length;
+    entry->references      = 1;
+    arena->name_pool_used += length;
+    return slot;
+}
+
+// Evict the oldest records until at least the requested amount of bytes has been freed
+static void evict(chat_arena_t* arena, size_t bytes) {
+    size_t freed   = 0;
+    size_t evicted = 0;
+    while (freed < bytes && evicted < arena->count) {
+        const record_header_t* header = (const record_header_t*)&arena->data[freed];
+        name_release(arena, header->name_id);
+        freed += record_size(&arena->data[freed]);
+        evicted++;
+    }
+    memmove(arena->data, &arena->data[freed], arena->used - freed);
+    arena->used     -= freed;
+    arena->count    -= evicted;
+    arena->first_id += evicted;
+}
+
+void chat_arena_init(chat_arena_t* arena) {
+    memset(arena, 0, sizeof(chat_arena_t));
+}
+
+void chat_arena_clear(chat_arena_t* arena) {
+    uint32_t next_id = arena->first_id + arena->count;
+    chat_arena_init(arena);
+    arena->first_id = next_id;
+}
+
+bool chat_arena_append(chat_arena_t* arena, const chat_message_t* message) {
+    size_t name_length = strnlen(message->name, CHAT_MESSAGE_NAME_SIZE - 1);
+    size_t text_length = strnlen(message->text, CHAT_MESSAGE_TEXT_SIZE - 1);
+    size_t length      = sizeof(record_header_t) + text_length;
+    if (length > CHAT_ARENA_SIZE) {
+        return false;
+    }
+
+    uint8_t name_id = name_intern(arena, message->name, name_length);
+    while (name_id == CHAT_ARENA_NO_NAME && name_length > 0 && arena->count > 0) {
+        // Name table is full of names that are still referenced, make room by dropping the oldest record
+        evict(arena, 1);
+        name_id = name_intern(arena, message->name, name_length);
+    }
+
+    if (arena->used + length > CHAT_ARENA_SIZE) {
+        size_t needed = arena->used + length - CHAT_ARENA_SIZE;
+        evict(arena, needed > EVICT_MINIMUM ? needed : EVICT_MINIMUM);
+    }
+
+    record_header_t header = {
+        .text_length  = text_length,
+        .name_id      = name_id,
+        .flags        = (message->sent ? RECORD_FLAG_SENT : 0) | (message->repeated ? RECORD_FLAG_REPEATED : 0) |
+                 (message->direct ? RECORD_FLAG_DIRECT : 0),
+        .channel_hash = message->channel_hash,
+        .timestamp    = message->timestamp,
+        .received_at  = message->received_at,
+    };
+    memcpy(&arena->data[arena->used], &header, sizeof(header));
+    memcpy(&arena->data[arena->used + sizeof(header)], message->text, text_length);
+    arena->used += length;
+    arena->count++;
+    return true;
+}
+
+size_t chat_arena_count(const chat_arena_t* arena) {
+    return arena->count;
+}
+
+bool chat_arena_get(const chat_arena_t* arena, size_t index, chat_arena_record_t* out_record) {
+    size_t offset;
+    if (!find_record(arena, index, &offset)) {
+        return false;
+    }
+
+    record_header_t header;
+    memcpy(&header, &arena->data[offset], sizeof(header));
+
+    if (header.name_id < CHAT_ARENA_MAX_NAMES) {
+        const chat_arena_name_t* name = &arena->names[header.name_id];
+        out_record->name              = &arena->name_pool[name->offset];
+        out_record->name_length       = name->length;
+    } else {
+        out_record->name        = "";
+        out_record->name_length = 0;
+    }
+    out_record->id           = arena->first_id + index;
+    out_record->text         = (const char*)&arena->data[offset + sizeof(header)];
+    out_record->text_length  = header.text_length;
+    out_record->channel_hash = header.channel_hash;
+    out_record->received_at  = header.received_at;
+    out_record->timestamp    = header.timestamp;
+    out_record->sent         = header.flags & RECORD_FLAG_SENT;
+    out_record->repeated     = header.flags & RECORD_FLAG_REPEATED;
+    out_record->direct       = header.flags & RECORD_FLAG_DIRECT;
+    return true;
+}
+
+void chat_arena_set_repeated(chat_arena_t* arena, size_t index) {
+    size_t offset;
+    if (find_record(arena, index, &offset)) {
+        ((record_header_t*)&arena->data[offset])->flags |= RECORD_FLAG_REPEATED;
+    }
+}
+
+void chat_arena_get_usage(const chat_arena_t* arena, chat_arena_usage_t* out_usage) {
+    memset(out_usage, 0, sizeof(chat_arena_usage_t));
+    out_usage->records          = arena->count;
+    out_usage->record_bytes     = arena->used;
+    out_usage->capacity         = CHAT_ARENA_SIZE;
+    out_usage->fixed_equivalent = arena->count * sizeof(chat_message_t);
+    for (size_t i = 0; i < CHAT_ARENA_MAX_NAMES; i++) {
+        if (arena->names[i].references > 0) {
+            out_usage->names++;
+            out_usage->name_bytes += arena->names[i].length;
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "message_store.h"
+
+#define CHAT_ARENA_SIZE           4096  // Bytes of record storage, the budget of 16 fixed size messages
+#define CHAT_ARENA_MAX_NAMES      64    // Distinct senders that can be interned at the same time
+#define CHAT_ARENA_NAME_POOL_SIZE 1024  // Bytes of interned sender names
+#define CHAT_ARENA_NO_NAME        0xFF  // Name id of records without a (known) sender name
+
+typedef struct {
+    uint16_t offset;      // Position in the name pool
+    uint8_t  length;      // Zero for an unused slot
+    uint16_t references;  // Records referring to this name
+} chat_arena_name_t;
+
+// Window of chat messages stored as length-prefixed records, oldest first. Sender names are interned in a separate
+// string table so repeated senders cost a single byte per message. Appending evicts the oldest records once full.
+typedef struct {
+    uint8_t           data[CHAT_ARENA_SIZE];
+    size_t            used;      // Bytes of data in use
+    size_t            count;     // Records in the arena
+    uint32_t          first_id;  // Id of the oldest record, ids increase by one per appended record
+    chat_arena_name_t names[CHAT_ARENA_MAX_NAMES];
+    char              name_pool[CHAT_ARENA_NAME_POOL_SIZE];
+    size_t            name_pool_used;
+} chat_arena_t;
+
+// View of a record, name and text point into the arena and are not null terminated
+typedef struct {
+    uint32_t    id;  // Unique for the lifetime of the arena, also across clears
+    const char* name;
+    uint8_t     name_length;
+    const char* text;
+    uint8_t     text_length;
+    uint8_t     channel_hash;
+    uint32_t    received_at;
+    uint32_t    timestamp;
+    bool        sent;
+    bool        repeated;
+    bool        direct;
+} chat_arena_record_t;
+
+typedef struct {
+    size_t records;           // Messages held
+    size_t record_bytes;      // Bytes used by message records
+    size_t capacity;          // Total record storage
+    size_t names;             // Interned sender names
+    size_t name_bytes;        // Bytes used by interned names
+    size_t fixed_equivalent;  // Bytes the same messages take as chat_message_t
+} chat_arena_usage_t;
+
+void chat_arena_init(chat_arena_t* arena);
+
+// Drop all records and names
+void chat_arena_clear(chat_arena_t* arena);
+
+// Append a message, evicting the oldest records when needed
+bool chat_arena_append(chat_arena_t* arena, const chat_message_t* message);
+
+// Number of records in the arena
+size_t chat_arena_count(const chat_arena_t* arena);
+
+// Get the record at the given index (oldest first), returns false when out of range
+bool chat_arena_get(const chat_arena_t* arena, size_t index, chat_arena_record_t* out_record);
+
+// Mark the record at the given index as repeated by others
+void chat_arena_set_repeated(chat_arena_t* arena, size_t index);
+
+void chat_arena_get_usage(const chat_arena_t* arena, chat_arena_usage_t* out_usage);
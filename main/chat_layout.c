@@ -0,0 +1,150 @@
+#include "chat_layout.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "pax_gfx.h"
+#include "pax_text.h"
+
+static int measure(chat_layout_cache_t* cache, const char* text, size_t length) {
+    char buffer[CHAT_MESSAGE_TEXT_SIZE];
+    if (length >= sizeof(buffer)) {
+        length = sizeof(buffer) - 1;
+    }
+    memcpy(buffer, text, length);
+    buffer[length] = '\0';
+    return (int)(pax_text_size(cache->font, cache->font_size, buffer).x + 0.5f);
+}
+
+// Longest run starting at text that fits the width, broken at a space when possible
+static size_t fit_line(chat_layout_cache_t* cache, const char* text, size_t length, int width, int* out_width) {
+    size_t end       = 0;
+    int    end_width = 0;
+
+    // Add words while they fit
+    while (end < length) {
+        size_t next = end;
+        while (next < length && text[next] == ' ') {
+            next++;
+        }
+        while (next < length && text[next] != ' ') {
+            next++;
+        }
+        int next_width = measure(cache, text, next);
+        if (next_width > width) {
+            break;
+        }
+        end       = next;
+        end_width = next_width;
+    }
+
+    if (end == 0 && length > 0) {
+        // A single word wider than the line, break it between characters
+        size_t low  = 1;
+        size_t high = length;
+        while (low < high) {
+            size_t middle = (low + high + 1) / 2;
+            if (measure(cache, text, middle) <= width) {
+                low = middle;
+            } else {
+                high = middle - 1;
+            }
+        }
+        end = low;
+        // Do not split UTF-8 sequences
+        while (end > 1 && end < length && (text[end] & 0xC0) == 0x80) {
+            end--;
+        }
+        end_width = measure(cache, text, end);
+    }
+
+    *out_width = end_width;
+    return end;
+}
+
+static void layout(chat_layout_cache_t* cache, const chat_arena_record_t* record, chat_layout_t* out_layout) {
+    char prefix[CHAT_LAYOUT_PREFIX_MAX];
+    chat_layout_prefix(record, prefix, sizeof(prefix));
+
+    memset(out_layout, 0, sizeof(chat_layout_t));
+    out_layout->id           = record->id;
+    out_layout->valid        = true;
+    out_layout->prefix_width = pax_text_size(cache->font, cache->font_size, prefix).x + 0.5f;
+    if (out_layout->prefix_width > cache->width / 2) {
+        // Keep room for text after very long names
+        out_layout->prefix_width = cache->width / 2;
+    }
+
+    size_t position = 0;
+    while (position < record->text_length && out_layout->line_count < CHAT_LAYOUT_MAX_LINES) {
+        if (out_layout->line_count > 0) {
+            while (position < record->text_length && record->text[position] == ' ') {
+                position++;
+            }
+        }
+        int    available = cache->width - (out_layout->line_count == 0 ? out_layout->prefix_width : 0);
+        int    width     = 0;
+        size_t length = fit_line(cache, &record->text[position], record->text_length - position, available, &width);
+        if (length == 0) {
+            break;
+        }
+        out_layout->line_start[out_layout->line_count]  = position;
+        out_layout->line_length[out_layout->line_count] = length;
+        out_layout->line_width[out_layout->line_count]  = width;
+        out_layout->line_count++;
+        position += length;
+    }
+
+    if (out_layout->line_count == 0) {
+        // Messages without text still show the sender
+        out_layout->line_count = 1;
+    }
+    out_layout->height = out_layout->line_count * cache->line_height;
+}
+
+void chat_layout_cache_init(chat_layout_cache_t* cache, const pax_font_t* font, float font_size, int width,
+                            int line_height) {
+    memset(cache, 0, sizeof(chat_layout_cache_t));
+    cache->font        = font;
+    cache->font_size   = font_size;
+    cache->width       = width;
+    cache->line_height = line_height;
+}
+
+void chat_layout_cache_clear(chat_layout_cache_t* cache) {
+    for (size_t i = 0; i < CHAT_LAYOUT_CACHE_SIZE; i++) {
+        cache->entries[i].valid = false;
+    }
+}
+
+const chat_layout_t* chat_layout_get(chat_layout_cache_t* cache, const chat_arena_record_t* record) {
+    for (size_t i = 0; i < CHAT_LAYOUT_CACHE_SIZE; i++) {
+        if (cache->entries[i].valid && cache->entries[i].id == record->id) {
+            cache->hits++;
+            return &cache->entries[i];
+        }
+    }
+
+    cache->misses++;
+    chat_layout_t* entry = &cache->entries[cache->next];
+    cache->next          = (cache->next + 1) % CHAT_LAYOUT_CACHE_SIZE;
+    layout(cache, record, entry);
+    return entry;
+}
+
+size_t chat_layout_prefix(const chat_arena_record_t* record, char* out_text, size_t max_length) {
+    const char* direct = record->direct ? "[DM] " : "";
+    size_t      length = 0;
+    if (max_length < strlen(direct) + record->name_length + 3) {
+        out_text[0] = '\0';
+        return 0;
+    }
+    memcpy(&out_text[length], direct, strlen(direct));
+    length += strlen(direct);
+    memcpy(&out_text[length], record->name, record->name_length);
+    length             += record->name_length;
+    out_text[length++]  = ':';
+    out_text[length++]  = ' ';
+    out_text[length]    = '\0';
+    return length;
+}
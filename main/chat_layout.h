@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "chat_arena.h"
+#include "pax_gfx.h"
+
+#define CHAT_LAYOUT_MAX_LINES  6                             // Lines a message wraps to, the rest is cut off
+#define CHAT_LAYOUT_CACHE_SIZE 32                            // Laid out messages kept, more than fit on screen
+#define CHAT_LAYOUT_PREFIX_MAX (CHAT_MESSAGE_NAME_SIZE + 8)  // "[DM] " + name + ": "
+
+// Wrapped layout of a message, the first line starts with the sender prefix and the text follows it
+typedef struct {
+    uint32_t id;  // Arena record id this layout belongs to
+    bool     valid;
+    uint16_t prefix_width;  // Width of the "[DM] name: " run on the first line
+    uint8_t  line_count;
+    uint8_t  line_start[CHAT_LAYOUT_MAX_LINES];   // Offset of each line in the message text
+    uint8_t  line_length[CHAT_LAYOUT_MAX_LINES];  // Length of each line in bytes
+    uint16_t line_width[CHAT_LAYOUT_MAX_LINES];   // Measured width of each line
+    uint16_t height;                              // Height of the wrapped message
+} chat_layout_t;
+
+typedef struct {
+    chat_layout_t     entries[CHAT_LAYOUT_CACHE_SIZE];
+    size_t            next;  // Entry replaced on the next miss
+    const pax_font_t* font;
+    float             font_size;
+    int               width;        // Available width in pixels
+    int               line_height;  // Height of a line in pixels
+    uint32_t          hits;
+    uint32_t          misses;
+} chat_layout_cache_t;
+
+void chat_layout_cache_init(chat_layout_cache_t* cache, const pax_font_t* font, float font_size, int width,
+                            int line_height);
+
+// Forget all layouts, needed when the font or width changes
+void chat_layout_cache_clear(chat_layout_cache_t* cache);
+
+// Layout of a record, measured and wrapped once and then served from the cache
+const chat_layout_t* chat_layout_get(chat_layout_cache_t* cache, const chat_arena_record_t* record);
+
+// Write the sender prefix of a record ("[DM] name: ") as a null terminated string
+size_t chat_layout_prefix(const chat_arena_record_t* record, char* out_text, size_t max_length);
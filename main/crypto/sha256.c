@@ -16,6 +16,17 @@
 #include "sha256.h"
 #include <memory.h>
 
+// Hardware SHA-256 rounds on hosts: SHA-NI is detected at runtime, the ARMv8 crypto extension when the compiler
+// targets it
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SHA256_SHA_NI 1
+#include <cpuid.h>
+#include <immintrin.h>
+#elif defined(__aarch64__) && (defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO))
+#define SHA256_ARMV8 1
+#include <arm_neon.h>
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //  MACROS
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -86,28 +97,32 @@ static const uint32_t K[64] = {
 #define Gamma0(x) (S(x, 7) ^ S(x, 18) ^ R(x, 3))
 #define Gamma1(x) (S(x, 17) ^ S(x, 19) ^ R(x, 10))
 
-#define Sha256Round(a, b, c, d, e, f, g, h, i)    \
-  t0 = h + Sigma1(e) + Ch(e, f, g) + K[i] + W[i]; \
-  t1 = Sigma0(a) + Maj(a, b, c);                  \
-  d += t0;                                        \
+// Rolling 16 word message schedule, W[i & 15] is replaced by word i
+#define Sha256Schedule(i) \
+  W[(i)&15] += Gamma1(W[((i)-2) & 15]) + W[((i)-7) & 15] + Gamma0(W[((i)-15) & 15]);
+
+#define Sha256Round(a, b, c, d, e, f, g, h, i)         \
+  t0 = h + Sigma1(e) + Ch(e, f, g) + K[i] + W[(i)&15]; \
+  t1 = Sigma0(a) + Maj(a, b, c);                       \
+  d += t0;                                             \
   h = t0 + t1;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-//  TransformFunction
+//  TransformGeneric
 //
-//  Compress 512-bits
+//  Compress 512-bits. The rounds are unrolled eight at a time so the state
+//  words change roles through the arguments instead of being moved.
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-static void TransformFunction(Sha256Context* Context, uint8_t const* Buffer) {
+static void TransformGeneric(uint32_t State[8], uint8_t const* Buffer) {
   uint32_t S[8];
-  uint32_t W[64];
+  uint32_t W[16];
   uint32_t t0;
   uint32_t t1;
-  uint32_t t;
   int i;
 
   // Copy state into S
   for (i = 0; i < 8; i++) {
-    S[i] = Context->state[i];
+    S[i] = State[i];
   }
 
   // Copy the state into 512-bits into W[0..15]
@@ -115,29 +130,198 @@ static void TransformFunction(Sha256Context* Context, uint8_t const* Buffer) {
     LOAD32H(W[i], Buffer + (4 * i));
   }
 
-  // Fill W[16..63]
-  for (i = 16; i < 64; i++) {
-    W[i] = Gamma1(W[i - 2]) + W[i - 7] + Gamma0(W[i - 15]) + W[i - 16];
+  // Compress, words 16..63 are calculated eight at a time just before they are used
+  for (i = 0; i < 64; i += 8) {
+    if (i >= 16) {
+      Sha256Schedule(i + 0);
+      Sha256Schedule(i + 1);
+      Sha256Schedule(i + 2);
+      Sha256Schedule(i + 3);
+      Sha256Schedule(i + 4);
+      Sha256Schedule(i + 5);
+      Sha256Schedule(i + 6);
+      Sha256Schedule(i + 7);
+    }
+    Sha256Round(S[0], S[1], S[2], S[3], S[4], S[5], S[6], S[7], i + 0);
+    Sha256Round(S[7], S[0], S[1], S[2], S[3], S[4], S[5], S[6], i + 1);
+    Sha256Round(S[6], S[7], S[0], S[1], S[2], S[3], S[4], S[5], i + 2);
+    Sha256Round(S[5], S[6], S[7], S[0], S[1], S[2], S[3], S[4], i + 3);
+    Sha256Round(S[4], S[5], S[6], S[7], S[0], S[1], S[2], S[3], i + 4);
+    Sha256Round(S[3], S[4], S[5], S[6], S[7], S[0], S[1], S[2], i + 5);
+    Sha256Round(S[2], S[3], S[4], S[5], S[6], S[7], S[0], S[1], i + 6);
+    Sha256Round(S[1], S[2], S[3], S[4], S[5], S[6], S[7], S[0], i + 7);
+  }
+
+  // Feedback
+  for (i = 0; i < 8; i++) {
+    State[i] = State[i] + S[i];
+  }
+}
+
+#if defined(SHA256_SHA_NI)
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  TransformShaNi
+//
+//  Compress 512-bits with the x86 SHA extensions. Every quad runs four
+//  rounds and, while the rounds are in flight, advances the message
+//  schedule of the next quads.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#define ShaNiQuad(q, current, previous, next)                                     \
+  message = _mm_add_epi32(current, _mm_loadu_si128((__m128i const*)&K[4 * (q)])); \
+  state1 = _mm_sha256rnds2_epu32(state1, state0, message);                        \
+  if ((q) >= 3 && (q) <= 14) {                                                    \
+    next = _mm_add_epi32(next, _mm_alignr_epi8(current, previous, 4));            \
+    next = _mm_sha256msg2_epu32(next, current);                                   \
+  }                                                                               \
+  message = _mm_shuffle_epi32(message, 0x0E);                                     \
+  state0 = _mm_sha256rnds2_epu32(state0, state1, message);                        \
+  if ((q) >= 1 && (q) <= 12) {                                                    \
+    previous = _mm_sha256msg1_epu32(previous, current);                           \
   }
 
-  // Compress
-  for (i = 0; i < 64; i++) {
-    Sha256Round(S[0], S[1], S[2], S[3], S[4], S[5], S[6], S[7], i);
-    t = S[7];
-    S[7] = S[6];
-    S[6] = S[5];
-    S[5] = S[4];
-    S[4] = S[3];
-    S[3] = S[2];
-    S[2] = S[1];
-    S[1] = S[0];
-    S[0] = t;
+__attribute__((target("sha,sse4.1"))) static void TransformShaNi(uint32_t State[8], uint8_t const* Buffer) {
+  const __m128i swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+  __m128i state0;
+  __m128i state1;
+  __m128i abef;
+  __m128i cdgh;
+  __m128i message;
+  __m128i message0;
+  __m128i message1;
+  __m128i message2;
+  __m128i message3;
+  __m128i t;
+
+  // The instructions keep the state as ABEF and CDGH
+  t = _mm_shuffle_epi32(_mm_loadu_si128((__m128i const*)&State[0]), 0xB1);
+  state1 = _mm_shuffle_epi32(_mm_loadu_si128((__m128i const*)&State[4]), 0x1B);
+  state0 = _mm_alignr_epi8(t, state1, 8);
+  state1 = _mm_blend_epi16(state1, t, 0xF0);
+  abef = state0;
+  cdgh = state1;
+
+  message0 = _mm_shuffle_epi8(_mm_loadu_si128((__m128i const*)(Buffer + 0)), swap);
+  message1 = _mm_shuffle_epi8(_mm_loadu_si128((__m128i const*)(Buffer + 16)), swap);
+  message2 = _mm_shuffle_epi8(_mm_loadu_si128((__m128i const*)(Buffer + 32)), swap);
+  message3 = _mm_shuffle_epi8(_mm_loadu_si128((__m128i const*)(Buffer + 48)), swap);
+
+  ShaNiQuad(0, message0, message3, message1);
+  ShaNiQuad(1, message1, message0, message2);
+  ShaNiQuad(2, message2, message1, message3);
+  ShaNiQuad(3, message3, message2, message0);
+  ShaNiQuad(4, message0, message3, message1);
+  ShaNiQuad(5, message1, message0, message2);
+  ShaNiQuad(6, message2, message1, message3);
+  ShaNiQuad(7, message3, message2, message0);
+  ShaNiQuad(8, message0, message3, message1);
+  ShaNiQuad(9, message1, message0, message2);
+  ShaNiQuad(10, message2, message1, message3);
+  ShaNiQuad(11, message3, message2, message0);
+  ShaNiQuad(12, message0, message3, message1);
+  ShaNiQuad(13, message1, message0, message2);
+  ShaNiQuad(14, message2, message1, message3);
+  ShaNiQuad(15, message3, message2, message0);
+
+  // Feedback, and back to ABCD and EFGH
+  state0 = _mm_add_epi32(state0, abef);
+  state1 = _mm_add_epi32(state1, cdgh);
+  t = _mm_shuffle_epi32(state0, 0x1B);
+  state1 = _mm_shuffle_epi32(state1, 0xB1);
+  _mm_storeu_si128((__m128i*)&State[0], _mm_blend_epi16(t, state1, 0xF0));
+  _mm_storeu_si128((__m128i*)&State[4], _mm_alignr_epi8(state1, t, 8));
+}
+
+static bool Accelerated(void) {
+  static int supported = -1;
+  unsigned int eax;
+  unsigned int ebx;
+  unsigned int ecx;
+  unsigned int edx;
+
+  if (supported < 0) {
+    // SHA (leaf 7 EBX bit 29), SSSE3 and SSE4.1 (leaf 1 ECX bits 9 and 19)
+    supported = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & (1u << 9)) && (ecx & (1u << 19)) &&
+                __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & (1u << 29));
   }
+  return supported;
+}
+
+#elif defined(SHA256_ARMV8)
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  TransformArmv8
+//
+//  Compress 512-bits with the ARMv8 crypto extension. Every quad runs four
+//  rounds and replaces its message words with the ones four quads later.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#define Armv8Quad(q, current, next1, next2, next3)                            \
+  message = vaddq_u32(current, vld1q_u32(&K[4 * (q)]));                       \
+  if ((q) < 12) {                                                             \
+    current = vsha256su1q_u32(vsha256su0q_u32(current, next1), next2, next3); \
+  }                                                                           \
+  abcd = state0;                                                              \
+  state0 = vsha256hq_u32(state0, state1, message);                            \
+  state1 = vsha256h2q_u32(state1, abcd, message);
+
+static void TransformArmv8(uint32_t State[8], uint8_t const* Buffer) {
+  uint32x4_t state0 = vld1q_u32(&State[0]);
+  uint32x4_t state1 = vld1q_u32(&State[4]);
+  uint32x4_t abcd;
+  uint32x4_t message;
+  uint32x4_t message0 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(Buffer + 0)));
+  uint32x4_t message1 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(Buffer + 16)));
+  uint32x4_t message2 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(Buffer + 32)));
+  uint32x4_t message3 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(Buffer + 48)));
+
+  Armv8Quad(0, message0, message1, message2, message3);
+  Armv8Quad(1, message1, message2, message3, message0);
+  Armv8Quad(2, message2, message3, message0, message1);
+  Armv8Quad(3, message3, message0, message1, message2);
+  Armv8Quad(4, message0, message1, message2, message3);
+  Armv8Quad(5, message1, message2, message3, message0);
+  Armv8Quad(6, message2, message3, message0, message1);
+  Armv8Quad(7, message3, message0, message1, message2);
+  Armv8Quad(8, message0, message1, message2, message3);
+  Armv8Quad(9, message1, message2, message3, message0);
+  Armv8Quad(10, message2, message3, message0, message1);
+  Armv8Quad(11, message3, message0, message1, message2);
+  Armv8Quad(12, message0, message1, message2, message3);
+  Armv8Quad(13, message1, message2, message3, message0);
+  Armv8Quad(14, message2, message3, message0, message1);
+  Armv8Quad(15, message3, message0, message1, message2);
 
   // Feedback
-  for (i = 0; i < 8; i++) {
-    Context->state[i] = Context->state[i] + S[i];
+  vst1q_u32(&State[0], vaddq_u32(state0, vld1q_u32(&State[0])));
+  vst1q_u32(&State[4], vaddq_u32(state1, vld1q_u32(&State[4])));
+}
+
+static bool Accelerated(void) {
+  return true;
+}
+
+#endif
+
+static bool use_accelerated = true;  // Cleared by Sha256SetAccelerated to compare with the generic code
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  TransformFunction
+//
+//  Compress 512-bits
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void TransformFunction(Sha256Context* Context, uint8_t const* Buffer) {
+#if defined(SHA256_SHA_NI)
+  if (use_accelerated && Accelerated()) {
+    TransformShaNi(Context->state, Buffer);
+    return;
   }
+#elif defined(SHA256_ARMV8)
+  if (use_accelerated) {
+    TransformArmv8(Context->state, Buffer);
+    return;
+  }
+#endif
+  TransformGeneric(Context->state, Buffer);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -265,3 +449,28 @@ void Sha256Calculate(void const* Buffer,   // [in]
   Sha256Update(&context, Buffer, BufferSize);
   Sha256Finalise(&context, Digest);
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Sha256IsAccelerated
+//
+//  Returns whether the compression uses hardware SHA256 instructions.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool Sha256IsAccelerated(void) {
+#if defined(SHA256_SHA_NI) || defined(SHA256_ARMV8)
+  return use_accelerated && Accelerated();
+#else
+  return false;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Sha256SetAccelerated
+//
+//  Enables or disables the hardware SHA256 instructions. Returns whether
+//  they are used afterwards.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool Sha256SetAccelerated(bool Enabled  // [in]
+) {
+  use_accelerated = Enabled;
+  return Sha256IsAccelerated();
+}
@@ -15,6 +15,7 @@
 //  IMPORTS
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 
@@ -76,3 +77,22 @@ void Sha256Calculate(void const* Buffer,   // [in]
                      uint32_t BufferSize,  // [in]
                      SHA256_HASH* Digest   // [in]
 );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Sha256IsAccelerated
+//
+//  Returns whether the compression uses hardware SHA256 instructions.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool Sha256IsAccelerated(void);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Sha256SetAccelerated
+//
+//  Enables or disables the hardware SHA256 instructions: SHA-NI on x86-64
+//  when the CPU has them, the ARMv8 crypto extension when compiled for it.
+//  They are enabled by default, disabling them is meant for benchmarks and
+//  tests of the generic code. Returns whether they are used afterwards.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool Sha256SetAccelerated(bool Enabled  // [in]
+);
+
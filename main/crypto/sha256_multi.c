@@ -0,0 +1,397 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Sha256Multi
+//
+//  Multi-buffer SHA256, see sha256_multi.h. Public domain like sha256.c.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  IMPORTS
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "sha256_multi.h"
+#include <memory.h>
+#include "sha256.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SHA256_MULTI_X86 1
+#define SHA256_MULTI_SIMD 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define SHA256_MULTI_NEON 1
+#define SHA256_MULTI_SIMD 1
+#include <arm_neon.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  MACROS
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+#define MAX(x, y) (((x) > (y)) ? (x) : (y))
+
+#define STORE32H(x, y)                     \
+  {                                        \
+    (y)[0] = (uint8_t)(((x) >> 24) & 255); \
+    (y)[1] = (uint8_t)(((x) >> 16) & 255); \
+    (y)[2] = (uint8_t)(((x) >> 8) & 255);  \
+    (y)[3] = (uint8_t)((x)&255);           \
+  }
+
+#define LOAD32H(x, y)                                                         \
+  {                                                                           \
+    x = ((uint32_t)((y)[0] & 255) << 24) | ((uint32_t)((y)[1] & 255) << 16) | \
+        ((uint32_t)((y)[2] & 255) << 8) | ((uint32_t)((y)[3] & 255));         \
+  }
+
+#define STORE64H(x, y)                     \
+  {                                        \
+    (y)[0] = (uint8_t)(((x) >> 56) & 255); \
+    (y)[1] = (uint8_t)(((x) >> 48) & 255); \
+    (y)[2] = (uint8_t)(((x) >> 40) & 255); \
+    (y)[3] = (uint8_t)(((x) >> 32) & 255); \
+    (y)[4] = (uint8_t)(((x) >> 24) & 255); \
+    (y)[5] = (uint8_t)(((x) >> 16) & 255); \
+    (y)[6] = (uint8_t)(((x) >> 8) & 255);  \
+    (y)[7] = (uint8_t)((x)&255);           \
+  }
+
+#define BLOCK_SIZE 64
+
+// Bytes a message grows by at least when padded: the '1' bit and the 64 bit length
+#define PADDING_SIZE 9
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  TYPES
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef void (*LanesFunction)(uint32_t State[8][SHA256_MULTI_MAX_LANES], uint8_t const* const Blocks[]);
+
+// The rest of a message: the bytes buffered in the context, the buffer and the padding
+typedef struct {
+  Sha256Context const* context;
+  uint8_t const* buffer;
+  uint32_t size;
+  uint32_t blocks;  // Blocks including the padding
+  uint64_t bits;    // Length of the whole message
+} Stream;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  CONSTANTS
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(SHA256_MULTI_SIMD)
+
+static const uint32_t K[64] = {
+    0x428a2f98UL, 0x71374491UL, 0xb5c0fbcfUL, 0xe9b5dba5UL, 0x3956c25bUL,
+    0x59f111f1UL, 0x923f82a4UL, 0xab1c5ed5UL, 0xd807aa98UL, 0x12835b01UL,
+    0x243185beUL, 0x550c7dc3UL, 0x72be5d74UL, 0x80deb1feUL, 0x9bdc06a7UL,
+    0xc19bf174UL, 0xe49b69c1UL, 0xefbe4786UL, 0x0fc19dc6UL, 0x240ca1ccUL,
+    0x2de92c6fUL, 0x4a7484aaUL, 0x5cb0a9dcUL, 0x76f988daUL, 0x983e5152UL,
+    0xa831c66dUL, 0xb00327c8UL, 0xbf597fc7UL, 0xc6e00bf3UL, 0xd5a79147UL,
+    0x06ca6351UL, 0x14292967UL, 0x27b70a85UL, 0x2e1b2138UL, 0x4d2c6dfcUL,
+    0x53380d13UL, 0x650a7354UL, 0x766a0abbUL, 0x81c2c92eUL, 0x92722c85UL,
+    0xa2bfe8a1UL, 0xa81a664bUL, 0xc24b8b70UL, 0xc76c51a3UL, 0xd192e819UL,
+    0xd6990624UL, 0xf40e3585UL, 0x106aa070UL, 0x19a4c116UL, 0x1e376c08UL,
+    0x2748774cUL, 0x34b0bcb5UL, 0x391c0cb3UL, 0x4ed8aa4aUL, 0x5b9cca4fUL,
+    0x682e6ff3UL, 0x748f82eeUL, 0x78a5636fUL, 0x84c87814UL, 0x8cc70208UL,
+    0x90befffaUL, 0xa4506cebUL, 0xbef9a3f7UL, 0xc67178f2UL};
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  LANE TRANSFORMS
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(SHA256_MULTI_X86)
+
+// SSE2 is part of x86-64, 4 lanes
+#define LANES_NAME TransformSse2
+#define LANES_COUNT 4
+#define LANES_TARGET
+#define vec_t __m128i
+#define V_LOAD(p) _mm_loadu_si128((__m128i const*)(p))
+#define V_STORE(p, x) _mm_storeu_si128((__m128i*)(p), x)
+#define V_SET1(x) _mm_set1_epi32((int)(x))
+#define V_ADD(x, y) _mm_add_epi32(x, y)
+#define V_XOR(x, y) _mm_xor_si128(x, y)
+#define V_AND(x, y) _mm_and_si128(x, y)
+#define V_ANDNOT(x, y) _mm_andnot_si128(x, y)
+#define V_OR(x, y) _mm_or_si128(x, y)
+#define V_SHR(x, n) _mm_srli_epi32(x, n)
+#define V_SHL(x, n) _mm_slli_epi32(x, n)
+#include "sha256_multi_lanes.h"
+#undef LANES_NAME
+#undef LANES_COUNT
+#undef LANES_TARGET
+#undef vec_t
+#undef V_LOAD
+#undef V_STORE
+#undef V_SET1
+#undef V_ADD
+#undef V_XOR
+#undef V_AND
+#undef V_ANDNOT
+#undef V_OR
+#undef V_SHR
+#undef V_SHL
+
+// AVX2 is compiled in and selected at runtime when the CPU has it, 8 lanes
+#define LANES_NAME TransformAvx2
+#define LANES_COUNT 8
+#define LANES_TARGET __attribute__((target("avx2")))
+#define vec_t __m256i
+#define V_LOAD(p) _mm256_loadu_si256((__m256i const*)(p))
+#define V_STORE(p, x) _mm256_storeu_si256((__m256i*)(p), x)
+#define V_SET1(x) _mm256_set1_epi32((int)(x))
+#define V_ADD(x, y) _mm256_add_epi32(x, y)
+#define V_XOR(x, y) _mm256_xor_si256(x, y)
+#define V_AND(x, y) _mm256_and_si256(x, y)
+#define V_ANDNOT(x, y) _mm256_andnot_si256(x, y)
+#define V_OR(x, y) _mm256_or_si256(x, y)
+#define V_SHR(x, n) _mm256_srli_epi32(x, n)
+#define V_SHL(x, n) _mm256_slli_epi32(x, n)
+#include "sha256_multi_lanes.h"
+#undef LANES_NAME
+#undef LANES_COUNT
+#undef LANES_TARGET
+#undef vec_t
+#undef V_LOAD
+#undef V_STORE
+#undef V_SET1
+#undef V_ADD
+#undef V_XOR
+#undef V_AND
+#undef V_ANDNOT
+#undef V_OR
+#undef V_SHR
+#undef V_SHL
+
+#elif defined(SHA256_MULTI_NEON)
+
+// NEON, 4 lanes
+#define LANES_NAME TransformNeon
+#define LANES_COUNT 4
+#define LANES_TARGET
+#define vec_t uint32x4_t
+#define V_LOAD(p) vld1q_u32(p)
+#define V_STORE(p, x) vst1q_u32(p, x)
+#define V_SET1(x) vdupq_n_u32(x)
+#define V_ADD(x, y) vaddq_u32(x, y)
+#define V_XOR(x, y) veorq_u32(x, y)
+#define V_AND(x, y) vandq_u32(x, y)
+#define V_ANDNOT(x, y) vbicq_u32(y, x)
+#define V_OR(x, y) vorrq_u32(x, y)
+#define V_SHR(x, n) vshrq_n_u32(x, n)
+#define V_SHL(x, n) vshlq_n_u32(x, n)
+#include "sha256_multi_lanes.h"
+#undef LANES_NAME
+#undef LANES_COUNT
+#undef LANES_TARGET
+#undef vec_t
+#undef V_LOAD
+#undef V_STORE
+#undef V_SET1
+#undef V_ADD
+#undef V_XOR
+#undef V_AND
+#undef V_ANDNOT
+#undef V_OR
+#undef V_SHR
+#undef V_SHL
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  INTERNAL FUNCTIONS
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t lanes = 0;  // 0 until the implementation is selected
+static LanesFunction transform = NULL;
+
+static void SelectDefault(void) {
+  if (lanes != 0) {
+    return;
+  }
+  // Hardware SHA256 instructions hash one message faster than the lanes hash several
+  if (Sha256IsAccelerated() || (!Sha256MultiSetLanes(8) && !Sha256MultiSetLanes(4))) {
+    Sha256MultiSetLanes(1);
+  }
+}
+
+#if defined(SHA256_MULTI_SIMD)
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  StreamBlock
+//
+//  Returns block Index of a stream. Blocks that lie entirely inside the
+//  buffer are used in place, others are assembled in Scratch.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static uint8_t const* StreamBlock(Stream const* Message, uint32_t Index, uint8_t* Scratch) {
+  uint32_t curlen = Message->context->curlen;
+  uint32_t total = curlen + Message->size;
+  uint32_t offset = Index * BLOCK_SIZE;
+  uint32_t low;
+  uint32_t high;
+
+  if (offset >= curlen && offset + BLOCK_SIZE <= total) {
+    return Message->buffer + (offset - curlen);
+  }
+
+  memset(Scratch, 0, BLOCK_SIZE);
+
+  // Bytes that were buffered in the context
+  if (offset < curlen) {
+    memcpy(Scratch, Message->context->buf + offset, curlen - offset);
+  }
+
+  // Bytes from the buffer
+  low = MAX(offset, curlen);
+  high = MIN(offset + BLOCK_SIZE, total);
+  if (low < high) {
+    memcpy(Scratch + (low - offset), Message->buffer + (low - curlen), high - low);
+  }
+
+  // Append the '1' bit, and the length to the last block
+  if (total >= offset && total < offset + BLOCK_SIZE) {
+    Scratch[total - offset] = (uint8_t)0x80;
+  }
+  if (Index == Message->blocks - 1) {
+    STORE64H(Message->bits, Scratch + 56);
+  }
+
+  return Scratch;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  FinaliseLanes
+//
+//  Finalises up to one context per lane in lockstep. Lanes whose message is
+//  shorter than the longest one hash a dummy block once they are done.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void FinaliseLanes(Sha256Context* const Contexts[], void const* const Buffers[], uint32_t const BufferSizes[],
+                          SHA256_HASH Digests[], uint32_t Count) {
+  uint32_t state[8][SHA256_MULTI_MAX_LANES] = {{0}};
+  uint8_t scratch[SHA256_MULTI_MAX_LANES][BLOCK_SIZE] = {{0}};
+  uint8_t const* blocks[SHA256_MULTI_MAX_LANES];
+  Stream streams[SHA256_MULTI_MAX_LANES];
+  uint32_t block_count = 0;
+  uint32_t lane;
+  uint32_t index;
+  int i;
+
+  for (lane = 0; lane < lanes; lane++) {
+    blocks[lane] = scratch[lane];
+  }
+
+  for (lane = 0; lane < Count; lane++) {
+    Stream* stream = &streams[lane];
+    uint32_t total = Contexts[lane]->curlen + BufferSizes[lane];
+    stream->context = Contexts[lane];
+    stream->buffer = (uint8_t const*)Buffers[lane];
+    stream->size = BufferSizes[lane];
+    stream->blocks = (total + PADDING_SIZE + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    stream->bits = Contexts[lane]->length + (uint64_t)total * 8;
+    block_count = MAX(block_count, stream->blocks);
+    for (i = 0; i < 8; i++) {
+      state[i][lane] = Contexts[lane]->state[i];
+    }
+  }
+
+  for (index = 0; index < block_count; index++) {
+    for (lane = 0; lane < Count; lane++) {
+      if (index < streams[lane].blocks) {
+        blocks[lane] = StreamBlock(&streams[lane], index, scratch[lane]);
+      }
+    }
+
+    transform(state, blocks);
+
+    for (lane = 0; lane < Count; lane++) {
+      if (index == streams[lane].blocks - 1) {
+        for (i = 0; i < 8; i++) {
+          STORE32H(state[i][lane], Digests[lane].bytes + (4 * i));
+        }
+      }
+    }
+  }
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  PUBLIC FUNCTIONS
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Sha256MultiLanes
+//
+//  Returns the number of messages hashed in lockstep, 1 when no SIMD
+//  implementation is available or the CPU has SHA256 instructions.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+uint32_t Sha256MultiLanes(void) {
+  SelectDefault();
+  return lanes;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Sha256MultiSetLanes
+//
+//  Selects the implementation with the given number of lanes, 1 selects the
+//  sequential fallback. Returns false when the CPU does not support it.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool Sha256MultiSetLanes(uint32_t Lanes  // [in]
+) {
+  LanesFunction function = NULL;
+
+#if defined(SHA256_MULTI_X86)
+  if (Lanes == 8 && __builtin_cpu_supports("avx2")) {
+    function = TransformAvx2;
+  } else if (Lanes == 4) {
+    function = TransformSse2;
+  }
+#elif defined(SHA256_MULTI_NEON)
+  if (Lanes == 4) {
+    function = TransformNeon;
+  }
+#endif
+
+  if (function == NULL && Lanes != 1) {
+    return false;
+  }
+
+  transform = function;
+  lanes = Lanes;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Sha256MultiFinalise
+//
+//  Adds Buffers[i] to Contexts[i] and finalises it into Digests[i], for Count
+//  contexts.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void Sha256MultiFinalise(Sha256Context* const Contexts[],  // [in out]
+                         void const* const Buffers[],      // [in]
+                         uint32_t const BufferSizes[],     // [in]
+                         SHA256_HASH Digests[],            // [out]
+                         uint32_t Count                    // [in]
+) {
+  uint32_t i;
+
+  SelectDefault();
+
+#if defined(SHA256_MULTI_SIMD)
+  // A single message gains nothing from the lanes
+  if (transform != NULL && Count > 1) {
+    for (i = 0; i < Count; i += lanes) {
+      FinaliseLanes(&Contexts[i], &Buffers[i], &BufferSizes[i], &Digests[i], MIN(lanes, Count - i));
+    }
+    return;
+  }
+#endif
+
+  for (i = 0; i < Count; i++) {
+    Sha256Update(Contexts[i], Buffers[i], BufferSizes[i]);
+    Sha256Finalise(Contexts[i], &Digests[i]);
+  }
+}
@@ -0,0 +1,60 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Sha256Multi
+//
+//  Multi-buffer SHA256: finalises several independent SHA256 contexts in
+//  lockstep, one message per SIMD lane. Uses AVX2 (8 lanes) or SSE2 (4 lanes)
+//  on x86-64 and NEON (4 lanes) on ARM. Other targets, including the ESP32
+//  family, and CPUs with SHA256 instructions finalise the contexts one after
+//  the other.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  IMPORTS
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sha256.h"
+
+#define SHA256_MULTI_MAX_LANES 8
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  PUBLIC FUNCTIONS
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Sha256MultiLanes
+//
+//  Returns the number of messages hashed in lockstep, 1 when no SIMD
+//  implementation is available or the CPU has SHA256 instructions.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+uint32_t Sha256MultiLanes(void);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Sha256MultiSetLanes
+//
+//  Selects the implementation with the given number of lanes, 1 selects the
+//  sequential fallback. Returns false when the CPU does not support it. By
+//  default the widest supported implementation is used, or the sequential
+//  one when the CPU has SHA256 instructions. This is meant for benchmarks.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool Sha256MultiSetLanes(uint32_t Lanes  // [in]
+);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Sha256MultiFinalise
+//
+//  Adds Buffers[i] to Contexts[i] and finalises it into Digests[i], for Count
+//  contexts. The result is the same as calling Sha256Update and
+//  Sha256Finalise on each context. Messages that need the same number of
+//  blocks make the best use of the lanes. The contexts must be initialised
+//  again before they are reused.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void Sha256MultiFinalise(Sha256Context* const Contexts[],  // [in out]
+                         void const* const Buffers[],      // [in]
+                         uint32_t const BufferSizes[],     // [in]
+                         SHA256_HASH Digests[],            // [out]
+                         uint32_t Count                    // [in]
+);
@@ -0,0 +1,100 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Sha256Multi lane transform
+//
+//  Compresses one block per lane. Included by sha256_multi.c once per
+//  instruction set, with these defined:
+//
+//    LANES_NAME    name of the transform function
+//    LANES_COUNT   lanes per vector
+//    LANES_TARGET  function attribute enabling the instruction set, may be empty
+//    vec_t         vector of LANES_COUNT uint32_t, with the V_* operations below
+//
+//  The state is kept transposed: State[word][lane].
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#define V_ROR(x, n) V_OR(V_SHR(x, n), V_SHL(x, 32 - (n)))
+#define V_CH(x, y, z) V_XOR(V_AND(x, y), V_ANDNOT(x, z))
+#define V_MAJ(x, y, z) V_OR(V_AND(x, y), V_AND(z, V_OR(x, y)))
+#define V_SIGMA0(x) V_XOR(V_XOR(V_ROR(x, 2), V_ROR(x, 13)), V_ROR(x, 22))
+#define V_SIGMA1(x) V_XOR(V_XOR(V_ROR(x, 6), V_ROR(x, 11)), V_ROR(x, 25))
+#define V_GAMMA0(x) V_XOR(V_XOR(V_ROR(x, 7), V_ROR(x, 18)), V_SHR(x, 3))
+#define V_GAMMA1(x) V_XOR(V_XOR(V_ROR(x, 17), V_ROR(x, 19)), V_SHR(x, 10))
+
+// Rolling 16 word message schedule, W[i & 15] is replaced by word i
+#define V_SCHEDULE(i)                                                  \
+  W[(i)&15] = V_ADD(V_ADD(V_GAMMA1(W[((i)-2) & 15]), W[((i)-7) & 15]), \
+                    V_ADD(V_GAMMA0(W[((i)-15) & 15]), W[(i)&15]));
+
+#define V_ROUND(a, b, c, d, e, f, g, h, i)                                                 \
+  t0 = V_ADD(V_ADD(V_ADD(h, V_SIGMA1(e)), V_CH(e, f, g)), V_ADD(V_SET1(K[i]), W[(i)&15])); \
+  t1 = V_ADD(V_SIGMA0(a), V_MAJ(a, b, c));                                                 \
+  d = V_ADD(d, t0);                                                                        \
+  h = V_ADD(t0, t1);
+
+static LANES_TARGET void LANES_NAME(uint32_t State[8][SHA256_MULTI_MAX_LANES], uint8_t const* const Blocks[]) {
+  uint32_t words[LANES_COUNT];
+  vec_t W[16];
+  vec_t a, b, c, d, e, f, g, h;
+  vec_t t0, t1;
+  int i;
+  int lane;
+
+  // Gather word i of every lane into one vector
+  for (i = 0; i < 16; i++) {
+    for (lane = 0; lane < LANES_COUNT; lane++) {
+      LOAD32H(words[lane], Blocks[lane] + (4 * i));
+    }
+    W[i] = V_LOAD(words);
+  }
+
+  a = V_LOAD(State[0]);
+  b = V_LOAD(State[1]);
+  c = V_LOAD(State[2]);
+  d = V_LOAD(State[3]);
+  e = V_LOAD(State[4]);
+  f = V_LOAD(State[5]);
+  g = V_LOAD(State[6]);
+  h = V_LOAD(State[7]);
+
+  // Eight rounds per iteration rotate the roles of the state words back to where they started
+  for (i = 0; i < 64; i += 8) {
+    if (i >= 16) {
+      V_SCHEDULE(i + 0);
+      V_SCHEDULE(i + 1);
+      V_SCHEDULE(i + 2);
+      V_SCHEDULE(i + 3);
+      V_SCHEDULE(i + 4);
+      V_SCHEDULE(i + 5);
+      V_SCHEDULE(i + 6);
+      V_SCHEDULE(i + 7);
+    }
+    V_ROUND(a, b, c, d, e, f, g, h, i + 0);
+    V_ROUND(h, a, b, c, d, e, f, g, i + 1);
+    V_ROUND(g, h, a, b, c, d, e, f, i + 2);
+    V_ROUND(f, g, h, a, b, c, d, e, i + 3);
+    V_ROUND(e, f, g, h, a, b, c, d, i + 4);
+    V_ROUND(d, e, f, g, h, a, b, c, i + 5);
+    V_ROUND(c, d, e, f, g, h, a, b, i + 6);
+    V_ROUND(b, c, d, e, f, g, h, a, i + 7);
+  }
+
+  // Feedback
+  V_STORE(State[0], V_ADD(V_LOAD(State[0]), a));
+  V_STORE(State[1], V_ADD(V_LOAD(State[1]), b));
+  V_STORE(State[2], V_ADD(V_LOAD(State[2]), c));
+  V_STORE(State[3], V_ADD(V_LOAD(State[3]), d));
+  V_STORE(State[4], V_ADD(V_LOAD(State[4]), e));
+  V_STORE(State[5], V_ADD(V_LOAD(State[5]), f));
+  V_STORE(State[6], V_ADD(V_LOAD(State[6]), g));
+  V_STORE(State[7], V_ADD(V_LOAD(State[7]), h));
+}
+
+#undef V_ROR
+#undef V_CH
+#undef V_MAJ
+#undef V_SIGMA0
+#undef V_SIGMA1
+#undef V_GAMMA0
+#undef V_GAMMA1
+#undef V_SCHEDULE
+#undef V_ROUND
@@ -224,6 +224,45 @@ static esp_err_t device_settings_set_string(const char* key, const char* value)
     return res;
 }
 
+static esp_err_t device_settings_get_blob(const char* key, void* out_value, size_t length) {
+    if (key == NULL || out_value == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    nvs_handle_t nvs_handle;
+    esp_err_t    res = nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
+    if (res != ESP_OK) {
+        return res;
+    }
+    size_t size = 0;
+    res         = nvs_get_blob(nvs_handle, key, NULL, &size);
+    if (res != ESP_OK || size != length) {
+        nvs_close(nvs_handle);
+        return (res != ESP_OK) ? res : ESP_ERR_INVALID_SIZE;
+    }
+    res = nvs_get_blob(nvs_handle, key, out_value, &size);
+    nvs_close(nvs_handle);
+    return res;
+}
+
+static esp_err_t device_settings_set_blob(const char* key, const void* value, size_t length) {
+    if (key == NULL || value == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    nvs_handle_t nvs_handle;
+    esp_err_t    res = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (res != ESP_OK) {
+        return res;
+    }
+    res = nvs_set_blob(nvs_handle, key, value, length);
+    if (res != ESP_OK) {
+        nvs_close(nvs_handle);
+        return res;
+    }
+    res = nvs_commit(nvs_handle);
+    nvs_close(nvs_handle);
+    return res;
+}
+
 esp_err_t device_settings_get_display_brightness(uint8_t* out_percentage) {
     return device_settings_get_percentage("disp.brightness", 100, 3, out_percentage);
 }
@@ -405,3 +444,27 @@ esp_err_t device_settings_get_meshcore_public_key(char* out_value, size_t max_le
 esp_err_t device_settings_set_meshcore_public_key(const char* value) {
     return device_settings_set_string("mc.public_key", value);
 }
+
+esp_err_t device_settings_get_meshcore_identity(uint8_t* out_private_key, size_t length) {
+    return device_settings_get_blob("mc.identity", out_private_key, length);
+}
+
+esp_err_t device_settings_set_meshcore_identity(const uint8_t* private_key, size_t length) {
+    return device_settings_set_blob("mc.identity", private_key, length);
+}
+
+esp_err_t device_settings_get_meshcore_channels(void* out_value, size_t length) {
+    return device_settings_get_blob("mc.channels", out_value, length);
+}
+
+esp_err_t device_settings_set_meshcore_channels(const void* value, size_t length) {
+    return device_settings_set_blob("mc.channels", value, length);
+}
+
+esp_err_t device_settings_get_meshcore_regions(void* out_value, size_t length) {
+    return device_settings_get_blob("mc.regions", out_value, length);
+}
+
+esp_err_t device_settings_set_meshcore_regions(const void* value, size_t length) {
+    return device_settings_set_blob("mc.regions", value, length);
+}
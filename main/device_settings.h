@@ -55,3 +55,9 @@ esp_err_t device_settings_get_meshcore_private_key(char* out_value, size_t max_l
 esp_err_t device_settings_set_meshcore_private_key(const char* value);
 esp_err_t device_settings_get_meshcore_public_key(char* out_value, size_t max_length);
 esp_err_t device_settings_set_meshcore_public_key(const char* value);
+esp_err_t device_settings_get_meshcore_identity(uint8_t* out_private_key, size_t length);
+esp_err_t device_settings_set_meshcore_identity(const uint8_t* private_key, size_t length);
+esp_err_t device_settings_get_meshcore_channels(void* out_value, size_t length);
+esp_err_t device_settings_set_meshcore_channels(const void* value, size_t length);
+esp_err_t device_settings_get_meshcore_regions(void* out_value, size_t length);
+esp_err_t device_settings_set_meshcore_regions(const void* value, size_t length);
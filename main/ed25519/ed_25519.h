@@ -22,6 +22,12 @@
 extern "C" {
 #endif
 
+/* One fragment of a message that is not stored contiguously */
+typedef struct {
+    const unsigned char *data;
+    size_t length;
+} ed25519_iovec_t;
+
 #ifndef ED25519_NO_SEED
 int ED25519_DECLSPEC ed25519_create_seed(unsigned char *seed);
 #endif
@@ -30,6 +36,7 @@ void ED25519_DECLSPEC ed25519_create_keypair(unsigned char *public_key, unsigned
 void ED25519_DECLSPEC ed25519_derive_pub(unsigned char *public_key, const unsigned char *private_key);
 void ED25519_DECLSPEC ed25519_sign(unsigned char *signature, const unsigned char *message, size_t message_len, const unsigned char *public_key, const unsigned char *private_key);
 int ED25519_DECLSPEC ed25519_verify(const unsigned char *signature, const unsigned char *message, size_t message_len, const unsigned char *public_key);
+int ED25519_DECLSPEC ed25519_verify_iov(const unsigned char *signature, const ed25519_iovec_t *message, size_t message_count, const unsigned char *public_key);
 void ED25519_DECLSPEC ed25519_add_scalar(unsigned char *public_key, unsigned char *private_key, const unsigned char *scalar);
 void ED25519_DECLSPEC ed25519_key_exchange(unsigned char *shared_secret, const unsigned char *public_key, const unsigned char *private_key);
 
@@ -5,6 +5,8 @@
 #ifdef _WIN32
 #include <windows.h>
 #include <wincrypt.h>
+#elif defined(ESP_PLATFORM)
+#include "esp_random.h"
 #else
 #include <stdio.h>
 #endif
@@ -23,6 +25,9 @@ int ed25519_create_seed(unsigned char *seed) {
     }
 
     CryptReleaseContext(prov, 0);
+#elif defined(ESP_PLATFORM)
+    /* Hardware RNG, there is no /dev/urandom. Without a running radio the caller enables an entropy source first */
+    esp_fill_random(seed, 32);
 #else
     FILE *f = fopen("/dev/urandom", "rb");
 
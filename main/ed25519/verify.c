@@ -45,11 +45,19 @@ static int consttime_equal(const unsigned char *x, const unsigned char *y) {
 }
 
 int ed25519_verify(const unsigned char *signature, const unsigned char *message, size_t message_len, const unsigned char *public_key) {
+    ed25519_iovec_t fragment = {message, message_len};
+
+    return ed25519_verify_iov(signature, &fragment, 1, public_key);
+}
+
+/* The message fragments are hashed in order, as if they were concatenated */
+int ed25519_verify_iov(const unsigned char *signature, const ed25519_iovec_t *message, size_t message_count, const unsigned char *public_key) {
     unsigned char h[64];
     unsigned char checker[32];
     sha512_context hash;
     ge_p3 A;
     ge_p2 R;
+    size_t i;
 
     if (signature[63] & 224) {
         return 0;
@@ -62,7 +70,9 @@ int ed25519_verify(const unsigned char *signature, const unsigned char *message,
     sha512_init(&hash);
     sha512_update(&hash, signature, 32);
     sha512_update(&hash, public_key, 32);
-    sha512_update(&hash, message, message_len);
+    for (i = 0; i < message_count; ++i) {
+        sha512_update(&hash, message[i].data, message[i].length);
+    }
     sha512_final(&hash, h);
     
     sc_reduce(h);
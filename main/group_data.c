@@ -0,0 +1,152 @@
+#include "group_data.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "channel_manager.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "meshcore/packet.h"
+#include "meshcore/payload/grp_data.h"
+#include "meshcore/trace.h"
+#include "packet_pool.h"
+#include "perf_counters.h"
+
+static const char* TAG = "group_data";
+
+typedef struct {
+    group_data_handler_t handler;  // NULL for an unused entry
+    uint8_t              data_type;
+    void*                context;
+} handler_entry_t;
+
+static handler_entry_t       handlers[GROUP_DATA_MAX_HANDLERS] = {0};
+static SemaphoreHandle_t     mutex                             = NULL;
+static group_data_transmit_t transmit_function                 = NULL;
+
+esp_err_t group_data_init(group_data_transmit_t transmit) {
+    mutex = xSemaphoreCreateMutex();
+    if (mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    transmit_function = transmit;
+    return ESP_OK;
+}
+
+esp_err_t group_data_register(uint8_t data_type, group_data_handler_t handler, void* context) {
+    if (handler == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t res = ESP_ERR_NO_MEM;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (size_t i = 0; i < GROUP_DATA_MAX_HANDLERS; i++) {
+        if (handlers[i].handler == NULL) {
+            handlers[i].handler   = handler;
+            handlers[i].data_type = data_type;
+            handlers[i].context   = context;
+            res                   = ESP_OK;
+            break;
+        }
+    }
+    xSemaphoreGive(mutex);
+    return res;
+}
+
+void group_data_unregister(uint8_t data_type, group_data_handler_t handler) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (size_t i = 0; i < GROUP_DATA_MAX_HANDLERS; i++) {
+        if (handlers[i].handler == handler && handlers[i].data_type == data_type) {
+            memset(&handlers[i], 0, sizeof(handler_entry_t));
+        }
+    }
+    xSemaphoreGive(mutex);
+}
+
+esp_err_t group_data_send(const uint8_t* channel_id, uint8_t data_type, const uint8_t* data, uint8_t length) {
+    if (length > MESHCORE_GRP_DATA_MAX_SIZE || transmit_function == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    packet_buffer_t* buffer = packet_pool_alloc();
+    if (buffer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    meshcore_grp_data_t* grp_data = &buffer->payload.grp_data;
+    grp_data->channel_hash        = channel_id[0];
+
+    esp_err_t res = ESP_OK;
+    if (meshcore_grp_data_encode((uint32_t)time(NULL), data_type, data, length, grp_data->data,
+                                 sizeof(grp_data->data), &grp_data->data_length) < 0) {
+        res = ESP_ERR_INVALID_SIZE;
+    } else if (!channel_manager_encrypt(channel_id, grp_data->data, grp_data->data_length, sizeof(grp_data->data),
+                                        &grp_data->data_length, grp_data->mac)) {
+        res = ESP_ERR_NOT_FOUND;
+    } else {
+        meshcore_message_t* message = &buffer->message;
+        message->type               = MESHCORE_PAYLOAD_TYPE_GRP_DATA;
+        message->route              = MESHCORE_ROUTE_TYPE_FLOOD;
+        message->version            = 0x00;
+        meshcore_grp_data_serialize(grp_data, message->payload, &message->payload_length);
+        if (!transmit_function(buffer)) {
+            res = ESP_FAIL;
+        }
+    }
+
+    packet_pool_free(buffer);
+    return res;
+}
+
+void group_data_receive(packet_buffer_t* buffer) {
+    meshcore_message_t*  message  = &buffer->message;
+    meshcore_grp_data_t* grp_data = &buffer->payload.grp_data;
+
+    uint32_t start = perf_begin();
+    int      res   = meshcore_grp_data_deserialize(message->payload, message->payload_length, grp_data);
+    perf_end(PERF_STAGE_PAYLOAD, start);
+    if (res < 0) {
+        MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_WARN, MESHCORE_TRACE_GROUP, "Failed to decode group datagram");
+        perf_count_drop(PERF_DROP_PAYLOAD);
+        return;
+    }
+
+    channel_info_t channel;
+    if (!channel_manager_decrypt(grp_data->channel_hash, grp_data->mac, grp_data->data, grp_data->data_length,
+                                 &channel)) {
+        perf_count_drop(PERF_DROP_MAC);
+        return;
+    }
+
+    meshcore_grp_data_view_t view;
+    if (meshcore_grp_data_decode(grp_data->data, grp_data->data_length, &view) < 0) {
+        MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_WARN, MESHCORE_TRACE_GROUP, "Invalid group datagram contents");
+        perf_count_drop(PERF_DROP_PAYLOAD);
+        return;
+    }
+    MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_DEBUG, MESHCORE_TRACE_GROUP, "Channel hash: %02X, data type: %u, length: %u",
+                   grp_data->channel_hash, view.data_type, view.data_length);
+
+    // Handlers run without the lock so they are free to register and unregister
+    handler_entry_t matches[GROUP_DATA_MAX_HANDLERS];
+    size_t          count = 0;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (size_t i = 0; i < GROUP_DATA_MAX_HANDLERS; i++) {
+        if (handlers[i].handler != NULL && handlers[i].data_type == view.data_type) {
+            matches[count++] = handlers[i];
+        }
+    }
+    xSemaphoreGive(mutex);
+
+    if (count == 0) {
+        ESP_LOGD(TAG, "No handler for data type %u", view.data_type);
+        perf_count_drop(PERF_DROP_UNHANDLED);
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        matches[i].handler(&channel, &view, &buffer->rx, matches[i].context);
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "channel_manager.h"
+#include "esp_err.h"
+#include "meshcore/payload/grp_data.h"
+#include "packet_pool.h"
+
+#define GROUP_DATA_MAX_HANDLERS 8
+
+// Called on the meshcore task for every datagram of the registered type, with the channel it was received on. The view
+// points into the packet buffer, so the data must be copied when it is needed after the handler returns. Handlers must
+// not block.
+typedef void (*group_data_handler_t)(const channel_info_t* channel, const meshcore_grp_data_view_t* view,
+                                     const packet_rx_info_t* rx, void* context);
+
+// Serializes and sends a packet, returns false when it could not be sent
+typedef bool (*group_data_transmit_t)(packet_buffer_t* buffer);
+
+esp_err_t group_data_init(group_data_transmit_t transmit);
+
+// Deliver datagrams of a data type to a handler, a data type can have several handlers
+esp_err_t group_data_register(uint8_t data_type, group_data_handler_t handler, void* context);
+void      group_data_unregister(uint8_t data_type, group_data_handler_t handler);
+
+// Encrypt and flood a datagram on the subscribed channel with the id, at most MESHCORE_GRP_DATA_MAX_SIZE bytes
+esp_err_t group_data_send(const uint8_t* channel_id, uint8_t data_type, const uint8_t* data, uint8_t length);
+
+// Handle a received GRP_DATA packet, the payload is decrypted in-place in the buffer
+void group_data_receive(packet_buffer_t* buffer);
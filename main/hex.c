@@ -0,0 +1,32 @@
+#include "hex.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+bool hex_to_bytes(const char* hex, uint8_t* out, size_t length) {
+    if (strlen(hex) != length * 2) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        int high = hex_digit(hex[i * 2]);
+        int low  = hex_digit(hex[i * 2 + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        out[i] = (uint8_t)(high << 4 | low);
+    }
+    return true;
+}
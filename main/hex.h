@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Parse a hex string of exactly length bytes, as used for keys and secrets in the settings. Returns false for any
+// other length or a character that is not a hex digit, out may then be partly written.
+bool hex_to_bytes(const char* hex, uint8_t* out, size_t length);
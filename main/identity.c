@@ -0,0 +1,121 @@
+#include "identity.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bootloader_random.h"
+#include "device_settings.h"
+#include "ed25519/ed_25519.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "hex.h"
+#include "meshcore/contacts.h"
+#include "nvs.h"
+
+static const char* TAG = "identity";
+
+#define IDENTITY_MAX_ATTEMPTS 16  // Key pairs generated before giving up on getting a usable hash
+
+static identity_t identity       = {0};
+static bool       identity_valid = false;
+
+// Hashes 0x00 and 0xFF are reserved in paths, nodes never use them
+static bool hash_usable(const uint8_t* public_key) {
+    uint8_t hash = meshcore_contact_hash(public_key);
+    return hash != 0x00 && hash != 0xFF;
+}
+
+// Import a private key provisioned as a hex string
+static bool import_hex(uint8_t* out_private_key) {
+    char hex[MESHCORE_PRV_KEY_SIZE * 2 + 1] = {0};
+    device_settings_get_meshcore_private_key(hex, sizeof(hex));
+    if (hex[0] == '\0') {
+        return false;
+    }
+    if (!hex_to_bytes(hex, out_private_key, MESHCORE_PRV_KEY_SIZE)) {
+        ESP_LOGW(TAG, "Ignoring invalid hex private key");
+        return false;
+    }
+    return true;
+}
+
+// The identity is generated at first boot before any radio runs, without an entropy source the hardware RNG only
+// produces pseudo-random numbers. The ADC noise source feeds it while the seed is drawn, Wi-Fi is started later.
+static bool generate(uint8_t* out_private_key) {
+    bool usable = false;
+    bootloader_random_enable();
+    for (size_t attempt = 0; attempt < IDENTITY_MAX_ATTEMPTS && !usable; attempt++) {
+        uint8_t seed[32];
+        uint8_t public_key[MESHCORE_PUB_KEY_SIZE];
+        if (ed25519_create_seed(seed) != 0) {
+            break;
+        }
+        ed25519_create_keypair(public_key, out_private_key, seed);
+        memset(seed, 0, sizeof(seed));
+        usable = hash_usable(public_key);
+    }
+    bootloader_random_disable();
+    return usable;
+}
+
+// Publish the public key for other apps, they only ever read it
+static void store_public_key(const uint8_t* public_key) {
+    char hex[MESHCORE_PUB_KEY_SIZE * 2 + 1];
+    for (size_t i = 0; i < MESHCORE_PUB_KEY_SIZE; i++) {
+        snprintf(&hex[i * 2], 3, "%02x", public_key[i]);
+    }
+    device_settings_set_meshcore_public_key(hex);
+}
+
+esp_err_t identity_init(void) {
+    uint8_t private_key[MESHCORE_PRV_KEY_SIZE];
+    bool    imported  = import_hex(private_key);
+    bool    generated = false;
+
+    if (imported) {
+        ESP_LOGI(TAG, "Importing provisioned private key");
+    } else {
+        esp_err_t res = device_settings_get_meshcore_identity(private_key, sizeof(private_key));
+        if (res == ESP_ERR_NVS_NOT_FOUND) {
+            if (!generate(private_key)) {
+                ESP_LOGE(TAG, "Failed to generate an identity");
+                return ESP_FAIL;
+            }
+            ESP_LOGI(TAG, "Generated a new identity");
+            generated = true;
+        } else if (res != ESP_OK) {
+            // Never replace an identity that exists but could not be read
+            ESP_LOGE(TAG, "Failed to load identity: %s", esp_err_to_name(res));
+            return res;
+        }
+    }
+
+    esp_err_t res = ESP_OK;
+    if (imported || generated) {
+        res = device_settings_set_meshcore_identity(private_key, sizeof(private_key));
+        if (res != ESP_OK) {
+            // Keep running with the identity, it is lost at the next boot
+            ESP_LOGE(TAG, "Failed to store identity: %s", esp_err_to_name(res));
+        } else if (imported) {
+            // Keep the private key in one place only
+            device_settings_set_meshcore_private_key("");
+        }
+    }
+
+    memcpy(identity.private_key, private_key, MESHCORE_PRV_KEY_SIZE);
+    memset(private_key, 0, sizeof(private_key));
+    ed25519_derive_pub(identity.public_key, identity.private_key);
+    identity.hash  = meshcore_contact_hash(identity.public_key);
+    identity_valid = true;
+
+    if (imported || generated) {
+        store_public_key(identity.public_key);
+    }
+
+    ESP_LOGI(TAG, "Identity loaded, hash %02X", identity.hash);
+    return res;
+}
+
+const identity_t* identity_get(void) {
+    return identity_valid ? &identity : NULL;
+}
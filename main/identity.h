@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "meshcore/packet.h"
+#include "meshcore/payload/advert.h"
+
+typedef struct {
+    uint8_t private_key[MESHCORE_PRV_KEY_SIZE];
+    uint8_t public_key[MESHCORE_PUB_KEY_SIZE];
+    uint8_t hash;  // Hash addressing this node in packet headers and paths
+} identity_t;
+
+// Load the identity from NVS, called once at boot. A hex encoded private key left in the old setting is imported and
+// then cleared, without either a new identity is generated from the hardware RNG and stored.
+esp_err_t identity_init(void);
+
+// The identity of this node, NULL when none could be loaded or generated. The identity does not change after
+// identity_init(), so it can be read from any task without locking.
+const identity_t* identity_get(void);
@@ -1,7 +1,10 @@
 #include <inttypes.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <time.h>
 #include "bsp/device.h"
 #include "bsp/display.h"
@@ -10,6 +13,10 @@
 #include "bsp/power.h"
 #include "bsp/rtc.h"
 #include "bsp/tanmatsu.h"
+#include "capture.h"
+#include "channel_manager.h"
+#include "chat_arena.h"
+#include "chat_layout.h"
 #include "crypto/aes.h"
 #include "crypto/hmac_sha256.h"
 #include "custom_certificates.h"
@@ -20,17 +27,38 @@
 #include "esp_lcd_panel_ops.h"
 #include "esp_lcd_types.h"
 #include "esp_log.h"
+#include "esp_random.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "group_data.h"
 #include "hal/lcd_types.h"
+#include "identity.h"
 #include "lora.h"
 #include "lora_settings_handler.h"
+#include "meshcore/cipher.h"
+#include "meshcore/contacts.h"
+#include "meshcore/multipart.h"
 #include "meshcore/packet.h"
+#include "meshcore/path_trace.h"
 #include "meshcore/payload/advert.h"
 #include "meshcore/payload/grp_txt.h"
+#include "meshcore/payload/txt_msg.h"
+#include "meshcore/self_advert.h"
+#include "meshcore/trace.h"
+#include "message_store.h"
+#include "multipart_manager.h"
 #include "nvs_flash.h"
+#include "packet_pool.h"
+#include "packet_ring.h"
+#include "perf_counters.h"
 #include "pax_fonts.h"
 #include "pax_gfx.h"
 #include "pax_text.h"
 #include "portmacro.h"
+#include "region_manager.h"
+#include "screen.h"
 #include "wifi_connection.h"
 #include "wifi_remote.h"
 
@@ -38,18 +66,23 @@
 #define WHITE 0xFFFFFFFF
 #define RED   0xFFFF0000
 
-#define CHAT_MESSAGE_NAME_SIZE 40
-#define CHAT_MESSAGE_TEXT_SIZE 200
+#define DISPLAY_DOUBLE_BUFFERED true  // Render into fb while the previous frame is transferred in the background
 
-typedef struct {
-    uint8_t  channel_hash;
-    char     name[CHAT_MESSAGE_NAME_SIZE];  // sender name (UTF-8)
-    char     text[CHAT_MESSAGE_TEXT_SIZE];  // Message text (UTF-8)
-    uint32_t received_at;                   // Unix timestamp (local clock)
-    uint32_t timestamp;                     // Unix timestamp (remote clock)
-    bool     sent;                          // Sent by us
-    bool     repeated;                      // Repeated by others
-} chat_message_t;
+#define CHAT_PAGE_SIZE    16  // Messages loaded from the store per page
+#define CHAT_ROW_COUNT    16  // Text lines in the chat area
+#define CHAT_ROW_TOP      72
+#define CHAT_ROW_HEIGHT   20
+#define CHAT_STATUS_ROW   CHAT_ROW_COUNT
+#define CHAT_ROW_NONE     0            // Row key of an empty row
+#define CHAT_ROW_KEY_SEED 2166136261u  // FNV-1a offset basis
+#define CHAT_STATUS_SIZE  96           // Characters that fit in the status row
+
+#define RENDER_INTERVAL_US (1000000 / 30)  // Redraws are coalesced to at most one per frame interval
+
+#define MESSAGE_LED_ON_MS 500  // How long the message LED lights up for a received packet
+
+_Static_assert(MESSAGE_STORE_ID_SIZE <= MESHCORE_CHANNEL_ID_SIZE && MESSAGE_STORE_ID_SIZE <= MESHCORE_PUB_KEY_SIZE,
+               "Stores are keyed by channel id or public key prefix");
 
 // Constants
 static char const TAG[] = "main";
@@ -61,10 +94,46 @@ static lcd_color_rgb_pixel_format_t display_color_format = LCD_COLOR_PIXEL_FORMA
 static lcd_rgb_data_endian_t        display_data_endian  = LCD_RGB_DATA_ENDIAN_LITTLE;
 static pax_buf_t                    fb                   = {0};
 static QueueHandle_t                input_event_queue    = NULL;
-static chat_message_t               chat_messages[16]    = {0};
-static size_t                       chat_message_index   = 0;
 static size_t                       text_buffer_length   = 0;
 static char                         text_buffer[200]     = {0};
+static meshcore_contacts_t          contacts             = {0};
+static SemaphoreHandle_t            contacts_mutex       = NULL;  // Updated by the meshcore task, searched by the UI
+static TaskHandle_t                 meshcore_task_handle = NULL;
+static packet_ring_t                rx_ring              = {0};
+static lora_protocol_lora_packet_t  rx_discard_packet    = {0};
+
+// Chat history, the window holds the messages of the current store that are kept in RAM
+static SemaphoreHandle_t chat_mutex                    = NULL;
+static message_store_t*  chat_store                    = NULL;
+static chat_arena_t      chat_window                   = {0};
+static size_t            chat_scroll                   = 0;    // Messages between the bottom of the page and the newest
+static char              chat_notice[CHAT_STATUS_SIZE] = {0};  // Shown in the status row until the next key press
+
+// Keys of what is currently drawn in each chat row (and the status row), rows are only redrawn when their key changes
+static uint32_t            chat_row_keys[CHAT_ROW_COUNT + 1] = {0};
+static chat_layout_cache_t chat_layouts                      = {0};
+
+// Redraw coalescing, set by any task that changes what the chat view shows and consumed by the main loop
+static atomic_bool chat_dirty       = false;
+static int64_t     last_render_time = 0;
+static uint32_t    redraw_requests  = 0;
+static uint32_t    redraws          = 0;
+
+// Identity, NULL until loaded
+static const identity_t* own_identity = NULL;
+
+// Message LED, requested while parsing and driven by the meshcore task between packets. Only touched by that task.
+static bool    message_led_pending  = false;
+static bool    message_led_color[3] = {false};
+static int64_t message_led_off_at   = 0;  // Milliseconds at which the LED goes off again, 0 while it is off
+
+// Own advertisement, only touched by the meshcore task
+static meshcore_self_advert_t self_advert      = {0};
+static atomic_bool            advert_requested = false;  // Flood an advert now, set by the /advert command
+
+// Path traces we originate or forward, the mutex is created once the identity is known
+static meshcore_path_tracer_t path_tracer       = {0};
+static SemaphoreHandle_t      path_tracer_mutex = NULL;
 
 const char* type_to_string(meshcore_payload_type_t type) {
     switch (type) {
@@ -127,278 +196,726 @@ const char* role_to_string(meshcore_device_role_t role) {
     }
 }
 
-static uint8_t mc_keys[2][16] = {
-    {0x8b, 0x33, 0x87, 0xe9, 0xc5, 0xcd, 0xea, 0x6a, 0xc9, 0xe5, 0xed, 0xba, 0xa1, 0x15, 0xcd, 0x72},  // public
-    {0x9c, 0xd8, 0xfc, 0xf2, 0x2a, 0x47, 0x33, 0x3b, 0x59, 0x1d, 0x96, 0xa2, 0xb8, 0x48, 0xb7, 0x3f},  // test
-};
+// Move received frames from the LoRa driver straight into the RX ring. This runs in the radio callback context, which
+// is the only producer of the ring.
+static void receive_packets(int64_t received_at) {
+    while (1) {
+        packet_buffer_t* buffer = packet_pool_alloc();
+        if (buffer == NULL) {
+            // Shed load as early as possible, the frame is dropped without being parsed
+            if (lora_receive_packet(&rx_discard_packet, 0) != ESP_OK) {
+                break;
+            }
+            rx_ring.stats.no_buffer++;
+            continue;
+        }
+
+        if (lora_receive_packet(&buffer->packet, 0) != ESP_OK) {
+            packet_pool_free(buffer);
+            break;
+        }
 
-static uint8_t verification_data[MESHCORE_MAX_PAYLOAD_SIZE] = {0};
+        packet_descriptor_t descriptor = {
+            .buffer = buffer,
+            .rx =
+                {
+                    .received_at = received_at,
+                    .rssi        = PACKET_RSSI_UNKNOWN,
+                    .snr         = PACKET_SNR_UNKNOWN,
+                },
+        };
+        if (!packet_ring_push(&rx_ring, &descriptor)) {
+            packet_pool_free(buffer);
+        }
+    }
+
+    if (packet_ring_count(&rx_ring) > 0) {
+        xTaskNotifyGive(meshcore_task_handle);
+    }
+}
 
 static void radio_callback(uint8_t type, uint8_t* payload, uint16_t payload_length) {
     if (type == 1) {
+        int64_t received_at = esp_timer_get_time();
         lora_transaction_receive(payload, payload_length);
+        if (meshcore_task_handle != NULL) {
+            receive_packets(received_at);
+        }
     } else {
         ESP_LOGI(TAG, "Received message from radio: type: %d, payload length: %d", type, payload_length);
-        for (int i = 0; i < payload_length; i++) {
-            printf("%02X ", payload[i]);
-        }
-        printf("\r\n");
+        MESHCORE_TRACE_HEX(MESHCORE_TRACE_LEVEL_DEBUG, MESHCORE_TRACE_PACKET, "Radio message: ", payload,
+                           payload_length);
     }
 }
 
 static void blit(void) {
-    bsp_display_blit(0, 0, display_h_res, display_v_res, pax_buf_get_pixels(&fb));
+    screen_flush_full();
 }
 
+// Only records the colour, the coprocessor is written by run_message_led() so parsing never waits for it
 static void blink_message_led(bool r, bool g, bool b) {
+    message_led_color[0] = r;
+    message_led_color[1] = g;
+    message_led_color[2] = b;
+    message_led_pending  = true;
+}
+
+// Light the requested colour or turn the LED off once it has been on long enough, returns how long the meshcore task
+// may sleep until the LED needs attention again
+static TickType_t run_message_led(void) {
     tanmatsu_coprocessor_handle_t handle;
+    int64_t                       now = esp_timer_get_time() / 1000;
+    if (message_led_pending) {
+        bsp_tanmatsu_coprocessor_get_handle(&handle);
+        tanmatsu_coprocessor_set_message(handle, message_led_color[0], message_led_color[1], message_led_color[2],
+                                         true, false, false, false, false);
+        message_led_pending = false;
+        message_led_off_at  = now + MESSAGE_LED_ON_MS;
+    }
+    if (message_led_off_at == 0) {
+        return portMAX_DELAY;
+    }
+    if (now < message_led_off_at) {
+        return pdMS_TO_TICKS(message_led_off_at - now);
+    }
     bsp_tanmatsu_coprocessor_get_handle(&handle);
-    tanmatsu_coprocessor_set_message(handle, r, g, b, true, false, false, false, false);
-    vTaskDelay(pdMS_TO_TICKS(500));
     tanmatsu_coprocessor_set_message(handle, false, false, false, false, false, false, false, false);
+    message_led_off_at = 0;
+    return portMAX_DELAY;
 }
 
-bool handle_chat_message(uint8_t channel_hash, const char* name, const char* text, uint32_t timestamp, bool sent) {
-    printf("Chat message received - Name: '%s', Text: '%s', Timestamp: %" PRIu32 "\n", name, text, timestamp);
-    size_t amount_of_messages = sizeof(chat_messages) / sizeof(chat_message_t);
+// Load the page of the current store that ends chat_scroll messages before the newest one, call with the mutex held
+static void load_chat_page(void) {
+    size_t count = message_store_count(chat_store);
+    if (chat_scroll > count) {
+        chat_scroll = count;
+    }
+    size_t end   = count - chat_scroll;
+    size_t start = end > CHAT_PAGE_SIZE ? end - CHAT_PAGE_SIZE : 0;
+
+    chat_arena_clear(&chat_window);
+    chat_message_t message;
+    for (size_t i = start; i < end && message_store_read(chat_store, i, &message, 1) == 1; i++) {
+        chat_arena_append(&chat_window, &message);
+    }
 
-    chat_message_t* previous_message = &chat_messages[(chat_message_index - 1) % amount_of_messages];
+    // Lay the page out once here instead of on every render
+    chat_arena_record_t record;
+    for (size_t i = 0; chat_arena_get(&chat_window, i, &record); i++) {
+        chat_layout_get(&chat_layouts, &record);
+    }
+}
 
-    if (previous_message->channel_hash == channel_hash && strcmp(previous_message->name, name) == 0 &&
-        strcmp(previous_message->text, text) == 0) {
-        previous_message->repeated = true;
+// Ask the main loop to redraw the chat view, only the first request after a redraw wakes it up
+static void request_redraw(void) {
+    redraw_requests++;
+    if (!atomic_exchange(&chat_dirty, true)) {
         // Bit of a hack but oh well, this is just a preview app anyway
-        bsp_input_event_t event    = {.type = INPUT_EVENT_TYPE_LAST};
+        bsp_input_event_t event = {.type = INPUT_EVENT_TYPE_LAST};
         bsp_input_inject_event(&event);
+    }
+}
+
+// Show a line such as the result of a command in the status row, it stays until the next key press
+static void show_notice(const char* text) {
+    xSemaphoreTake(chat_mutex, portMAX_DELAY);
+    snprintf(chat_notice, sizeof(chat_notice), "%s", text);
+    xSemaphoreGive(chat_mutex);
+    request_redraw();
+}
+
+static void clear_notice(void) {
+    xSemaphoreTake(chat_mutex, portMAX_DELAY);
+    bool shown     = chat_notice[0] != '\0';
+    chat_notice[0] = '\0';
+    xSemaphoreGive(chat_mutex);
+    if (shown) {
+        request_redraw();
+    }
+}
+
+// The store id is the channel id, or the public key of the contact for direct messages
+bool handle_chat_message(const uint8_t* store_id, const char* name, const char* text, uint32_t timestamp, bool sent,
+                         bool direct) {
+    printf("Chat message received - Name: '%s', Text: '%s', Timestamp: %" PRIu32 "\n", name, text, timestamp);
+
+    xSemaphoreTake(chat_mutex, portMAX_DELAY);
+
+    message_store_t* store = message_store_open(store_id, direct);
+    if (store == NULL) {
+        xSemaphoreGive(chat_mutex);
         return false;
     }
+    if (chat_store == NULL) {
+        chat_store = store;
+    }
+    bool   visible = store == chat_store && chat_scroll == 0;
+    size_t count   = message_store_count(store);
+
+    chat_message_t previous_message;
+    if (count > 0 && message_store_read(store, count - 1, &previous_message, 1) == 1 &&
+        strcmp(previous_message.name, name) == 0 && strcmp(previous_message.text, text) == 0) {
+        message_store_set_repeated(store, count - 1);
+        if (visible && chat_arena_count(&chat_window) > 0) {
+            chat_arena_set_repeated(&chat_window, chat_arena_count(&chat_window) - 1);
+        }
+        bool redraw = store == chat_store;
+        xSemaphoreGive(chat_mutex);
+        if (redraw) {
+            request_redraw();
+        }
+        return false;
+    }
+
+    chat_message_t message = {
+        .channel_hash = store_id[0],
+        .received_at  = (uint32_t)time(NULL),
+        .timestamp    = timestamp,
+        .sent         = sent,
+        .repeated     = false,
+        .direct       = direct,
+    };
+    snprintf(message.name, CHAT_MESSAGE_NAME_SIZE, "%s", name);
+    snprintf(message.text, CHAT_MESSAGE_TEXT_SIZE, "%s", text);
+
+    if (message_store_append(store, &message) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to store chat message");
+    }
+
+    if (visible) {
+        // Following the newest messages, append to the window instead of reading it back from flash
+        message_store_mark_read(store);
+        chat_arena_record_t record;
+        if (chat_arena_append(&chat_window, &message) &&
+            chat_arena_get(&chat_window, chat_arena_count(&chat_window) - 1, &record)) {
+            chat_layout_get(&chat_layouts, &record);
+        }
+    } else if (store == chat_store) {
+        // Scrolled back, keep the page anchored on the same messages
+        chat_scroll++;
+    }
 
-    chat_message_t* message = &chat_messages[chat_message_index];
+    bool redraw = store == chat_store;
+    xSemaphoreGive(chat_mutex);
+    if (redraw) {
+        request_redraw();
+    }
 
-    message->channel_hash = channel_hash;
-    snprintf(message->name, CHAT_MESSAGE_NAME_SIZE, "%s", name);
-    snprintf(message->text, CHAT_MESSAGE_TEXT_SIZE, "%s", text);
-    message->timestamp = timestamp;
-    message->sent      = sent;
+    return true;
+}
 
-    chat_message_index++;
-    if (chat_message_index >= amount_of_messages) {
-        chat_message_index = 0;
+void scroll_chat(bool up) {
+    xSemaphoreTake(chat_mutex, portMAX_DELAY);
+    if (up) {
+        chat_scroll += CHAT_PAGE_SIZE;
+    } else {
+        chat_scroll = chat_scroll > CHAT_PAGE_SIZE ? chat_scroll - CHAT_PAGE_SIZE : 0;
+    }
+    if (chat_scroll == 0) {
+        message_store_mark_read(chat_store);
     }
+    load_chat_page();
+    xSemaphoreGive(chat_mutex);
+}
 
-    // Bit of a hack but oh well, this is just a preview app anyway
-    bsp_input_event_t event = {.type = INPUT_EVENT_TYPE_LAST};
-    bsp_input_inject_event(&event);
+void switch_chat(void) {
+    xSemaphoreTake(chat_mutex, portMAX_DELAY);
+    chat_store  = message_store_next(chat_store);
+    chat_scroll = 0;
+    message_store_mark_read(chat_store);
+    load_chat_page();
+    xSemaphoreGive(chat_mutex);
+}
+
+// MAC check and decryption timed as separate stages, returns false when the MAC does not match
+static bool verify_and_decrypt(const uint8_t* secret, size_t secret_length, const uint8_t* mac, uint8_t* data,
+                               uint8_t length) {
+    uint32_t start = perf_begin();
+    bool     valid = meshcore_mac_verify(secret, secret_length, mac, data, length) == 0;
+    perf_end(PERF_STAGE_MAC, start);
+    if (!valid) {
+        return false;
+    }
 
+    start = perf_begin();
+    meshcore_decrypt(secret, secret_length, data, length);
+    perf_end(PERF_STAGE_DECRYPT, start);
     return true;
 }
 
-void meshcore_parse(lora_protocol_lora_packet_t* packet) {
-    meshcore_message_t message;
-    if (meshcore_deserialize(packet->data, packet->length, &message) < 0) {
-        ESP_LOGE(TAG, "Failed to deserialize message");
-        return;
+// Check an advert signature, the signed ranges are hashed straight out of the received payload
+static bool verify_advert(const meshcore_advert_t* advert, const meshcore_advert_signed_t* signed_data) {
+    uint32_t start = perf_begin();
+    bool     valid = ed25519_verify_iov(advert->signature, signed_data->parts, signed_data->count, advert->pub_key);
+    perf_end(PERF_STAGE_VERIFY, start);
+    return valid;
+}
+
+static bool transmit_buffer(packet_buffer_t* buffer) {
+    region_manager_apply(&buffer->message);
+    if (meshcore_serialize(&buffer->message, buffer->packet.data, &buffer->packet.length) < 0) {
+        ESP_LOGE(TAG, "Failed to serialize message");
+        return false;
     }
+    ESP_LOGI(TAG, "Message serialized successfully, length: %d", buffer->packet.length);
+    capture_frame(NULL, esp_timer_get_time(), true, buffer->packet.data, buffer->packet.length);
+    return lora_send_packet(&buffer->packet) == ESP_OK;
+}
 
-    printf("Type: %s [%d]\n", type_to_string(message.type), message.type);
-    printf("Route: %s [%d]\n", route_to_string(message.route), message.route);
-    printf("Version: %d\n", message.version);
-    printf("Path Length: %d\n", message.path_length);
-    if (message.path_length > 0) {
-        printf("Path: ");
-        for (unsigned int i = 0; i < message.path_length; i++) {
-            printf("0x%02x, ", message.path[i]);
+// One line summing up a trace result, returns false for an unused result slot
+static bool format_trace_result(const meshcore_path_trace_result_t* result, char* out, size_t size) {
+    char   hops[MESHCORE_PATH_TRACE_MAX_HOPS * 3 + 1] = {0};
+    size_t position                                   = 0;
+    for (uint8_t i = 0; i < result->hop_count; i++) {
+        position += snprintf(&hops[position], sizeof(hops) - position, i > 0 ? ",%02X" : "%02X", result->hops[i]);
+    }
+
+    switch (result->state) {
+        case MESHCORE_PATH_TRACE_STATE_PENDING:
+            snprintf(out, size, "Trace %08" PRIX32 " via %s: waiting", result->tag, hops);
+            return true;
+        case MESHCORE_PATH_TRACE_STATE_TIMED_OUT:
+            snprintf(out, size, "Trace %08" PRIX32 " via %s: timed out", result->tag, hops);
+            return true;
+        case MESHCORE_PATH_TRACE_STATE_COMPLETE:
+            // Every link is one transmission, the round trip time divided over them approximates the time per hop
+            snprintf(out, size, "Trace %08" PRIX32 " via %s: round trip %u ms, %u ms per hop", result->tag, hops,
+                     (unsigned int)(result->round_trip / 1000),
+                     (unsigned int)(result->round_trip / 1000 / (result->hop_count + 1)));
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Show a trace result in the status row, a completed trace with the SNR of every link from us and back
+static void show_trace_result(const meshcore_path_trace_result_t* result) {
+    char notice[CHAT_STATUS_SIZE];
+    if (!format_trace_result(result, notice, sizeof(notice))) {
+        return;
+    }
+    if (result->state == MESHCORE_PATH_TRACE_STATE_COMPLETE) {
+        size_t length = strlen(notice);
+        for (uint8_t i = 0; i <= result->hop_count && length < sizeof(notice); i++) {
+            const char* separator = i > 0 ? " /" : ", SNR";
+            if (result->snr[i] == PACKET_SNR_UNKNOWN) {
+                length += snprintf(&notice[length], sizeof(notice) - length, "%s ?", separator);
+            } else {
+                length += snprintf(&notice[length], sizeof(notice) - length, "%s %.1f", separator,
+                                   result->snr[i] / 4.0);
+            }
         }
-        printf("\n");
     }
-    printf("Payload Length: %d\n", message.payload_length);
-    if (message.payload_length > 0) {
-        printf("Payload [%d]: ", message.payload_length);
-        for (unsigned int i = 0; i < message.payload_length; i++) {
-            printf("%02X", message.payload[i]);
+    show_notice(notice);
+}
+
+static void log_trace_result(const meshcore_path_trace_result_t* result) {
+    char summary[CHAT_STATUS_SIZE];
+    if (!format_trace_result(result, summary, sizeof(summary))) {
+        return;
+    }
+    ESP_LOGI(TAG, "%s", summary);
+    if (result->state != MESHCORE_PATH_TRACE_STATE_COMPLETE) {
+        return;
+    }
+
+    for (uint8_t i = 0; i <= result->hop_count; i++) {
+        char from[3] = "us";
+        char to[3]   = "us";
+        if (i > 0) {
+            snprintf(from, sizeof(from), "%02X", result->hops[i - 1]);
+        }
+        if (i < result->hop_count) {
+            snprintf(to, sizeof(to), "%02X", result->hops[i]);
+        }
+        if (result->snr[i] == PACKET_SNR_UNKNOWN) {
+            ESP_LOGI(TAG, "  %s -> %s: SNR unknown", from, to);
+        } else {
+            ESP_LOGI(TAG, "  %s -> %s: SNR %.2f dB", from, to, result->snr[i] / 4.0);
         }
-        printf("\n");
     }
+}
 
-    if (message.type == MESHCORE_PAYLOAD_TYPE_ADVERT) {
-        meshcore_advert_t advert;
-        if (meshcore_advert_deserialize(message.payload, message.payload_length, &advert) >= 0) {
-            printf("Decoded node advertisement:\n");
-            printf("Public Key: ");
-            for (unsigned int i = 0; i < MESHCORE_PUB_KEY_SIZE; i++) {
-                printf("%02X", advert.pub_key[i]);
+void meshcore_parse(packet_buffer_t* buffer) {
+    meshcore_message_t* message = &buffer->message;
+    uint32_t            start   = perf_begin();
+    int                 res     = meshcore_deserialize(buffer->packet.data, buffer->packet.length, message);
+    perf_end(PERF_STAGE_DECODE, start);
+    if (res < 0) {
+        ESP_LOGE(TAG, "Failed to deserialize message");
+        perf_count_drop(PERF_DROP_MALFORMED);
+        return;
+    }
+    perf_count_type(message->type);
+
+    // Drop floods scoped to regions we do not know before any payload is decoded or decrypted
+    if (!region_manager_in_scope(message)) {
+        MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_DEBUG, MESHCORE_TRACE_PACKET, "Out of scope, transport code %04X",
+                       message->transport_codes[0]);
+        perf_count_drop(PERF_DROP_SCOPE);
+        return;
+    }
+
+    MESHCORE_TRACE_STR(MESHCORE_TRACE_LEVEL_DEBUG, MESHCORE_TRACE_PACKET, "Type: %s", type_to_string(message->type));
+    MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_DEBUG, MESHCORE_TRACE_PACKET, "Route: %u, version: %u, path length: %u",
+                   message->route, message->version, message->path_length);
+    MESHCORE_TRACE_HEX(MESHCORE_TRACE_LEVEL_VERBOSE, MESHCORE_TRACE_PACKET, "Path: ", message->path,
+                       message->path_length);
+    MESHCORE_TRACE_HEX(MESHCORE_TRACE_LEVEL_VERBOSE, MESHCORE_TRACE_PACKET, "Payload: ", message->payload,
+                       message->payload_length);
+
+    if (message->type == MESHCORE_PAYLOAD_TYPE_ADVERT) {
+        meshcore_advert_t*       advert = &buffer->payload.advert;
+        meshcore_advert_signed_t signed_data;
+        start = perf_begin();
+        res   = meshcore_advert_decode(message->payload, message->payload_length, advert, &signed_data);
+        perf_end(PERF_STAGE_PAYLOAD, start);
+        if (res >= 0) {
+            MESHCORE_TRACE_HEX(MESHCORE_TRACE_LEVEL_DEBUG, MESHCORE_TRACE_ADVERT, "Public key: ", advert->pub_key,
+                               MESHCORE_PUB_KEY_SIZE);
+            MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_DEBUG, MESHCORE_TRACE_ADVERT, "Timestamp: %" PRIu32, advert->timestamp);
+            MESHCORE_TRACE_STR(MESHCORE_TRACE_LEVEL_DEBUG, MESHCORE_TRACE_ADVERT, "Role: %s",
+                               role_to_string(advert->role));
+            MESHCORE_TRACE_HEX(MESHCORE_TRACE_LEVEL_VERBOSE, MESHCORE_TRACE_ADVERT, "Signature: ", advert->signature,
+                               MESHCORE_SIGNATURE_SIZE);
+            if (advert->position_valid) {
+                MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_DEBUG, MESHCORE_TRACE_ADVERT,
+                               "Position: lat=%" PRIi32 ", lon=%" PRIi32, advert->position_lat, advert->position_lon);
             }
-            printf("\n");
-            printf("Timestamp: %" PRIu32 "\n", advert.timestamp);
-            printf("Signature: ");
-            for (unsigned int i = 0; i < MESHCORE_SIGNATURE_SIZE; i++) {
-                printf("%02X", advert.signature[i]);
+            if (advert->extra1_valid || advert->extra2_valid) {
+                MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_DEBUG, MESHCORE_TRACE_ADVERT, "Extra: %u, %u", advert->extra1,
+                               advert->extra2);
             }
-            printf("\n");
-            printf("Role: %s\n", role_to_string(advert.role));
-            if (advert.position_valid) {
-                printf("Position: lat=%" PRIi32 ", lon=%" PRIi32 "\n", advert.position_lat, advert.position_lon);
-            } else {
-                printf("Position: (not available)\n");
+            if (advert->name_valid) {
+                MESHCORE_TRACE_STR(MESHCORE_TRACE_LEVEL_DEBUG, MESHCORE_TRACE_ADVERT, "Name: %s", advert->name);
             }
-            if (advert.extra1_valid) {
-                printf("Extra1: %u\n", advert.extra1);
+
+            MESHCORE_TRACE_HEX(MESHCORE_TRACE_LEVEL_VERBOSE, MESHCORE_TRACE_ADVERT, "App data: ",
+                               signed_data.parts[1].data, signed_data.parts[1].length);
+
+            if (verify_advert(advert, &signed_data)) {
+                MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_INFO, MESHCORE_TRACE_ADVERT, "Advertisement signature valid");
+                const uint8_t* own_private_key = own_identity != NULL ? own_identity->private_key : NULL;
+                xSemaphoreTake(contacts_mutex, portMAX_DELAY);
+                meshcore_contact_t* contact = meshcore_contacts_update(&contacts, advert, own_private_key);
+                xSemaphoreGive(contacts_mutex);
+                if (contact == NULL) {
+                    MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_WARN, MESHCORE_TRACE_ADVERT,
+                                   "Contact table full, advertisement not stored");
+                }
+                blink_message_led(false, false, true);
             } else {
-                printf("Extra1: (not available)\n");
+                MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_WARN, MESHCORE_TRACE_ADVERT, "Advertisement signature invalid");
+                perf_count_drop(PERF_DROP_SIGNATURE);
             }
-            if (advert.extra2_valid) {
-                printf("Extra2: %u\n", advert.extra2);
+        } else {
+            MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_WARN, MESHCORE_TRACE_ADVERT, "Failed to decode advertisement");
+            perf_count_drop(PERF_DROP_PAYLOAD);
+        }
+    } else if (message->type == MESHCORE_PAYLOAD_TYPE_GRP_TXT) {
+        meshcore_grp_txt_t* grp_txt = &buffer->payload.grp_txt;
+        start                       = perf_begin();
+        res                         = meshcore_grp_txt_deserialize(message->payload, message->payload_length, grp_txt);
+        perf_end(PERF_STAGE_PAYLOAD, start);
+        if (res >= 0) {
+            MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_DEBUG, MESHCORE_TRACE_GROUP, "Channel hash: %02X, data length: %u",
+                           grp_txt->channel_hash, grp_txt->data_length);
+            MESHCORE_TRACE_HEX(MESHCORE_TRACE_LEVEL_VERBOSE, MESHCORE_TRACE_CRYPTO, "Received MAC: ", grp_txt->mac,
+                               MESHCORE_CIPHER_MAC_SIZE);
+
+            channel_info_t channel;
+            if (channel_manager_decrypt(grp_txt->channel_hash, grp_txt->mac, grp_txt->data, grp_txt->data_length,
+                                        &channel)) {
+                meshcore_grp_txt_data_t* data = &buffer->data.grp_txt;
+                meshcore_grp_txt_data_deserialize(grp_txt->data, grp_txt->data_length, data);
+
+                MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_DEBUG, MESHCORE_TRACE_GROUP,
+                               "Timestamp: %" PRIu32 ", text type: %u", data->timestamp, data->text_type);
+
+                char*  ptr      = data->text;
+                char*  text_ptr = data->text;
+                size_t len      = strlen(ptr);
+
+                for (size_t i = 0; i < len; i++) {
+                    ptr = &data->text[i];
+                    if (*ptr == ':') {
+                        *ptr = '\0';
+                        if (i + 2 < len) {
+                            text_ptr = ptr + 2;
+                        }
+                        break;
+                    }
+                }
+
+                bool handled = handle_chat_message(channel.id, data->text, text_ptr, data->timestamp, false, false);
+
+                blink_message_led(!handled, handled, false);
             } else {
-                printf("Extra2: (not available)\n");
+                perf_count_drop(PERF_DROP_MAC);
             }
-            if (advert.name_valid) {
-                printf("Name: %s\n", advert.name);
-            } else {
-                printf("Name: (not available)\n");
+        } else {
+            MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_WARN, MESHCORE_TRACE_GROUP, "Failed to decode group message");
+            perf_count_drop(PERF_DROP_PAYLOAD);
+        }
+    } else if (message->type == MESHCORE_PAYLOAD_TYPE_TXT_MSG) {
+        meshcore_txt_msg_t* txt_msg = &buffer->payload.txt_msg;
+        start                       = perf_begin();
+        res                         = meshcore_txt_msg_deserialize(message->payload, message->payload_length, txt_msg);
+        perf_end(PERF_STAGE_PAYLOAD, start);
+        if (res >= 0) {
+            MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_DEBUG, MESHCORE_TRACE_DIRECT, "Destination %02X, source %02X",
+                           txt_msg->destination_hash, txt_msg->source_hash);
+
+            if (own_identity == NULL || txt_msg->destination_hash != own_identity->hash) {
+                perf_count_drop(PERF_DROP_NOT_FOR_US);
+                return;
             }
 
-            memset(verification_data, 0, sizeof(verification_data));
-            size_t verification_data_size = 0;
-            memcpy(&verification_data[verification_data_size], advert.pub_key, MESHCORE_PUB_KEY_SIZE);
-            verification_data_size += MESHCORE_PUB_KEY_SIZE;
-            memcpy(&verification_data[verification_data_size], &advert.timestamp, sizeof(uint32_t));
-            verification_data_size += sizeof(uint32_t);
-            memcpy(&verification_data[verification_data_size],
-                   &message.payload[MESHCORE_PUB_KEY_SIZE + sizeof(uint32_t) + MESHCORE_SIGNATURE_SIZE],
-                   message.payload_length - MESHCORE_PUB_KEY_SIZE - sizeof(uint32_t) - MESHCORE_SIGNATURE_SIZE);
-            verification_data_size +=
-                message.payload_length - MESHCORE_PUB_KEY_SIZE - sizeof(uint32_t) - MESHCORE_SIGNATURE_SIZE;
-
-            printf("Key for signature verification: ");
-            for (size_t i = 0; i < MESHCORE_PUB_KEY_SIZE; i++) {
-                printf("%02X", advert.pub_key[i]);
+            // Only contacts with a matching hash are tried, normally this is a single key. The sender is copied out
+            // so the table can change while the message is handled.
+            meshcore_contact_t  sender  = {0};
+            meshcore_contact_t* contact = NULL;
+            xSemaphoreTake(contacts_mutex, portMAX_DELAY);
+            while ((contact = meshcore_contacts_find_by_hash(&contacts, txt_msg->source_hash, contact)) != NULL) {
+                if (verify_and_decrypt(contact->shared_secret, MESHCORE_SHARED_SECRET_SIZE, txt_msg->cipher_mac,
+                                       txt_msg->ciphertext, txt_msg->ciphertext_length)) {
+                    sender = *contact;
+                    break;
+                }
             }
-            printf("\r\n");
+            xSemaphoreGive(contacts_mutex);
 
-            printf("Signature: ");
-            for (size_t i = 0; i < MESHCORE_SIGNATURE_SIZE; i++) {
-                printf("%02X", advert.signature[i]);
+            if (contact == NULL) {
+                MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_INFO, MESHCORE_TRACE_DIRECT,
+                               "Direct message from unknown contact or MAC mismatch");
+                perf_count_drop(PERF_DROP_MAC);
+                return;
             }
-            printf("\r\n");
 
-            printf("Data for signature verification: ");
-            for (size_t i = 0; i < verification_data_size; i++) {
-                printf("%02X", verification_data[i]);
+            meshcore_txt_msg_data_t* data = &buffer->data.txt_msg;
+            if (meshcore_txt_msg_data_deserialize(txt_msg->ciphertext, txt_msg->ciphertext_length, data) < 0) {
+                MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_WARN, MESHCORE_TRACE_DIRECT, "Failed to decode message data");
+                perf_count_drop(PERF_DROP_PAYLOAD);
+                return;
             }
-            printf("\r\n");
 
-            if (ed25519_verify(advert.signature, verification_data, verification_data_size, advert.pub_key)) {
-                printf("Advertisement signature verification SUCCESSFUL.\n");
-                blink_message_led(false, false, true);
-            } else {
-                printf("Warning: Advertisement signature verification FAILED!\n");
-            }
+            MESHCORE_TRACE_STR(MESHCORE_TRACE_LEVEL_DEBUG, MESHCORE_TRACE_DIRECT, "Direct message from %s",
+                               sender.name);
+            bool handled = handle_chat_message(sender.pub_key, sender.name, data->text, data->timestamp, false, true);
+            blink_message_led(!handled, handled, false);
         } else {
-            printf("Failed to decode node advertisement payload.\n");
-        }
-    } else if (message.type == MESHCORE_PAYLOAD_TYPE_GRP_TXT) {
-        meshcore_grp_txt_t grp_txt;
-        if (meshcore_grp_txt_deserialize(message.payload, message.payload_length, &grp_txt) >= 0) {
-            printf("Decoded group text message:\n");
-            printf("Channel Hash: %02X\n", grp_txt.channel_hash);
-            printf("Data Length: %d\n", grp_txt.data_length);
-            printf("Received MAC:");
-
-            for (unsigned int i = 0; i < MESHCORE_CIPHER_MAC_SIZE; i++) {
-                printf("%02X", grp_txt.mac[i]);
-            }
-            printf("\n");
+            MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_WARN, MESHCORE_TRACE_DIRECT, "Failed to decode direct message");
+            perf_count_drop(PERF_DROP_PAYLOAD);
+        }
+    } else if (message->type == MESHCORE_PAYLOAD_TYPE_GRP_DATA) {
+        group_data_receive(buffer);
+    } else if (message->type == MESHCORE_PAYLOAD_TYPE_TRACE && path_tracer_mutex != NULL) {
+        uint8_t                      index;
+        meshcore_path_trace_result_t result;
+        xSemaphoreTake(path_tracer_mutex, portMAX_DELAY);
+        res = meshcore_path_trace_handle(&path_tracer, message, buffer->rx.snr, buffer->rx.received_at,
+                                         esp_timer_get_time(), &index);
+        if (res == MESHCORE_PATH_TRACE_COMPLETE) {
+            result = path_tracer.results[index];
+        }
+        xSemaphoreGive(path_tracer_mutex);
+
+        if (res < 0) {
+            MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_WARN, MESHCORE_TRACE_ROUTE, "Malformed trace");
+            perf_count_drop(PERF_DROP_PAYLOAD);
+        } else if (res == MESHCORE_PATH_TRACE_FORWARD) {
+            MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_DEBUG, MESHCORE_TRACE_ROUTE, "Forwarding trace, hop %u",
+                           message->path_length);
+            transmit_buffer(buffer);
+        } else if (res == MESHCORE_PATH_TRACE_COMPLETE) {
+            log_trace_result(&result);
+            show_trace_result(&result);
+        }
+    } else if (message->type == MESHCORE_PAYLOAD_TYPE_MULTIPART) {
+        multipart_manager_receive(buffer);
+    } else {
+        perf_count_drop(PERF_DROP_UNHANDLED);
+    }
+}
 
-            printf("Data [%d]: ", grp_txt.data_length);
-            for (unsigned int i = 0; i < grp_txt.data_length; i++) {
-                printf("%02X", grp_txt.data[i]);
-            }
-            printf("\n");
+// Send our own advert when one is due and return how long the meshcore task may sleep until the next one
+static TickType_t run_self_advert(void) {
+    if (own_identity == NULL) {
+        return portMAX_DELAY;
+    }
 
-            // TO-DO: all of this MAC verification and decryption should be moved somewhere else
+    int64_t               now = esp_timer_get_time() / 1000;
+    meshcore_route_type_t route;
+    int64_t               wait = meshcore_self_advert_due(&self_advert, now, &route);
+    if (atomic_exchange(&advert_requested, false)) {
+        route = MESHCORE_ROUTE_TYPE_FLOOD;
+        wait  = 0;
+    }
+    if (wait > 0) {
+        return pdMS_TO_TICKS(wait);
+    }
 
-            for (uint8_t i = 0; i < 1; i++) {
-                uint8_t* key = mc_keys[i];
+    packet_buffer_t* buffer = packet_pool_alloc();
+    if (buffer == NULL) {
+        return pdMS_TO_TICKS(1000);  // Try again once received packets have been handled
+    }
+    meshcore_message_t* message = &buffer->message;
+    if (meshcore_self_advert_build(&self_advert, route, (uint32_t)time(NULL), now, esp_random(), message) < 0) {
+        ESP_LOGE(TAG, "Failed to build advertisement");
+        packet_pool_free(buffer);
+        return pdMS_TO_TICKS(1000);
+    }
+    ESP_LOGI(TAG, "Sending %s advertisement", route == MESHCORE_ROUTE_TYPE_FLOOD ? "flood" : "zero-hop");
+    transmit_buffer(buffer);
+    packet_pool_free(buffer);
 
-                uint8_t out[128];
-                size_t out_len = hmac_sha256(key, 16, grp_txt.data, grp_txt.data_length, out, MESHCORE_CIPHER_MAC_SIZE);
+    return pdMS_TO_TICKS(meshcore_self_advert_due(&self_advert, now, &route));
+}
 
-                printf("Calculated MAC [%d]: ", out_len);
-                for (unsigned int i = 0; i < out_len; i++) {
-                    printf("%02X", out[i]);
-                }
-                printf("\n");
+static void meshcore_task(void* pvParameters) {
+    while (1) {
+        // Wakes up for received packets, when our own advert is due or when the message LED has to go off
+        TickType_t wait           = run_self_advert();
+        TickType_t multipart_wait = multipart_manager_run();
+        TickType_t led_wait       = run_message_led();
+        wait                      = multipart_wait < wait ? multipart_wait : wait;
+        ulTaskNotifyTake(pdTRUE, led_wait < wait ? led_wait : wait);
+
+        // Drain everything that arrived, bursts are handled without waiting for another notification
+        packet_descriptor_t descriptor;
+        while (packet_ring_pop(&rx_ring, &descriptor)) {
+            descriptor.buffer->rx = descriptor.rx;
+            capture_frame(&descriptor.rx, descriptor.rx.received_at, false, descriptor.buffer->packet.data,
+                          descriptor.buffer->packet.length);
+            uint32_t start = perf_begin();
+            meshcore_parse(descriptor.buffer);
+            perf_end(PERF_STAGE_PARSE, start);
+            packet_pool_free(descriptor.buffer);
+        }
+    }
+    vTaskDelete(NULL);
+}
 
-                if (memcmp(out, grp_txt.mac, MESHCORE_CIPHER_MAC_SIZE) == 0) {
-                    printf("MAC verification: SUCCESS\n");
+static uint32_t row_key(uint32_t hash, const void* data, size_t length) {
+    // FNV-1a
+    const uint8_t* bytes = data;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash == CHAT_ROW_NONE ? 1 : hash;
+}
 
-                    // Decrypt data (in-place)
-                    struct AES_ctx ctx;
-                    AES_init_ctx(&ctx, key);
-                    for (uint8_t i = 0; i < (grp_txt.data_length / 16); i++) {
-                        AES_ECB_decrypt(&ctx, &grp_txt.data[i * 16]);
-                    }
+// Clear a chat row and mark it for the next flush
+static int clear_chat_row(size_t row) {
+    int y = CHAT_ROW_TOP + row * CHAT_ROW_HEIGHT;
+    pax_simple_rect(&fb, BLACK, 0, y, pax_buf_get_width(&fb), CHAT_ROW_HEIGHT);
+    screen_mark_dirty(0, y, pax_buf_get_width(&fb), CHAT_ROW_HEIGHT);
+    return y;
+}
 
-                    meshcore_grp_txt_data_t data = {0};
-                    meshcore_grp_txt_data_deserialize(grp_txt.data, grp_txt.data_length, &data);
-
-                    printf("Timestamp: %" PRIu32 "\n", data.timestamp);
-                    printf("Text Type: %u\n", data.text_type);
-                    printf("Message: '%s'\n", data.text);
-
-                    char*  ptr      = data.text;
-                    char*  text_ptr = data.text;
-                    size_t len      = strlen(ptr);
-
-                    for (size_t i = 0; i < len; i++) {
-                        ptr = &data.text[i];
-                        if (*ptr == ':') {
-                            *ptr = '\0';
-                            if (i + 2 < len) {
-                                text_ptr = ptr + 2;
-                            }
-                            break;
-                        }
-                    }
+// Draw one wrapped line of a message, the first line also carries the sender prefix
+static void render_chat_line(size_t row, const chat_arena_record_t* message, const chat_layout_t* layout,
+                             uint8_t line) {
+    int      y     = clear_chat_row(row);
+    uint32_t color = (message->repeated && message->sent) ? 0xFF00FF00 : (message->sent ? 0xFFFFFF00 : WHITE);
+    int      x     = 0;
+
+    if (line == 0) {
+        char prefix[CHAT_LAYOUT_PREFIX_MAX];
+        chat_layout_prefix(message, prefix, sizeof(prefix));
+        pax_draw_text(&fb, color, pax_font_saira_regular, 16, 0, y, prefix);
+        x = layout->prefix_width;
+    }
+
+    if (line < layout->line_count && layout->line_length[line] > 0) {
+        char text[CHAT_MESSAGE_TEXT_SIZE];
+        memcpy(text, &message->text[layout->line_start[line]], layout->line_length[line]);
+        text[layout->line_length[line]] = '\0';
+        pax_draw_text(&fb, color, pax_font_saira_regular, 16, x, y, text);
+    }
+}
 
-                    bool handled =
-                        handle_chat_message(grp_txt.channel_hash, data.text, text_ptr, data.timestamp, false);
+void render_chat(void) {
+    chat_arena_record_t  records[CHAT_ROW_COUNT];
+    const chat_layout_t* layouts[CHAT_ROW_COUNT];
+    uint8_t              lines[CHAT_ROW_COUNT];
 
-                    blink_message_led(!handled, handled, false);
-                    break;
-                } else {
-                    printf("MAC verification: FAILURE (key %u)\n", i);
-                }
-            }
+    xSemaphoreTake(chat_mutex, portMAX_DELAY);
+
+    // Fill the rows bottom-up with the wrapped lines of the newest messages
+    size_t row = CHAT_ROW_COUNT;
+    for (size_t i = chat_arena_count(&chat_window); i > 0 && row > 0; i--) {
+        chat_arena_record_t record;
+        if (!chat_arena_get(&chat_window, i - 1, &record)) {
+            break;
+        }
+        const chat_layout_t* layout = chat_layout_get(&chat_layouts, &record);
+        for (uint8_t line = layout->line_count; line > 0 && row > 0; line--) {
+            row--;
+            records[row] = record;
+            layouts[row] = layout;
+            lines[row]   = line - 1;
+        }
+    }
+    size_t first_row = row;
+
+    for (row = 0; row < CHAT_ROW_COUNT; row++) {
+        uint32_t key = CHAT_ROW_NONE;
+        if (row >= first_row) {
+            const chat_arena_record_t* message = &records[row];
+            uint8_t flags = (message->sent ? 1 : 0) | (message->repeated ? 2 : 0) | (message->direct ? 4 : 0);
+            key           = row_key(CHAT_ROW_KEY_SEED, &message->id, sizeof(message->id));
+            key           = row_key(key, &lines[row], sizeof(lines[row]));
+            key           = row_key(key, &flags, sizeof(flags));
+        }
+        if (chat_row_keys[row] == key) {
+            continue;
+        }
+        chat_row_keys[row] = key;
+        if (key == CHAT_ROW_NONE) {
+            clear_chat_row(row);
         } else {
-            printf("Failed to decode group text message payload.\n");
+            render_chat_line(row, &records[row], layouts[row], lines[row]);
         }
     }
-}
 
-static void meshcore_task(void* pvParameters) {
-    while (1) {
-        lora_protocol_lora_packet_t packet = {0};
-        if (lora_receive_packet(&packet, portMAX_DELAY) == ESP_OK) {
-            meshcore_parse(&packet);
+    // A notice replaces the status until the next key press
+    char     status[CHAT_STATUS_SIZE] = {0};
+    uint32_t color                    = 0xFF808080;
+    if (chat_notice[0] != '\0') {
+        snprintf(status, sizeof(status), "%s", chat_notice);
+        color = WHITE;
+    } else if (chat_store != NULL) {
+        const uint8_t* id                                            = message_store_get_id(chat_store);
+        char           name[MESHCORE_CHANNEL_NAME_SIZE + sizeof('\0')] = {0};
+        if (message_store_is_direct(chat_store) || !channel_manager_get_name(id, name, sizeof(name))) {
+            snprintf(name, sizeof(name), "%02X%02X%02X%02X", id[0], id[1], id[2], id[3]);
         }
-    }
-    vTaskDelete(NULL);
-}
 
-void render_chat(void) {
-    pax_simple_rect(&fb, BLACK, 0, 64, pax_buf_get_width(&fb), pax_buf_get_height(&fb) - 128);
-    size_t amount_of_messages = sizeof(chat_messages) / sizeof(chat_message_t);
-    for (size_t i = 0; i < amount_of_messages; i++) {
-        chat_message_t* message = &chat_messages[(chat_message_index + i) % amount_of_messages];
-        if (message->timestamp != 0) {
-            char text[CHAT_MESSAGE_NAME_SIZE + CHAT_MESSAGE_TEXT_SIZE + 4];
-            snprintf(text, sizeof(text), "%s: %s", message->name, message->text);
-            pax_draw_text(&fb, (message->repeated && message->sent) ? 0xFF00FF00 : (message->sent ? 0xFFFFFF00 : WHITE),
-                          pax_font_saira_regular, 16, 0, 72 + (i * 20), text);
+        // Unread messages in the other stores
+        size_t unread = 0;
+        for (message_store_t* store = message_store_next(chat_store); store != chat_store;
+             store                  = message_store_next(store)) {
+            unread += message_store_get_unread(store);
+        }
+
+        const char* kind   = message_store_is_direct(chat_store) ? "DM" : "Channel";
+        int         length = snprintf(status, sizeof(status), "%s %s%s", kind, name,
+                                      chat_scroll > 0 ? " (scrolled back)" : "");
+        if (unread > 0 && length > 0 && (size_t)length < sizeof(status)) {
+            snprintf(&status[length], sizeof(status) - length, ", %u unread elsewhere", (unsigned int)unread);
         }
     }
-    blit();
+    uint32_t key = row_key(CHAT_ROW_KEY_SEED, status, strlen(status));
+    key          = row_key(key, &color, sizeof(color));
+    if (chat_row_keys[CHAT_STATUS_ROW] != key) {
+        chat_row_keys[CHAT_STATUS_ROW] = key;
+        int y                          = clear_chat_row(CHAT_STATUS_ROW);
+        pax_draw_text(&fb, color, pax_font_saira_regular, 16, 0, y, status);
+    }
+    xSemaphoreGive(chat_mutex);
+    screen_flush();
 }
 
 void handle_input(char input) {
@@ -419,84 +936,526 @@ void handle_input(char input) {
 
     pax_simple_rect(&fb, BLACK, 0, pax_buf_get_height(&fb) - 64, pax_buf_get_width(&fb), 64);
     pax_draw_text(&fb, 0xFFFFFF00, pax_font_saira_regular, 16, 0, pax_buf_get_height(&fb) - 64 + 16, text_buffer);
-    blit();
+    screen_mark_dirty(0, pax_buf_get_height(&fb) - 64, pax_buf_get_width(&fb), 64);
+    screen_flush();
 }
 
-void send_input(void) {
-    if (strlen(text_buffer) == 0) {
+static void send_direct_message(const meshcore_contact_t* contact, const char* text) {
+    packet_buffer_t* buffer = packet_pool_alloc();
+    if (buffer == NULL) {
+        ESP_LOGE(TAG, "No packet buffer available");
         return;
     }
-    printf("Sending message: '%s'\n", text_buffer);
 
-    char nickname[CHAT_MESSAGE_NAME_SIZE] = {0};
-    device_settings_get_owner_nickname(nickname, sizeof(nickname));
+    meshcore_txt_msg_data_t* data = &buffer->data.txt_msg;
+    data->timestamp               = (uint32_t)time(NULL);
+    data->text_type               = MESHCORE_TXT_TYPE_PLAIN;
+    data->attempt                 = 0;
+    snprintf(data->text, sizeof(data->text), "%s", text);
+
+    meshcore_txt_msg_t* txt_msg = &buffer->payload.txt_msg;
+    txt_msg->destination_hash   = meshcore_contact_hash(contact->pub_key);
+    txt_msg->source_hash        = own_identity->hash;
+
+    meshcore_txt_msg_data_serialize(data, txt_msg->ciphertext, &txt_msg->ciphertext_length);
+    if (meshcore_encrypt_then_mac(contact->shared_secret, MESHCORE_SHARED_SECRET_SIZE, txt_msg->ciphertext,
+                                  txt_msg->ciphertext_length, sizeof(txt_msg->ciphertext),
+                                  &txt_msg->ciphertext_length, txt_msg->cipher_mac) < 0) {
+        ESP_LOGE(TAG, "Failed to encrypt direct message");
+        packet_pool_free(buffer);
+        return;
+    }
+
+    meshcore_message_t* message = &buffer->message;
+    message->type               = MESHCORE_PAYLOAD_TYPE_TXT_MSG;
+    message->route              = MESHCORE_ROUTE_TYPE_FLOOD;
+    message->version            = 0x00;
+    meshcore_txt_msg_serialize(txt_msg, message->payload, &message->payload_length);
+
+    transmit_buffer(buffer);
+    packet_pool_free(buffer);
+}
+
+static void send_group_message(const uint8_t* channel_id, const char* nickname, const char* text) {
+    packet_buffer_t* buffer = packet_pool_alloc();
+    if (buffer == NULL) {
+        ESP_LOGE(TAG, "No packet buffer available");
+        return;
+    }
 
-    char message_text[256] = {0};
-    snprintf(message_text, sizeof(message_text), "%s: %s", nickname, text_buffer);
-    meshcore_grp_txt_t grp_txt = {0};
-    grp_txt.channel_hash       = 0x11;  // #public
+    meshcore_grp_txt_t* grp_txt = &buffer->payload.grp_txt;
+    grp_txt->channel_hash       = channel_id[0];
 
     // Data to be encrypted
-    meshcore_grp_txt_data_t data = {0};
-    data.timestamp               = (uint32_t)time(NULL);
-    data.text_type               = 0x00;  // plain text
-    memcpy(data.text, message_text, strlen(message_text));
+    meshcore_grp_txt_data_t* data = &buffer->data.grp_txt;
+    data->timestamp               = (uint32_t)time(NULL);
+    data->text_type               = 0x00;  // plain text
+    snprintf(data->text, sizeof(data->text), "%s: %s", nickname, text);
 
     // Add message to chatlog
-    handle_chat_message(grp_txt.channel_hash, nickname, text_buffer, data.timestamp, true);
+    handle_chat_message(channel_id, nickname, text, data->timestamp, true, false);
 
     // Pack data
-    meshcore_grp_txt_data_serialize(&data, grp_txt.data, &grp_txt.data_length);
+    meshcore_grp_txt_data_serialize(data, grp_txt->data, &grp_txt->data_length);
 
-    // Encrypt data
-    uint8_t encrypt_length = grp_txt.data_length;
-    while (encrypt_length % 16 != 0) {
-        encrypt_length++;
+    // Encrypt data and calculate MAC
+    if (!channel_manager_encrypt(channel_id, grp_txt->data, grp_txt->data_length, sizeof(grp_txt->data),
+                                 &grp_txt->data_length, grp_txt->mac)) {
+        ESP_LOGE(TAG, "Failed to encrypt message");
+        packet_pool_free(buffer);
+        return;
     }
-    for (uint8_t i = grp_txt.data_length; i < encrypt_length; i++) {
-        grp_txt.data[i] = 0;
+
+    printf("Encrypted data [%d]: ", grp_txt->data_length);
+    for (size_t i = 0; i < grp_txt->data_length; i++) {
+        printf("%02X", grp_txt->data[i]);
     }
-    printf("Data length = %u, encrypt length = %u\n", grp_txt.data_length, encrypt_length);
+    printf("\n");
+
+    // Assemble message
+    meshcore_message_t* message = &buffer->message;
+    message->type               = MESHCORE_PAYLOAD_TYPE_GRP_TXT;
+    message->route              = MESHCORE_ROUTE_TYPE_FLOOD;
+    message->version            = 0x00;
+    meshcore_grp_txt_serialize(grp_txt, message->payload, &message->payload_length);
+
+    transmit_buffer(buffer);
+    packet_pool_free(buffer);
+}
+
+static void report_memory_usage(void) {
+    chat_arena_usage_t usage;
+    xSemaphoreTake(chat_mutex, portMAX_DELAY);
+    chat_arena_get_usage(&chat_window, &usage);
+    xSemaphoreGive(chat_mutex);
+    ESP_LOGI(TAG, "Chat window: %u messages, %u/%u bytes, %u names in %u bytes (%u bytes as fixed size messages)",
+             (unsigned int)usage.records, (unsigned int)usage.record_bytes, (unsigned int)usage.capacity,
+             (unsigned int)usage.names, (unsigned int)usage.name_bytes, (unsigned int)usage.fixed_equivalent);
+    ESP_LOGI(TAG, "Redraws: %u requested, %u drawn", (unsigned int)redraw_requests, (unsigned int)redraws);
+    ESP_LOGI(TAG, "Layout cache: %u hits, %u misses", (unsigned int)chat_layouts.hits,
+             (unsigned int)chat_layouts.misses);
+    screen_stats_t screen;
+    screen_get_stats(&screen);
+    ESP_LOGI(TAG, "Display: %u flushes (%u full), last %u bytes in %u us, max %u us, average %u bytes",
+             (unsigned int)screen.frames, (unsigned int)screen.full_frames, (unsigned int)screen.last_bytes,
+             (unsigned int)screen.last_time_us, (unsigned int)screen.max_time_us,
+             screen.frames ? (unsigned int)(screen.bytes / screen.frames) : 0);
+    ESP_LOGI(TAG, "Display transfers: last %u us, max %u us, %u flushes waited for a free buffer",
+             (unsigned int)screen.last_blit_us, (unsigned int)screen.max_blit_us, (unsigned int)screen.waits);
+    ESP_LOGI(TAG, "Heap: %u bytes free, %u bytes minimum free", (unsigned int)esp_get_free_heap_size(),
+             (unsigned int)esp_get_minimum_free_heap_size());
+}
 
-    uint8_t*       key = mc_keys[0];  // #public
-    struct AES_ctx ctx;
-    AES_init_ctx(&ctx, key);
-    for (uint8_t i = 0; i < (encrypt_length / 16); i++) {
-        AES_ECB_encrypt(&ctx, &grp_txt.data[i * 16]);
+static void report_pipeline_stats(bool reset) {
+    perf_report();
+    ESP_LOGI(TAG, "RX ring: %u received, %u overflows, %u without buffer, high water %u, %u buffers free",
+             (unsigned int)rx_ring.stats.received, (unsigned int)rx_ring.stats.overflows,
+             (unsigned int)rx_ring.stats.no_buffer, (unsigned int)rx_ring.stats.high_water,
+             (unsigned int)packet_pool_get_free());
+    meshcore_trace_stats_t trace;
+    meshcore_trace_get_stats(&trace);
+    ESP_LOGI(TAG, "Trace: %u records, %u dropped", (unsigned int)trace.written, (unsigned int)trace.dropped);
+    ESP_LOGI(TAG, "Self advert: %u sent", (unsigned int)self_advert.sent);
+    meshcore_multipart_stats_t stats;
+    if (multipart_manager_get_stats(&stats)) {
+        ESP_LOGI(TAG, "Multipart: %u fragments sent, %u received, %u completed, %u expired, %u without buffer",
+                 (unsigned int)stats.fragments_sent, (unsigned int)stats.fragments_received,
+                 (unsigned int)stats.completed, (unsigned int)stats.expired, (unsigned int)stats.no_buffer);
+        ESP_LOGI(TAG, "Multipart resend requests: %u sent, %u received", (unsigned int)stats.requests_sent,
+                 (unsigned int)stats.requests_received);
     }
+    if (path_tracer_mutex != NULL) {
+        xSemaphoreTake(path_tracer_mutex, portMAX_DELAY);
+        uint32_t forwarded = path_tracer.forwarded;
+        int64_t  total     = path_tracer.forward_delay_total;
+        int64_t  max       = path_tracer.forward_delay_max;
+        xSemaphoreGive(path_tracer_mutex);
+        ESP_LOGI(TAG, "Traces: %u forwarded, %u us average and %u us maximum from reception to forward",
+                 (unsigned int)forwarded, forwarded ? (unsigned int)(total / forwarded) : 0, (unsigned int)max);
+    }
+    if (reset) {
+        perf_reset();
+    }
+}
 
-    printf("Encrypted data [%d]: ", encrypt_length);
-    for (size_t i = 0; i < encrypt_length; i++) {
-        printf("%02X", grp_txt.data[i]);
+static void toggle_capture(void) {
+    if (capture_is_active()) {
+        capture_stop();
+        capture_stats_t stats;
+        capture_get_stats(&stats);
+        ESP_LOGI(TAG, "Capture stopped: %u frames, %u dropped, %u bytes in %u writes, longest write %u us",
+                 (unsigned int)stats.frames, (unsigned int)stats.dropped, (unsigned int)stats.bytes,
+                 (unsigned int)stats.writes, (unsigned int)stats.max_write_us);
+        return;
     }
-    printf("\n");
-    grp_txt.data_length = encrypt_length;
 
-    // Calculate MAC
-    size_t size = hmac_sha256(key, 16, grp_txt.data, grp_txt.data_length, grp_txt.mac, MESHCORE_CIPHER_MAC_SIZE);
-    printf("Calculated MAC [%d]: ", size);
-    for (unsigned int i = 0; i < size; i++) {
-        printf("%02X", grp_txt.mac[i]);
+    char      path[64];
+    esp_err_t res = capture_start(path, sizeof(path));
+    if (res == ESP_OK) {
+        ESP_LOGI(TAG, "Capturing frames to %s", path);
+    } else {
+        ESP_LOGE(TAG, "Failed to start capture: %s", esp_err_to_name(res));
     }
-    printf("\n");
+}
 
-    // Assemble message
-    meshcore_message_t message = {0};
-    message.type               = MESHCORE_PAYLOAD_TYPE_GRP_TXT;
-    message.route              = MESHCORE_ROUTE_TYPE_FLOOD;
-    message.version            = 0x00;
-    meshcore_grp_txt_serialize(&grp_txt, message.payload, &message.payload_length);
+// Channel the input is sent to, the one being viewed or else the first subscribed channel
+static bool get_send_channel(uint8_t* out_id) {
+    xSemaphoreTake(chat_mutex, portMAX_DELAY);
+    bool found = chat_store != NULL && !message_store_is_direct(chat_store);
+    if (found) {
+        memcpy(out_id, message_store_get_id(chat_store), MESHCORE_CHANNEL_ID_SIZE);
+    }
+    xSemaphoreGive(chat_mutex);
+    if (found) {
+        return true;
+    }
+
+    channel_info_t channel;
+    if (channel_manager_list(&channel, 1) == 1) {
+        memcpy(out_id, channel.id, MESHCORE_CHANNEL_ID_SIZE);
+        return true;
+    }
+    return false;
+}
+
+// Receivers of a multipart test payload check and log it
+static void handle_multipart_test(const meshcore_multipart_result_t* result, const uint8_t* data, void* context) {
+    size_t mismatch = 0;
+    for (size_t i = 0; i < result->length; i++) {
+        mismatch += data[i] != (uint8_t)i;
+    }
+    ESP_LOGI(TAG, "Reassembled %u byte %s payload %u from %02X, %u bytes differ", (unsigned int)result->length,
+             type_to_string(result->type), result->sequence, result->source, (unsigned int)mismatch);
+}
+
+// Flood a test payload of the given size in fragments, the receivers log it once it is reassembled
+static void send_multipart_test(const char* argument) {
+    size_t length = strtoul(argument, NULL, 10);
+    if (length == 0 || length > MESHCORE_MULTIPART_MAX_SIZE) {
+        ESP_LOGE(TAG, "Multipart test payloads are 1 to %u bytes", (unsigned int)MESHCORE_MULTIPART_MAX_SIZE);
+        return;
+    }
+
+    static uint8_t data[MESHCORE_MULTIPART_MAX_SIZE];
+    for (size_t i = 0; i < length; i++) {
+        data[i] = (uint8_t)i;
+    }
+
+    uint8_t   sequence;
+    esp_err_t res = multipart_manager_send(MESHCORE_PAYLOAD_TYPE_RAW_CUSTOM, data, length, &sequence);
+    if (res != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to send a multipart payload: %s", esp_err_to_name(res));
+        return;
+    }
+    ESP_LOGI(TAG, "Sending %u bytes as multipart payload %u", (unsigned int)length, sequence);
+    xTaskNotifyGive(meshcore_task_handle);
+}
+
+// "/trace 20,30" traces a round trip through the nodes with the given hashes, the last one turns it around
+static void start_trace(const char* argument) {
+    uint8_t hops[MESHCORE_PATH_TRACE_MAX_HOPS];
+    uint8_t hop_count = 0;
+    while (*argument != '\0' && hop_count < sizeof(hops)) {
+        unsigned int value;
+        int          consumed = 0;
+        if (sscanf(argument, " %2x%n", &value, &consumed) != 1) {
+            break;
+        }
+        hops[hop_count++]  = (uint8_t)value;
+        argument          += consumed;
+        argument          += strspn(argument, " ,");
+    }
+    if (path_tracer_mutex == NULL || hop_count == 0 || *argument != '\0') {
+        ESP_LOGE(TAG, "Usage: /trace <hop hash>,<hop hash>,...");
+        return;
+    }
 
-    lora_protocol_lora_packet_t packet = {0};
-    int                         result = meshcore_serialize(&message, packet.data, &packet.length);
+    packet_buffer_t* buffer = packet_pool_alloc();
+    if (buffer == NULL) {
+        ESP_LOGE(TAG, "No packet buffer available");
+        return;
+    }
+    xSemaphoreTake(path_tracer_mutex, portMAX_DELAY);
+    int      index = meshcore_path_trace_originate(&path_tracer, hops, hop_count, true, esp_timer_get_time(),
+                                                   &buffer->message);
+    uint32_t tag   = index >= 0 ? path_tracer.results[index].tag : 0;
+    xSemaphoreGive(path_tracer_mutex);
+    if (index < 0) {
+        ESP_LOGE(TAG, "Too many hops to trace");
+    } else if (transmit_buffer(buffer)) {
+        ESP_LOGI(TAG, "Trace %08" PRIX32 " sent", tag);
+    }
+    packet_pool_free(buffer);
+}
 
-    if (result >= 0) {
-        ESP_LOGI(TAG, "Message serialized successfully, length: %d", packet.length);
+static void list_traces(void) {
+    meshcore_path_trace_result_t results[MESHCORE_PATH_TRACE_RESULTS];
+    xSemaphoreTake(path_tracer_mutex, portMAX_DELAY);
+    meshcore_path_trace_expire(&path_tracer, esp_timer_get_time());
+    memcpy(results, path_tracer.results, sizeof(results));
+    uint8_t oldest = path_tracer.next_result;
+    xSemaphoreGive(path_tracer_mutex);
+
+    // All results go to the log, the newest one is shown on screen
+    const meshcore_path_trace_result_t* newest = NULL;
+    for (uint8_t i = 0; i < MESHCORE_PATH_TRACE_RESULTS; i++) {
+        const meshcore_path_trace_result_t* result = &results[(oldest + i) % MESHCORE_PATH_TRACE_RESULTS];
+        log_trace_result(result);
+        if (result->state != MESHCORE_PATH_TRACE_STATE_FREE) {
+            newest = result;
+        }
+    }
+    if (newest != NULL) {
+        show_trace_result(newest);
     } else {
-        ESP_LOGE(TAG, "Failed to serialize message");
+        show_notice("No traces");
+    }
+}
+
+// "/join #hashtag" or "/join name secret", the secret is given in hex
+static void join_channel(char* arguments) {
+    char* secret = strchr(arguments, ' ');
+    if (secret != NULL) {
+        *secret++ = '\0';
+    }
+
+    channel_info_t channel;
+    esp_err_t      res = channel_manager_join(arguments, secret, &channel);
+    if (res != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to join channel %s: %s", arguments, esp_err_to_name(res));
         return;
     }
-    lora_send_packet(&packet);
+    ESP_LOGI(TAG, "Joined channel %s (%02X)", channel.name, channel.hash);
+
+    xSemaphoreTake(chat_mutex, portMAX_DELAY);
+    message_store_t* store = message_store_open(channel.id, false);
+    if (store != NULL) {
+        chat_store  = store;
+        chat_scroll = 0;
+        message_store_mark_read(chat_store);
+        load_chat_page();
+    }
+    xSemaphoreGive(chat_mutex);
+}
+
+static void leave_channel(const char* name) {
+    channel_info_t channel;
+    esp_err_t      res = channel_manager_leave(name, &channel);
+    if (res != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to leave channel %s: %s", name, esp_err_to_name(res));
+        return;
+    }
+    ESP_LOGI(TAG, "Left channel %s (%02X)", channel.name, channel.hash);
+
+    xSemaphoreTake(chat_mutex, portMAX_DELAY);
+    message_store_t* store = message_store_open(channel.id, false);
+    if (store == chat_store) {
+        message_store_t* next = message_store_next(store);
+        chat_store            = next != store ? next : NULL;
+        chat_scroll           = 0;
+    }
+    message_store_close(store);
+    message_store_mark_read(chat_store);
+    load_chat_page();
+    xSemaphoreGive(chat_mutex);
+}
+
+static void list_channels(void) {
+    channel_info_t channels[MESHCORE_MAX_CHANNELS];
+    size_t         count = channel_manager_list(channels, MESHCORE_MAX_CHANNELS);
+    xSemaphoreTake(chat_mutex, portMAX_DELAY);
+    for (size_t i = 0; i < count; i++) {
+        message_store_t* store = message_store_open(channels[i].id, false);
+        ESP_LOGI(TAG, "Channel %s (%02X): %u messages, %u unread", channels[i].name, channels[i].hash,
+                 (unsigned int)message_store_count(store), (unsigned int)message_store_get_unread(store));
+    }
+    xSemaphoreGive(chat_mutex);
+}
+
+// "/region add #hashtag", "/region add name key" with the key in hex, or "/region remove name"
+static void configure_region(char* arguments) {
+    char* name = strchr(arguments, ' ');
+    if (name == NULL) {
+        ESP_LOGW(TAG, "Usage: /region add|remove name [key]");
+        return;
+    }
+    *name++ = '\0';
+
+    esp_err_t res;
+    if (strcmp(arguments, "add") == 0) {
+        char* key = strchr(name, ' ');
+        if (key != NULL) {
+            *key++ = '\0';
+        }
+        res = region_manager_add(name, key);
+    } else if (strcmp(arguments, "remove") == 0) {
+        res = region_manager_remove(name);
+    } else {
+        res = ESP_ERR_INVALID_ARG;
+    }
+
+    if (res != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to %s region %s: %s", arguments, name, esp_err_to_name(res));
+        return;
+    }
+    ESP_LOGI(TAG, "Region %s: %s", arguments, name);
+}
+
+// "/scope name" scopes the floods we send to a region, "/scope none" sends them everywhere
+static void set_scope(const char* name) {
+    esp_err_t res = region_manager_set_scope(strcmp(name, "none") != 0 ? name : NULL);
+    if (res != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to scope to %s: %s", name, esp_err_to_name(res));
+        return;
+    }
+    ESP_LOGI(TAG, "Sending floods %s%s", strcmp(name, "none") != 0 ? "to " : "", name);
+}
+
+static void list_regions(void) {
+    region_info_t regions[MESHCORE_MAX_REGIONS];
+    size_t        count = region_manager_list(regions, MESHCORE_MAX_REGIONS);
+    if (count == 0) {
+        ESP_LOGI(TAG, "No regions, all floods are accepted");
+    }
+    for (size_t i = 0; i < count; i++) {
+        ESP_LOGI(TAG, "Region %s%s", regions[i].name, regions[i].scope ? " (send scope)" : "");
+    }
+}
+
+void send_input(void) {
+    if (strlen(text_buffer) == 0) {
+        return;
+    }
+    printf("Sending message: '%s'\n", text_buffer);
+
+    if (strcmp(text_buffer, "/mem") == 0) {
+        report_memory_usage();
+        handle_input('\0');
+        return;
+    }
+
+    if (strcmp(text_buffer, "/stats") == 0 || strcmp(text_buffer, "/stats reset") == 0) {
+        report_pipeline_stats(strcmp(text_buffer, "/stats reset") == 0);
+        handle_input('\0');
+        return;
+    }
+
+    if (strcmp(text_buffer, "/advert") == 0) {
+        if (own_identity != NULL) {
+            atomic_store(&advert_requested, true);
+            xTaskNotifyGive(meshcore_task_handle);
+        }
+        handle_input('\0');
+        return;
+    }
+
+    if (strcmp(text_buffer, "/capture") == 0) {
+        toggle_capture();
+        handle_input('\0');
+        return;
+    }
+
+    if (strncmp(text_buffer, "/join ", 6) == 0) {
+        join_channel(&text_buffer[6]);
+        handle_input('\0');
+        return;
+    }
+
+    if (strncmp(text_buffer, "/leave ", 7) == 0) {
+        leave_channel(&text_buffer[7]);
+        handle_input('\0');
+        return;
+    }
+
+    if (strncmp(text_buffer, "/multipart ", 11) == 0) {
+        send_multipart_test(&text_buffer[11]);
+        handle_input('\0');
+        return;
+    }
+
+    if (strncmp(text_buffer, "/trace ", 7) == 0) {
+        start_trace(&text_buffer[7]);
+        handle_input('\0');
+        return;
+    }
+
+    if (strcmp(text_buffer, "/traces") == 0 && path_tracer_mutex != NULL) {
+        list_traces();
+        handle_input('\0');
+        return;
+    }
+
+    if (strncmp(text_buffer, "/region ", 8) == 0) {
+        configure_region(&text_buffer[8]);
+        handle_input('\0');
+        return;
+    }
+
+    if (strncmp(text_buffer, "/scope ", 7) == 0) {
+        set_scope(&text_buffer[7]);
+        handle_input('\0');
+        return;
+    }
+
+    if (strcmp(text_buffer, "/regions") == 0) {
+        list_regions();
+        handle_input('\0');
+        return;
+    }
+
+    if (strcmp(text_buffer, "/channels") == 0) {
+        list_channels();
+        handle_input('\0');
+        return;
+    }
+
+    char nickname[CHAT_MESSAGE_NAME_SIZE] = {0};
+    device_settings_get_owner_nickname(nickname, sizeof(nickname));
+
+    if (text_buffer[0] == '@') {
+        // Direct message: "@name text"
+        char* separator = strchr(text_buffer, ' ');
+        if (separator == NULL || own_identity == NULL) {
+            return;
+        }
+        char name[CHAT_MESSAGE_NAME_SIZE] = {0};
+        snprintf(name, sizeof(name), "%.*s", (int)(separator - text_buffer - 1), &text_buffer[1]);
+
+        // Work on a copy of the contact, adverts keep updating the table while the message is sent
+        meshcore_contact_t recipient = {0};
+        bool               ambiguous = false;
+        xSemaphoreTake(contacts_mutex, portMAX_DELAY);
+        const meshcore_contact_t* contact = meshcore_contacts_find_by_name(&contacts, name, &ambiguous);
+        if (contact != NULL) {
+            recipient = *contact;
+        } else if (ambiguous) {
+            ESP_LOGW(TAG, "More than one contact matches '%s', address it by public key prefix instead:", name);
+            for (uint8_t i = 0; i < contacts.count; i++) {
+                if (strcasecmp(contacts.contacts[i].name, name) == 0) {
+                    const uint8_t* key = contacts.contacts[i].pub_key;
+                    ESP_LOGW(TAG, "  @%02x%02x%02x%02x %s", key[0], key[1], key[2], key[3], contacts.contacts[i].name);
+                }
+            }
+        }
+        xSemaphoreGive(contacts_mutex);
+        if (contact == NULL) {
+            if (!ambiguous) {
+                ESP_LOGW(TAG, "Unknown contact '%s'", name);
+            }
+            return;
+        }
+
+        handle_chat_message(recipient.pub_key, nickname, separator + 1, (uint32_t)time(NULL), true, true);
+        send_direct_message(&recipient, separator + 1);
+    } else {
+        uint8_t channel_id[MESHCORE_CHANNEL_ID_SIZE];
+        if (!get_send_channel(channel_id)) {
+            ESP_LOGW(TAG, "Not subscribed to any channel");
+            return;
+        }
+        send_group_message(channel_id, nickname, text_buffer);
+    }
+
     handle_input('\0');
 }
 
@@ -524,7 +1483,7 @@ void app_main(void) {
         .display =
             {
                 .requested_color_format = LCD_COLOR_PIXEL_FORMAT_RGB888,
-                .num_fbs                = 1,
+                .num_fbs                = 1,  // Partial updates need a single panel buffer, see screen.c
             },
     };
     res = bsp_device_initialize(&bsp_configuration);
@@ -576,6 +1535,64 @@ void app_main(void) {
     pax_buf_init(&fb, NULL, display_h_res, display_v_res, format);
     pax_buf_reversed(&fb, display_data_endian == LCD_RGB_DATA_ENDIAN_BIG);
     pax_buf_set_orientation(&fb, orientation);
+    screen_init(&fb, display_h_res, display_v_res, format == PAX_BUF_16_565RGB ? 2 : 3, orientation,
+                DISPLAY_DOUBLE_BUFFERED);
+    chat_layout_cache_init(&chat_layouts, pax_font_saira_regular, 16, pax_buf_get_width(&fb), CHAT_ROW_HEIGHT);
+
+    // Message history
+    chat_mutex = xSemaphoreCreateMutex();
+    chat_arena_init(&chat_window);
+    res        = message_store_init();
+    if (res != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize message store: %s", esp_err_to_name(res));
+    }
+
+    // Channel subscriptions, each channel gets its store up front so it can be switched to before anything arrives
+    res = channel_manager_init();
+    if (res != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize channels: %s", esp_err_to_name(res));
+    } else {
+        channel_info_t channels[MESHCORE_MAX_CHANNELS];
+        size_t         count = channel_manager_list(channels, MESHCORE_MAX_CHANNELS);
+        for (size_t i = 0; i < count; i++) {
+            message_store_open(channels[i].id, false);
+        }
+        chat_store = message_store_next(NULL);
+        load_chat_page();
+    }
+    res = group_data_init(transmit_buffer);
+    if (res != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize group datagrams: %s", esp_err_to_name(res));
+    }
+    res = region_manager_init();
+    if (res != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize regions: %s", esp_err_to_name(res));
+    }
+
+    // Meshcore identity and contacts
+    contacts_mutex = xSemaphoreCreateMutex();
+    meshcore_contacts_init(&contacts);
+    res = identity_init();
+    if (res != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize identity: %s", esp_err_to_name(res));
+    }
+    own_identity = identity_get();
+    if (own_identity != NULL) {
+        char name[MESHCORE_MAX_NAME_SIZE + sizeof('\0')] = {0};
+        device_settings_get_meshcore_name(name, sizeof(name));
+        meshcore_self_advert_init(&self_advert, own_identity->public_key, own_identity->private_key,
+                                  MESHCORE_DEVICE_ROLE_CHAT_NODE, esp_timer_get_time() / 1000, esp_random());
+        meshcore_self_advert_set_name(&self_advert, name);
+        res = multipart_manager_init(own_identity->hash, transmit_buffer);
+        if (res == ESP_OK) {
+            res = multipart_manager_register(MESHCORE_PAYLOAD_TYPE_RAW_CUSTOM, handle_multipart_test, NULL);
+        }
+        if (res != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to initialize multipart payloads: %s", esp_err_to_name(res));
+        }
+        meshcore_path_tracer_init(&path_tracer, own_identity->hash, esp_random());
+        path_tracer_mutex = xSemaphoreCreateMutex();
+    }
 
     // Get input event queue from BSP
     ESP_ERROR_CHECK(bsp_input_get_queue(&input_event_queue));
@@ -682,29 +1699,58 @@ void app_main(void) {
     // If you want to run something at an interval in this same main thread you can replace portMAX_DELAY with an
     // amount of ticks to wait, for example pdMS_TO_TICKS(1000)
 
-    xTaskCreatePinnedToCore(meshcore_task, TAG, 1024 * 16, NULL, 10, NULL, CONFIG_SOC_CPU_CORES_NUM - 1);
+    if (meshcore_trace_start() < 0) {
+        ESP_LOGE(TAG, "Failed to start trace task");
+    }
+
+    packet_ring_init(&rx_ring);
+    xTaskCreatePinnedToCore(meshcore_task, TAG, 1024 * 8, NULL, 10, &meshcore_task_handle,
+                            CONFIG_SOC_CPU_CORES_NUM - 1);
 
     pax_background(&fb, BLACK);
     pax_draw_text(&fb, 0xFFFF00FF, pax_font_saira_regular, 24, 0, 0, "Meshcore chat app (preview) - build 2");
     blit();
 
     while (1) {
+        // Redraw when requested, but never more than once per frame interval
+        TickType_t timeout = portMAX_DELAY;
+        if (atomic_load(&chat_dirty)) {
+            int64_t now = esp_timer_get_time();
+            int64_t due = last_render_time + RENDER_INTERVAL_US;
+            if (now >= due) {
+                atomic_store(&chat_dirty, false);
+                last_render_time = now;
+                redraws++;
+                render_chat();
+            } else {
+                timeout = pdMS_TO_TICKS((due - now) / 1000) + 1;
+            }
+        }
+
         bsp_input_event_t event;
-        if (xQueueReceive(input_event_queue, &event, portMAX_DELAY) == pdTRUE) {
+        if (xQueueReceive(input_event_queue, &event, timeout) == pdTRUE) {
             switch (event.type) {
                 case INPUT_EVENT_TYPE_LAST:
-                    // new chat message
-                    render_chat();
+                    // Redraw requested, handled at the top of the loop
                     break;
                 case INPUT_EVENT_TYPE_KEYBOARD: {
+                    clear_notice();
                     handle_input(event.args_keyboard.ascii);
                     break;
                 }
                 case INPUT_EVENT_TYPE_NAVIGATION: {
                     if (event.args_navigation.state) {
+                        clear_notice();
                         if (event.args_navigation.key == BSP_INPUT_NAVIGATION_KEY_RETURN) {
                             send_input();
-                            render_chat();
+                            request_redraw();
+                        } else if (event.args_navigation.key == BSP_INPUT_NAVIGATION_KEY_UP ||
+                                   event.args_navigation.key == BSP_INPUT_NAVIGATION_KEY_DOWN) {
+                            scroll_chat(event.args_navigation.key == BSP_INPUT_NAVIGATION_KEY_UP);
+                            request_redraw();
+                        } else if (event.args_navigation.key == BSP_INPUT_NAVIGATION_KEY_TAB) {
+                            switch_chat();
+                            request_redraw();
                         }
                         break;
                     }
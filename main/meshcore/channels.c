@@ -0,0 +1,191 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#include "channels.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include "cipher.h"
+#include "crypto/sha256.h"
+
+void meshcore_channels_init(meshcore_channels_t* channels) {
+    memset(channels, 0, sizeof(meshcore_channels_t));
+    memset(channels->buckets, MESHCORE_CHANNEL_NONE, sizeof(channels->buckets));
+}
+
+uint8_t meshcore_channel_hashtag_secret(const char* name, uint8_t* out_secret) {
+    Sha256Context context;
+    SHA256_HASH   digest;
+    Sha256Initialise(&context);
+    Sha256Update(&context, name, strlen(name));
+    Sha256Finalise(&context, &digest);
+
+    memcpy(out_secret, digest.bytes, MESHCORE_CIPHER_KEY_SIZE);
+    return MESHCORE_CIPHER_KEY_SIZE;
+}
+
+static meshcore_channel_t* meshcore_channels_find_by_secret(meshcore_channels_t* channels, uint8_t hash,
+                                                            const uint8_t* secret, uint8_t secret_length) {
+    meshcore_channel_t* channel = NULL;
+    while ((channel = meshcore_channels_find_by_hash(channels, hash, channel)) != NULL) {
+        if (channel->secret_length == secret_length && memcmp(channel->secret, secret, secret_length) == 0) {
+            return channel;
+        }
+    }
+    return NULL;
+}
+
+meshcore_channel_t* meshcore_channels_add(meshcore_channels_t* channels, const char* name, const uint8_t* secret,
+                                          uint8_t secret_length) {
+    if (channels == NULL || name == NULL || secret == NULL) {
+        return NULL;
+    }
+
+    if (secret_length != MESHCORE_CIPHER_KEY_SIZE && secret_length != MESHCORE_CHANNEL_MAX_SECRET_SIZE) {
+        return NULL;
+    }
+
+    Sha256Context context;
+    SHA256_HASH   digest;
+    Sha256Initialise(&context);
+    Sha256Update(&context, secret, secret_length);
+    Sha256Finalise(&context, &digest);
+    uint8_t hash = digest.bytes[0];
+
+    meshcore_channel_t* channel = meshcore_channels_find_by_secret(channels, hash, secret, secret_length);
+    if (channel != NULL) {
+        return channel;
+    }
+
+    uint8_t index = MESHCORE_CHANNEL_NONE;
+    for (uint8_t i = 0; i < MESHCORE_MAX_CHANNELS; i++) {
+        if (!channels->channels[i].valid) {
+            index = i;
+            break;
+        }
+    }
+    if (index == MESHCORE_CHANNEL_NONE) {
+        return NULL;
+    }
+
+    channel = &channels->channels[index];
+    memset(channel, 0, sizeof(meshcore_channel_t));
+    snprintf(channel->name, sizeof(channel->name), "%s", name);
+    memcpy(channel->secret, secret, secret_length);
+    channel->secret_length = secret_length;
+    channel->hash          = hash;
+    memcpy(channel->id, digest.bytes, MESHCORE_CHANNEL_ID_SIZE);
+    meshcore_cipher_key_init(&channel->key, secret, secret_length);
+    channel->valid = true;
+
+    channel->next           = channels->buckets[hash];
+    channels->buckets[hash] = index;
+    channels->count++;
+
+    return channel;
+}
+
+meshcore_channel_t* meshcore_channels_add_hashtag(meshcore_channels_t* channels, const char* name) {
+    if (name == NULL || name[0] != '#' || name[1] == '\0') {
+        return NULL;
+    }
+
+    uint8_t secret[MESHCORE_CHANNEL_MAX_SECRET_SIZE];
+    uint8_t secret_length = meshcore_channel_hashtag_secret(name, secret);
+    return meshcore_channels_add(channels, name, secret, secret_length);
+}
+
+void meshcore_channels_remove(meshcore_channels_t* channels, meshcore_channel_t* channel) {
+    if (channels == NULL || channel == NULL || !channel->valid) {
+        return;
+    }
+
+    uint8_t  index = channel - channels->channels;
+    uint8_t* link  = &channels->buckets[channel->hash];
+    while (*link != MESHCORE_CHANNEL_NONE) {
+        if (*link == index) {
+            *link = channel->next;
+            break;
+        }
+        link = &channels->channels[*link].next;
+    }
+
+    memset(channel, 0, sizeof(meshcore_channel_t));
+    channels->count--;
+}
+
+meshcore_channel_t* meshcore_channels_find_by_hash(meshcore_channels_t* channels, uint8_t hash,
+                                                   const meshcore_channel_t* previous) {
+    if (channels == NULL) {
+        return NULL;
+    }
+
+    uint8_t index = (previous == NULL) ? channels->buckets[hash] : previous->next;
+    if (index == MESHCORE_CHANNEL_NONE || index >= MESHCORE_MAX_CHANNELS) {
+        return NULL;
+    }
+
+    return &channels->channels[index];
+}
+
+meshcore_channel_t* meshcore_channels_find_by_mac(meshcore_channels_t* channels, uint8_t hash, const uint8_t* mac,
+                                                  const uint8_t* data, uint8_t length) {
+    if (channels == NULL || mac == NULL || data == NULL || length % MESHCORE_CIPHER_BLOCK_SIZE != 0) {
+        return NULL;
+    }
+
+    meshcore_channel_t*     candidates[MESHCORE_MAX_CHANNELS];
+    meshcore_hmac_request_t requests[MESHCORE_MAX_CHANNELS];
+    uint8_t                 macs[MESHCORE_MAX_CHANNELS][MESHCORE_CIPHER_MAC_SIZE];
+    size_t                  count   = 0;
+    meshcore_channel_t*     channel = NULL;
+    while (count < MESHCORE_MAX_CHANNELS &&
+           (channel = meshcore_channels_find_by_hash(channels, hash, channel)) != NULL) {
+        candidates[count]       = channel;
+        requests[count].key     = &channel->key.hmac;
+        requests[count].data    = data;
+        requests[count].length  = length;
+        requests[count].out_mac = macs[count];
+        count++;
+    }
+
+    meshcore_hmac_batch(requests, count, MESHCORE_CIPHER_MAC_SIZE);
+
+    for (size_t i = 0; i < count; i++) {
+        if (memcmp(macs[i], mac, MESHCORE_CIPHER_MAC_SIZE) == 0) {
+            return candidates[i];
+        }
+    }
+
+    return NULL;
+}
+
+meshcore_channel_t* meshcore_channels_find_by_id(meshcore_channels_t* channels, const uint8_t* id) {
+    if (channels == NULL || id == NULL) {
+        return NULL;
+    }
+
+    meshcore_channel_t* channel = NULL;
+    while ((channel = meshcore_channels_find_by_hash(channels, id[0], channel)) != NULL) {
+        if (memcmp(channel->id, id, MESHCORE_CHANNEL_ID_SIZE) == 0) {
+            return channel;
+        }
+    }
+    return NULL;
+}
+
+meshcore_channel_t* meshcore_channels_find_by_name(meshcore_channels_t* channels, const char* name) {
+    if (channels == NULL || name == NULL || name[0] == '\0') {
+        return NULL;
+    }
+
+    for (uint8_t i = 0; i < MESHCORE_MAX_CHANNELS; i++) {
+        if (channels->channels[i].valid && strcasecmp(channels->channels[i].name, name) == 0) {
+            return &channels->channels[i];
+        }
+    }
+
+    return NULL;
+}
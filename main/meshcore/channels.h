@@ -0,0 +1,71 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "cipher.h"
+#include "packet.h"
+
+// Definitions
+
+#define MESHCORE_MAX_CHANNELS            8
+#define MESHCORE_CHANNEL_NAME_SIZE       32
+#define MESHCORE_CHANNEL_MAX_SECRET_SIZE 32  // Secrets are 16 or 32 bytes
+#define MESHCORE_CHANNEL_NONE            0xFF
+#define MESHCORE_CHANNEL_ID_SIZE         8   // Bytes of the secret's SHA-256 that identify a channel locally
+
+typedef struct {
+    bool                  valid;
+    char                  name[MESHCORE_CHANNEL_NAME_SIZE + sizeof('\0')];
+    uint8_t               secret[MESHCORE_CHANNEL_MAX_SECRET_SIZE];
+    uint8_t               secret_length;
+    uint8_t               id[MESHCORE_CHANNEL_ID_SIZE];  // First bytes of the SHA-256 of the secret
+    uint8_t               hash;                          // First byte of the id, sent with every group message
+    meshcore_cipher_key_t key;                           // Computed once when the channel is added
+    uint8_t               next;                          // Next channel with the same hash
+} meshcore_channel_t;
+
+typedef struct {
+    meshcore_channel_t channels[MESHCORE_MAX_CHANNELS];
+    uint8_t            buckets[256];  // First channel index per channel hash
+    uint8_t            count;
+} meshcore_channels_t;
+
+// Functions
+
+/// Initialize an empty channel table
+void meshcore_channels_init(meshcore_channels_t* channels);
+
+/// Derive the secret of a public hashtag channel from its name (including the '#'), the secret is the first 16 bytes
+/// of the SHA-256 of the name. Returns the secret length.
+uint8_t meshcore_channel_hashtag_secret(const char* name, uint8_t* out_secret);
+
+/// Add a channel with a 16 or 32 byte secret, all key material is derived here. Returns the existing channel when the
+/// secret was already added, NULL when the table is full or the secret length is invalid.
+meshcore_channel_t* meshcore_channels_add(meshcore_channels_t* channels, const char* name, const uint8_t* secret,
+                                          uint8_t secret_length);
+
+/// Add a hashtag channel, the secret is derived from the name
+meshcore_channel_t* meshcore_channels_add_hashtag(meshcore_channels_t* channels, const char* name);
+
+/// Remove a channel, the pointer is invalid afterwards
+void meshcore_channels_remove(meshcore_channels_t* channels, meshcore_channel_t* channel);
+
+/// Iterate over the channels whose hash matches, pass NULL as previous to get the first match
+meshcore_channel_t* meshcore_channels_find_by_hash(meshcore_channels_t* channels, uint8_t hash,
+                                                   const meshcore_channel_t* previous);
+
+/// Find the first channel with the hash whose key matches the MAC of the ciphertext. The MACs of all candidates are
+/// calculated as one batch. Returns NULL when none matches.
+meshcore_channel_t* meshcore_channels_find_by_mac(meshcore_channels_t* channels, uint8_t hash, const uint8_t* mac,
+                                                  const uint8_t* data, uint8_t length);
+
+/// Find a channel by its id, unlike the hash the id tells subscribed channels apart
+meshcore_channel_t* meshcore_channels_find_by_id(meshcore_channels_t* channels, const uint8_t* id);
+
+/// Find a channel by its name, case insensitive
+meshcore_channel_t* meshcore_channels_find_by_name(meshcore_channels_t* channels, const char* name);
@@ -0,0 +1,251 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#include "cipher.h"
+#include <stdint.h>
+#include <string.h>
+#include "crypto/aes.h"
+#include "crypto/hmac_sha256.h"
+#include "crypto/sha256.h"
+#include "crypto/sha256_multi.h"
+#include "packet.h"
+
+#define HMAC_BLOCK_SIZE 64  // SHA-256 block size
+
+int meshcore_encrypt_then_mac(const uint8_t* secret, size_t secret_length, uint8_t* data, uint8_t length,
+                              size_t capacity, uint8_t* out_length, uint8_t* out_mac) {
+    if (secret == NULL || data == NULL || out_length == NULL || out_mac == NULL ||
+        secret_length < MESHCORE_CIPHER_KEY_SIZE) {
+        return -1;
+    }
+
+    size_t encrypt_length = length;
+    if (encrypt_length % MESHCORE_CIPHER_BLOCK_SIZE != 0) {
+        encrypt_length += MESHCORE_CIPHER_BLOCK_SIZE - (encrypt_length % MESHCORE_CIPHER_BLOCK_SIZE);
+    }
+    if (encrypt_length > capacity) {
+        return -1;
+    }
+
+    for (size_t i = length; i < encrypt_length; i++) {
+        data[i] = 0;
+    }
+
+    struct AES_ctx ctx;
+    AES_init_ctx(&ctx, secret);
+    for (size_t i = 0; i < (encrypt_length / MESHCORE_CIPHER_BLOCK_SIZE); i++) {
+        AES_ECB_encrypt(&ctx, &data[i * MESHCORE_CIPHER_BLOCK_SIZE]);
+    }
+
+    hmac_sha256(secret, secret_length, data, encrypt_length, out_mac, MESHCORE_CIPHER_MAC_SIZE);
+
+    *out_length = encrypt_length;
+
+    return 0;
+}
+
+int meshcore_mac_verify(const uint8_t* secret, size_t secret_length, const uint8_t* mac, const uint8_t* data,
+                        uint8_t length) {
+    if (secret == NULL || mac == NULL || data == NULL || secret_length < MESHCORE_CIPHER_KEY_SIZE) {
+        return -1;
+    }
+
+    if (length % MESHCORE_CIPHER_BLOCK_SIZE != 0) {
+        return -1;
+    }
+
+    uint8_t calculated_mac[MESHCORE_CIPHER_MAC_SIZE];
+    hmac_sha256(secret, secret_length, data, length, calculated_mac, MESHCORE_CIPHER_MAC_SIZE);
+
+    if (memcmp(calculated_mac, mac, MESHCORE_CIPHER_MAC_SIZE) != 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+int meshcore_decrypt(const uint8_t* secret, size_t secret_length, uint8_t* data, uint8_t length) {
+    if (secret == NULL || data == NULL || secret_length < MESHCORE_CIPHER_KEY_SIZE) {
+        return -1;
+    }
+
+    if (length % MESHCORE_CIPHER_BLOCK_SIZE != 0) {
+        return -1;
+    }
+
+    struct AES_ctx ctx;
+    AES_init_ctx(&ctx, secret);
+    for (uint8_t i = 0; i < (length / MESHCORE_CIPHER_BLOCK_SIZE); i++) {
+        AES_ECB_decrypt(&ctx, &data[i * MESHCORE_CIPHER_BLOCK_SIZE]);
+    }
+
+    return 0;
+}
+
+int meshcore_mac_then_decrypt(const uint8_t* secret, size_t secret_length, const uint8_t* mac, uint8_t* data,
+                              uint8_t length) {
+    if (meshcore_mac_verify(secret, secret_length, mac, data, length) < 0) {
+        return -1;
+    }
+
+    return meshcore_decrypt(secret, secret_length, data, length);
+}
+
+void meshcore_hmac_key_init(meshcore_hmac_key_t* key, const uint8_t* secret, size_t secret_length) {
+    uint8_t block[HMAC_BLOCK_SIZE] = {0};
+    if (secret_length > HMAC_BLOCK_SIZE) {
+        // Longer HMAC keys are hashed first
+        Sha256Context context;
+        SHA256_HASH   digest;
+        Sha256Initialise(&context);
+        Sha256Update(&context, secret, secret_length);
+        Sha256Finalise(&context, &digest);
+        memcpy(block, digest.bytes, SHA256_HASH_SIZE);
+    } else {
+        memcpy(block, secret, secret_length);
+    }
+
+    for (size_t i = 0; i < HMAC_BLOCK_SIZE; i++) {
+        block[i] ^= 0x36;
+    }
+    Sha256Initialise(&key->inner);
+    Sha256Update(&key->inner, block, HMAC_BLOCK_SIZE);
+
+    for (size_t i = 0; i < HMAC_BLOCK_SIZE; i++) {
+        block[i] ^= 0x36 ^ 0x5C;
+    }
+    Sha256Initialise(&key->outer);
+    Sha256Update(&key->outer, block, HMAC_BLOCK_SIZE);
+
+    memset(block, 0, sizeof(block));
+}
+
+void meshcore_hmac_begin(const meshcore_hmac_key_t* key, Sha256Context* out_context) {
+    *out_context = key->inner;
+}
+
+void meshcore_hmac_finish(const meshcore_hmac_key_t* key, Sha256Context* context, uint8_t* out_mac, size_t length) {
+    SHA256_HASH digest;
+    Sha256Finalise(context, &digest);
+
+    *context = key->outer;
+    Sha256Update(context, digest.bytes, SHA256_HASH_SIZE);
+    Sha256Finalise(context, &digest);
+
+    memcpy(out_mac, digest.bytes, length);
+}
+
+void meshcore_hmac_batch(const meshcore_hmac_request_t* requests, size_t count, size_t length) {
+    Sha256Context  contexts[MESHCORE_HMAC_BATCH_SIZE];
+    Sha256Context* context_pointers[MESHCORE_HMAC_BATCH_SIZE];
+    const void*    buffers[MESHCORE_HMAC_BATCH_SIZE];
+    uint32_t       sizes[MESHCORE_HMAC_BATCH_SIZE];
+    SHA256_HASH    inner[MESHCORE_HMAC_BATCH_SIZE];
+    SHA256_HASH    outer[MESHCORE_HMAC_BATCH_SIZE];
+
+    for (size_t first = 0; first < count; first += MESHCORE_HMAC_BATCH_SIZE) {
+        const meshcore_hmac_request_t* batch       = &requests[first];
+        uint32_t                       batch_count = MESHCORE_HMAC_BATCH_SIZE;
+        if (count - first < MESHCORE_HMAC_BATCH_SIZE) {
+            batch_count = count - first;
+        }
+
+        // Inner hashes over the messages
+        for (uint32_t i = 0; i < batch_count; i++) {
+            contexts[i]         = batch[i].key->inner;
+            context_pointers[i] = &contexts[i];
+            buffers[i]          = batch[i].data;
+            sizes[i]            = batch[i].length;
+        }
+        Sha256MultiFinalise(context_pointers, buffers, sizes, inner, batch_count);
+
+        // Outer hashes over the inner digests, these all have the same length
+        for (uint32_t i = 0; i < batch_count; i++) {
+            contexts[i] = batch[i].key->outer;
+            buffers[i]  = inner[i].bytes;
+            sizes[i]    = SHA256_HASH_SIZE;
+        }
+        Sha256MultiFinalise(context_pointers, buffers, sizes, outer, batch_count);
+
+        for (uint32_t i = 0; i < batch_count; i++) {
+            memcpy(batch[i].out_mac, outer[i].bytes, length);
+        }
+    }
+}
+
+void meshcore_cipher_key_init(meshcore_cipher_key_t* key, const uint8_t* secret, size_t secret_length) {
+    AES_init_ctx(&key->aes, secret);
+    meshcore_hmac_key_init(&key->hmac, secret, secret_length);
+}
+
+static void key_mac(const meshcore_cipher_key_t* key, const uint8_t* data, uint8_t length, uint8_t* out_mac) {
+    Sha256Context context;
+    meshcore_hmac_begin(&key->hmac, &context);
+    Sha256Update(&context, data, length);
+    meshcore_hmac_finish(&key->hmac, &context, out_mac, MESHCORE_CIPHER_MAC_SIZE);
+}
+
+int meshcore_key_encrypt_then_mac(const meshcore_cipher_key_t* key, uint8_t* data, uint8_t length, size_t capacity,
+                                  uint8_t* out_length, uint8_t* out_mac) {
+    if (key == NULL || data == NULL || out_length == NULL || out_mac == NULL) {
+        return -1;
+    }
+
+    size_t encrypt_length = length;
+    if (encrypt_length % MESHCORE_CIPHER_BLOCK_SIZE != 0) {
+        encrypt_length += MESHCORE_CIPHER_BLOCK_SIZE - (encrypt_length % MESHCORE_CIPHER_BLOCK_SIZE);
+    }
+    if (encrypt_length > capacity) {
+        return -1;
+    }
+
+    for (size_t i = length; i < encrypt_length; i++) {
+        data[i] = 0;
+    }
+
+    for (size_t i = 0; i < (encrypt_length / MESHCORE_CIPHER_BLOCK_SIZE); i++) {
+        AES_ECB_encrypt(&key->aes, &data[i * MESHCORE_CIPHER_BLOCK_SIZE]);
+    }
+
+    key_mac(key, data, encrypt_length, out_mac);
+
+    *out_length = encrypt_length;
+
+    return 0;
+}
+
+int meshcore_key_mac_verify(const meshcore_cipher_key_t* key, const uint8_t* mac, const uint8_t* data, uint8_t length) {
+    if (key == NULL || mac == NULL || data == NULL) {
+        return -1;
+    }
+
+    if (length % MESHCORE_CIPHER_BLOCK_SIZE != 0) {
+        return -1;
+    }
+
+    uint8_t calculated_mac[MESHCORE_CIPHER_MAC_SIZE];
+    key_mac(key, data, length, calculated_mac);
+
+    if (memcmp(calculated_mac, mac, MESHCORE_CIPHER_MAC_SIZE) != 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+int meshcore_key_decrypt(const meshcore_cipher_key_t* key, uint8_t* data, uint8_t length) {
+    if (key == NULL || data == NULL) {
+        return -1;
+    }
+
+    if (length % MESHCORE_CIPHER_BLOCK_SIZE != 0) {
+        return -1;
+    }
+
+    for (uint8_t i = 0; i < (length / MESHCORE_CIPHER_BLOCK_SIZE); i++) {
+        AES_ECB_decrypt(&key->aes, &data[i * MESHCORE_CIPHER_BLOCK_SIZE]);
+    }
+
+    return 0;
+}
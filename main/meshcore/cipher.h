@@ -0,0 +1,84 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "crypto/aes.h"
+#include "crypto/sha256.h"
+#include "packet.h"
+
+// Definitions
+
+#define MESHCORE_SHARED_SECRET_SIZE MESHCORE_PUB_KEY_SIZE
+#define MESHCORE_HMAC_BATCH_SIZE    8  // MACs calculated per pass, larger batches are split
+
+// HMAC-SHA256 state derived from a key once, so that a MAC costs only the hashing of the message
+typedef struct {
+    Sha256Context inner;  // SHA-256 state after the key XOR ipad block
+    Sha256Context outer;  // SHA-256 state after the key XOR opad block
+} meshcore_hmac_key_t;
+
+// Cipher state derived from a secret once, so that using the key needs no AES key expansion or HMAC key setup
+typedef struct {
+    struct AES_ctx      aes;
+    meshcore_hmac_key_t hmac;
+} meshcore_cipher_key_t;
+
+// One message of a batch of MACs
+typedef struct {
+    const meshcore_hmac_key_t* key;
+    const uint8_t*             data;
+    uint32_t                   length;
+    uint8_t*                   out_mac;
+} meshcore_hmac_request_t;
+
+// Functions
+
+/// Encrypt data in-place (AES-128 ECB, zero padded to the block size) and calculate the truncated HMAC-SHA256 over
+/// the ciphertext. The first MESHCORE_CIPHER_KEY_SIZE bytes of the secret are used as the AES key, the full secret is
+/// used as the HMAC key. Returns -1 when the padded ciphertext does not fit in the buffer capacity.
+int meshcore_encrypt_then_mac(const uint8_t* secret, size_t secret_length, uint8_t* data, uint8_t length,
+                              size_t capacity, uint8_t* out_length, uint8_t* out_mac);
+
+/// Verify the truncated HMAC-SHA256 of the ciphertext without decrypting it. Returns -1 when the MAC does not match.
+int meshcore_mac_verify(const uint8_t* secret, size_t secret_length, const uint8_t* mac, const uint8_t* data,
+                        uint8_t length);
+
+/// Decrypt data in-place with the first MESHCORE_CIPHER_KEY_SIZE bytes of the secret, the MAC must have been verified.
+/// Returns -1 when the length is not a multiple of the block size.
+int meshcore_decrypt(const uint8_t* secret, size_t secret_length, uint8_t* data, uint8_t length);
+
+/// Verify the truncated HMAC-SHA256 of the ciphertext and decrypt it in-place when it matches. Returns -1 when the MAC
+/// does not match or when the length is not a multiple of the block size, the data is left untouched in that case.
+int meshcore_mac_then_decrypt(const uint8_t* secret, size_t secret_length, const uint8_t* mac, uint8_t* data,
+                              uint8_t length);
+
+/// Precompute the HMAC-SHA256 state of a key
+void meshcore_hmac_key_init(meshcore_hmac_key_t* key, const uint8_t* secret, size_t secret_length);
+
+/// Start a MAC, the message is added to the returned context with Sha256Update()
+void meshcore_hmac_begin(const meshcore_hmac_key_t* key, Sha256Context* out_context);
+
+/// Finish a MAC started with meshcore_hmac_begin() and copy the first length bytes of it
+void meshcore_hmac_finish(const meshcore_hmac_key_t* key, Sha256Context* context, uint8_t* out_mac, size_t length);
+
+/// Calculate the MACs of independent messages, each truncated to length bytes. The SHA-256 of the messages is
+/// calculated in lockstep on hosts with SIMD, elsewhere this equals calculating them one by one.
+void meshcore_hmac_batch(const meshcore_hmac_request_t* requests, size_t count, size_t length);
+
+/// Precompute the cipher state of a secret, the same key material as the functions above take
+void meshcore_cipher_key_init(meshcore_cipher_key_t* key, const uint8_t* secret, size_t secret_length);
+
+/// meshcore_encrypt_then_mac() with a precomputed key
+int meshcore_key_encrypt_then_mac(const meshcore_cipher_key_t* key, uint8_t* data, uint8_t length, size_t capacity,
+                                  uint8_t* out_length, uint8_t* out_mac);
+
+/// meshcore_mac_verify() with a precomputed key
+int meshcore_key_mac_verify(const meshcore_cipher_key_t* key, const uint8_t* mac, const uint8_t* data, uint8_t length);
+
+/// meshcore_decrypt() with a precomputed key
+int meshcore_key_decrypt(const meshcore_cipher_key_t* key, uint8_t* data, uint8_t length);
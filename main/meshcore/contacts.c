@@ -0,0 +1,139 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#include "contacts.h"
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include "ed25519/ed_25519.h"
+
+void meshcore_contacts_init(meshcore_contacts_t* contacts) {
+    memset(contacts, 0, sizeof(meshcore_contacts_t));
+    memset(contacts->buckets, MESHCORE_CONTACT_NONE, sizeof(contacts->buckets));
+}
+
+static meshcore_contact_t* meshcore_contacts_find_by_key(meshcore_contacts_t* contacts, const uint8_t* pub_key) {
+    meshcore_contact_t* contact = NULL;
+    while ((contact = meshcore_contacts_find_by_hash(contacts, meshcore_contact_hash(pub_key), contact)) != NULL) {
+        if (memcmp(contact->pub_key, pub_key, MESHCORE_PUB_KEY_SIZE) == 0) {
+            return contact;
+        }
+    }
+    return NULL;
+}
+
+meshcore_contact_t* meshcore_contacts_update(meshcore_contacts_t* contacts, const meshcore_advert_t* advert,
+                                             const uint8_t* own_private_key) {
+    if (contacts == NULL || advert == NULL) {
+        return NULL;
+    }
+
+    meshcore_contact_t* contact = meshcore_contacts_find_by_key(contacts, advert->pub_key);
+
+    if (contact == NULL) {
+        if (contacts->count >= MESHCORE_MAX_CONTACTS) {
+            return NULL;
+        }
+
+        uint8_t index = contacts->count;
+        uint8_t hash  = meshcore_contact_hash(advert->pub_key);
+
+        contact = &contacts->contacts[index];
+        memset(contact, 0, sizeof(meshcore_contact_t));
+        memcpy(contact->pub_key, advert->pub_key, MESHCORE_PUB_KEY_SIZE);
+        contact->valid = true;
+
+        if (own_private_key != NULL) {
+            ed25519_key_exchange(contact->shared_secret, contact->pub_key, own_private_key);
+        }
+
+        contact->next           = contacts->buckets[hash];
+        contacts->count         = index + 1;
+        contacts->buckets[hash] = index;
+    } else if (advert->timestamp <= contact->last_advert_timestamp) {
+        // Replayed or older advertisement, keep what we have
+        return contact;
+    }
+
+    contact->role                  = advert->role;
+    contact->last_advert_timestamp = advert->timestamp;
+    if (advert->name_valid) {
+        snprintf(contact->name, sizeof(contact->name), "%s", advert->name);
+    }
+
+    return contact;
+}
+
+meshcore_contact_t* meshcore_contacts_find_by_hash(meshcore_contacts_t* contacts, uint8_t hash,
+                                                   const meshcore_contact_t* previous) {
+    if (contacts == NULL) {
+        return NULL;
+    }
+
+    uint8_t index = (previous == NULL) ? contacts->buckets[hash] : previous->next;
+    if (index == MESHCORE_CONTACT_NONE || index >= contacts->count) {
+        return NULL;
+    }
+
+    return &contacts->contacts[index];
+}
+
+// Whether a contact's public key starts with the given hex digits, an odd trailing digit matches the high nibble
+static bool key_has_prefix(const uint8_t* pub_key, const char* hex) {
+    size_t length = strlen(hex);
+    if (length > MESHCORE_PUB_KEY_SIZE * 2) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        int digit = tolower((unsigned char)hex[i]);
+        if (!isxdigit(digit)) {
+            return false;
+        }
+        uint8_t value  = isdigit(digit) ? digit - '0' : digit - 'a' + 10;
+        uint8_t nibble = (i % 2 == 0) ? pub_key[i / 2] >> 4 : pub_key[i / 2] & 0x0F;
+        if (value != nibble) {
+            return false;
+        }
+    }
+    return true;
+}
+
+meshcore_contact_t* meshcore_contacts_find_by_name(meshcore_contacts_t* contacts, const char* name,
+                                                   bool* out_ambiguous) {
+    if (out_ambiguous != NULL) {
+        *out_ambiguous = false;
+    }
+    if (contacts == NULL || name == NULL || name[0] == '\0') {
+        return NULL;
+    }
+
+    // Exact names first, then public key prefixes so contacts sharing a name can still be told apart
+    meshcore_contact_t* found   = NULL;
+    uint8_t             matches = 0;
+    for (uint8_t i = 0; i < contacts->count; i++) {
+        if (strcasecmp(contacts->contacts[i].name, name) == 0) {
+            found = &contacts->contacts[i];
+            matches++;
+        }
+    }
+    if (matches == 0) {
+        for (uint8_t i = 0; i < contacts->count; i++) {
+            if (key_has_prefix(contacts->contacts[i].pub_key, name)) {
+                found = &contacts->contacts[i];
+                matches++;
+            }
+        }
+    }
+
+    if (matches > 1) {
+        if (out_ambiguous != NULL) {
+            *out_ambiguous = true;
+        }
+        return NULL;
+    }
+    return found;
+}
@@ -0,0 +1,58 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "cipher.h"
+#include "packet.h"
+#include "payload/advert.h"
+
+// Definitions
+
+#define MESHCORE_MAX_CONTACTS    32
+#define MESHCORE_CONTACT_NONE    0xFF
+#define MESHCORE_CONTACT_BUCKETS 256
+
+typedef struct {
+    bool                   valid;
+    uint8_t                pub_key[MESHCORE_PUB_KEY_SIZE];
+    char                   name[MESHCORE_MAX_NAME_SIZE + sizeof('\0')];
+    meshcore_device_role_t role;
+    uint32_t               last_advert_timestamp;
+    uint8_t                shared_secret[MESHCORE_SHARED_SECRET_SIZE];  // Computed once when the contact is added
+    uint8_t                next;                                       // Next contact with the same hash
+} meshcore_contact_t;
+
+typedef struct {
+    meshcore_contact_t contacts[MESHCORE_MAX_CONTACTS];
+    uint8_t            buckets[MESHCORE_CONTACT_BUCKETS];  // First contact index per public key hash
+    uint8_t            count;
+} meshcore_contacts_t;
+
+// Functions
+
+/// Initialize an empty contact table. The table does no locking, tasks sharing it serialize their access.
+void meshcore_contacts_init(meshcore_contacts_t* contacts);
+
+/// Add a contact or refresh an existing one from a verified advertisement. The shared secret is derived from our own
+/// private key only when the contact is first added. Returns the contact or NULL when the table is full.
+meshcore_contact_t* meshcore_contacts_update(meshcore_contacts_t* contacts, const meshcore_advert_t* advert,
+                                             const uint8_t* own_private_key);
+
+/// Iterate over the contacts whose public key hash matches, pass NULL as previous to get the first match
+meshcore_contact_t* meshcore_contacts_find_by_hash(meshcore_contacts_t* contacts, uint8_t hash,
+                                                   const meshcore_contact_t* previous);
+
+/// Find a contact by its full name (case-insensitive) or, when no name matches, by a hex prefix of its public key.
+/// Returns NULL when nothing matches or when more than one contact does, out_ambiguous (may be NULL) tells them apart.
+meshcore_contact_t* meshcore_contacts_find_by_name(meshcore_contacts_t* contacts, const char* name,
+                                                   bool* out_ambiguous);
+
+/// Get the hash used to address a node in packet headers and paths
+static inline uint8_t meshcore_contact_hash(const uint8_t* pub_key) {
+    return pub_key[0];
+}
@@ -0,0 +1,67 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#include "flood.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "crypto/sha256.h"
+#include "packet.h"
+
+void meshcore_packet_hash(const meshcore_message_t* message, uint8_t* out_hash) {
+    uint8_t       type = message->type;
+    Sha256Context context;
+    SHA256_HASH   digest;
+
+    Sha256Initialise(&context);
+    Sha256Update(&context, &type, sizeof(type));
+    if (message->type == MESHCORE_PAYLOAD_TYPE_TRACE) {
+        // Trace packets collect per hop data in the path, the path length keeps the hops apart
+        Sha256Update(&context, &message->path_length, sizeof(message->path_length));
+    }
+    Sha256Update(&context, message->payload, message->payload_length);
+    Sha256Finalise(&context, &digest);
+
+    memcpy(out_hash, digest.bytes, MESHCORE_PACKET_HASH_SIZE);
+}
+
+void meshcore_flood_init(meshcore_flood_t* flood) {
+    memset(flood, 0, sizeof(meshcore_flood_t));
+}
+
+bool meshcore_flood_check_seen(meshcore_flood_t* flood, const uint8_t* hash) {
+    for (size_t i = 0; i < flood->count; i++) {
+        if (memcmp(flood->hashes[i], hash, MESHCORE_PACKET_HASH_SIZE) == 0) {
+            return true;
+        }
+    }
+
+    memcpy(flood->hashes[flood->next], hash, MESHCORE_PACKET_HASH_SIZE);
+    flood->next = (flood->next + 1) % MESHCORE_FLOOD_SEEN_SIZE;
+    if (flood->count < MESHCORE_FLOOD_SEEN_SIZE) {
+        flood->count++;
+    }
+    return false;
+}
+
+int meshcore_flood_prepare_forward(meshcore_message_t* message, uint8_t own_hash) {
+    if (message->route != MESHCORE_ROUTE_TYPE_FLOOD && message->route != MESHCORE_ROUTE_TYPE_TRANSPORT_FLOOD) {
+        return -1;
+    }
+
+    if (message->path_length + MESHCORE_PATH_HASH_SIZE > MESHCORE_MAX_PATH_SIZE) {
+        return -1;
+    }
+
+    for (uint8_t i = 0; i < message->path_length; i += MESHCORE_PATH_HASH_SIZE) {
+        if (message->path[i] == own_hash) {
+            return -1;
+        }
+    }
+
+    message->path[message->path_length]  = own_hash;
+    message->path_length                += MESHCORE_PATH_HASH_SIZE;
+
+    return 0;
+}
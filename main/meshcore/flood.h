@@ -0,0 +1,36 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "packet.h"
+
+// Definitions
+
+#define MESHCORE_PACKET_HASH_SIZE MESHCORE_MAX_HASH_SIZE
+#define MESHCORE_FLOOD_SEEN_SIZE  128  // Recently seen packets remembered for duplicate suppression
+
+typedef struct {
+    uint8_t hashes[MESHCORE_FLOOD_SEEN_SIZE][MESHCORE_PACKET_HASH_SIZE];
+    size_t  next;   // Slot overwritten by the next new packet
+    size_t  count;  // Slots in use
+} meshcore_flood_t;
+
+// Functions
+
+/// Calculate the hash identifying a packet independent of the path it took (payload type and payload)
+void meshcore_packet_hash(const meshcore_message_t* message, uint8_t* out_hash);
+
+/// Initialize an empty table of seen packets
+void meshcore_flood_init(meshcore_flood_t* flood);
+
+/// Check whether a packet hash has been seen before, remembers it when it has not
+bool meshcore_flood_check_seen(meshcore_flood_t* flood, const uint8_t* hash);
+
+/// Prepare a received flood packet for retransmission by appending our own hash to its path. Returns -1 when the packet
+/// should not be forwarded: not a flood packet, already forwarded by us or no room left in the path.
+int meshcore_flood_prepare_forward(meshcore_message_t* message, uint8_t own_hash);
@@ -0,0 +1,419 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#include "multipart.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "packet.h"
+
+static uint16_t full_mask(uint8_t count) {
+    return (uint16_t)((1UL << count) - 1);
+}
+
+static uint8_t block_alloc(meshcore_multipart_t* multipart) {
+    if (multipart->free_blocks == 0) {
+        return MESHCORE_MULTIPART_NO_BLOCK;
+    }
+    uint8_t block           = __builtin_ctz(multipart->free_blocks);
+    multipart->free_blocks &= ~(1UL << block);
+    return block;
+}
+
+static void blocks_free(meshcore_multipart_t* multipart, uint8_t* blocks) {
+    for (uint8_t i = 0; i < MESHCORE_MULTIPART_MAX_PARTS; i++) {
+        if (blocks[i] != MESHCORE_MULTIPART_NO_BLOCK) {
+            multipart->free_blocks |= 1UL << blocks[i];
+            blocks[i]               = MESHCORE_MULTIPART_NO_BLOCK;
+        }
+    }
+}
+
+static void rx_release(meshcore_multipart_t* multipart, meshcore_multipart_rx_t* rx) {
+    blocks_free(multipart, rx->blocks);
+    rx->active = false;
+}
+
+// Release a reassembly that completed or was given up, and drop the copies of its fragments that are still underway
+static void rx_finish(meshcore_multipart_t* multipart, meshcore_multipart_rx_t* rx, int64_t now) {
+    meshcore_multipart_done_t* done = &multipart->done[multipart->next_done];
+    done->source                    = rx->source;
+    done->sequence                  = rx->sequence;
+    done->until                     = now + MESHCORE_MULTIPART_DONE_HOLD;
+    multipart->next_done            = (multipart->next_done + 1) % MESHCORE_MULTIPART_DONE_SLOTS;
+    rx_release(multipart, rx);
+}
+
+// Copies can trail behind for a long time on a busy channel, every late one extends the hold
+static bool is_done(meshcore_multipart_t* multipart, uint8_t source, uint8_t sequence, int64_t now) {
+    for (uint8_t i = 0; i < MESHCORE_MULTIPART_DONE_SLOTS; i++) {
+        meshcore_multipart_done_t* done = &multipart->done[i];
+        if (now < done->until && done->source == source && done->sequence == sequence) {
+            done->until = now + MESHCORE_MULTIPART_DONE_HOLD;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void tx_release(meshcore_multipart_t* multipart, meshcore_multipart_tx_t* tx) {
+    blocks_free(multipart, tx->blocks);
+    tx->active = false;
+}
+
+void meshcore_multipart_init(meshcore_multipart_t* multipart, uint8_t own_hash, uint32_t random) {
+    memset(multipart, 0, sizeof(meshcore_multipart_t));
+    multipart->own_hash      = own_hash;
+    multipart->next_sequence = (uint8_t)random;
+    multipart->free_blocks   = (uint32_t)((1ULL << MESHCORE_MULTIPART_BLOCKS) - 1);
+    multipart->types         = MESHCORE_MULTIPART_ALL_TYPES;
+    for (uint8_t i = 0; i < MESHCORE_MULTIPART_RX_SLOTS; i++) {
+        memset(multipart->rx[i].blocks, MESHCORE_MULTIPART_NO_BLOCK, sizeof(multipart->rx[i].blocks));
+    }
+    for (uint8_t i = 0; i < MESHCORE_MULTIPART_TX_SLOTS; i++) {
+        memset(multipart->tx[i].blocks, MESHCORE_MULTIPART_NO_BLOCK, sizeof(multipart->tx[i].blocks));
+    }
+}
+
+void meshcore_multipart_set_types(meshcore_multipart_t* multipart, uint16_t types) {
+    multipart->types = types & MESHCORE_MULTIPART_ALL_TYPES;
+}
+
+int meshcore_multipart_send(meshcore_multipart_t* multipart, uint8_t type, const uint8_t* data, size_t length,
+                            int64_t now) {
+    if (data == NULL || length == 0 || length > MESHCORE_MULTIPART_MAX_SIZE) {
+        return -1;
+    }
+
+    if (type > 0x0F || type == MESHCORE_PAYLOAD_TYPE_MULTIPART) {
+        return -1;
+    }
+
+    uint8_t count = (length + MESHCORE_MULTIPART_FRAGMENT_SIZE - 1) / MESHCORE_MULTIPART_FRAGMENT_SIZE;
+    if (__builtin_popcount(multipart->free_blocks) < count) {
+        return -1;
+    }
+
+    // Prefer a free slot, otherwise take over the completely sent payload that would expire first
+    meshcore_multipart_tx_t* tx = NULL;
+    for (uint8_t i = 0; i < MESHCORE_MULTIPART_TX_SLOTS; i++) {
+        meshcore_multipart_tx_t* candidate = &multipart->tx[i];
+        if (!candidate->active) {
+            tx = candidate;
+            break;
+        }
+        if (candidate->pending == 0 && (tx == NULL || candidate->expires < tx->expires)) {
+            tx = candidate;
+        }
+    }
+    if (tx == NULL) {
+        return -1;
+    }
+    if (tx->active) {
+        tx_release(multipart, tx);
+        if (__builtin_popcount(multipart->free_blocks) < count) {
+            return -1;
+        }
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        size_t offset = (size_t)i * MESHCORE_MULTIPART_FRAGMENT_SIZE;
+        size_t part   = length - offset;
+        if (part > MESHCORE_MULTIPART_FRAGMENT_SIZE) {
+            part = MESHCORE_MULTIPART_FRAGMENT_SIZE;
+        }
+        tx->blocks[i] = block_alloc(multipart);
+        memcpy(multipart->blocks[tx->blocks[i]], &data[offset], part);
+        tx->last_length = part;
+    }
+
+    tx->active   = true;
+    tx->sequence = multipart->next_sequence++;
+    tx->type     = type;
+    tx->count    = count;
+    tx->pending  = full_mask(count);
+    tx->expires  = now + MESHCORE_MULTIPART_TX_HOLD;
+
+    return tx->sequence;
+}
+
+static int64_t earliest(int64_t next, int64_t candidate) {
+    return (next < 0 || candidate < next) ? candidate : next;
+}
+
+int64_t meshcore_multipart_due(const meshcore_multipart_t* multipart, int64_t now) {
+    int64_t next = -1;
+
+    for (uint8_t i = 0; i < MESHCORE_MULTIPART_TX_SLOTS; i++) {
+        const meshcore_multipart_tx_t* tx = &multipart->tx[i];
+        if (!tx->active) {
+            continue;
+        }
+        if (tx->pending != 0) {
+            return 0;
+        }
+        next = earliest(next, tx->expires);
+    }
+
+    for (uint8_t i = 0; i < MESHCORE_MULTIPART_RX_SLOTS; i++) {
+        const meshcore_multipart_rx_t* rx = &multipart->rx[i];
+        if (rx->active) {
+            next = earliest(next, rx->last_activity + MESHCORE_MULTIPART_GAP_TIMEOUT);
+            next = earliest(next, rx->started + MESHCORE_MULTIPART_RX_TIMEOUT);
+        }
+    }
+
+    if (next < 0) {
+        return -1;
+    }
+    return next > now ? next - now : 0;
+}
+
+static void build_message(meshcore_message_t* out_message) {
+    memset(out_message, 0, sizeof(meshcore_message_t));
+    out_message->type    = MESHCORE_PAYLOAD_TYPE_MULTIPART;
+    out_message->route   = MESHCORE_ROUTE_TYPE_FLOOD;
+    out_message->version = 0x00;
+}
+
+static void build_request(meshcore_multipart_t* multipart, const meshcore_multipart_rx_t* rx,
+                          meshcore_message_t* out_message) {
+    uint16_t missing = full_mask(rx->count) & ~rx->received;
+
+    build_message(out_message);
+    uint8_t* payload = out_message->payload;
+    payload[0]       = MESHCORE_PAYLOAD_TYPE_MULTIPART;
+    payload[1]       = rx->source;
+    payload[2]       = rx->sequence;
+    payload[3]       = multipart->own_hash;
+    payload[4]       = missing & 0xFF;
+    payload[5]       = missing >> 8;
+
+    out_message->payload_length = MESHCORE_MULTIPART_REQUEST_SIZE;
+}
+
+static void build_fragment(meshcore_multipart_t* multipart, const meshcore_multipart_tx_t* tx, uint8_t index,
+                           meshcore_message_t* out_message) {
+    uint8_t length = (index == tx->count - 1) ? tx->last_length : MESHCORE_MULTIPART_FRAGMENT_SIZE;
+
+    build_message(out_message);
+    uint8_t* payload = out_message->payload;
+    payload[0]       = ((tx->count - 1 - index) << 4) | tx->type;
+    payload[1]       = multipart->own_hash;
+    payload[2]       = tx->sequence;
+    payload[3]       = (index << 4) | (tx->count - 1);
+    memcpy(&payload[MESHCORE_MULTIPART_HEADER_SIZE], multipart->blocks[tx->blocks[index]], length);
+
+    out_message->payload_length = MESHCORE_MULTIPART_HEADER_SIZE + length;
+}
+
+int meshcore_multipart_build(meshcore_multipart_t* multipart, int64_t now, meshcore_message_t* out_message) {
+    for (uint8_t i = 0; i < MESHCORE_MULTIPART_TX_SLOTS; i++) {
+        meshcore_multipart_tx_t* tx = &multipart->tx[i];
+        if (tx->active && tx->pending == 0 && now >= tx->expires) {
+            tx_release(multipart, tx);
+        }
+    }
+
+    // Requests first, they are short and unblock transfers that are otherwise stuck
+    for (uint8_t i = 0; i < MESHCORE_MULTIPART_RX_SLOTS; i++) {
+        meshcore_multipart_rx_t* rx = &multipart->rx[i];
+        if (!rx->active) {
+            continue;
+        }
+        if (now >= rx->started + MESHCORE_MULTIPART_RX_TIMEOUT) {
+            rx_finish(multipart, rx, now);
+            multipart->stats.expired++;
+            continue;
+        }
+        if (now < rx->last_activity + MESHCORE_MULTIPART_GAP_TIMEOUT) {
+            continue;
+        }
+        if (rx->requests >= MESHCORE_MULTIPART_MAX_REQUESTS) {
+            rx_finish(multipart, rx, now);
+            multipart->stats.expired++;
+            continue;
+        }
+        build_request(multipart, rx, out_message);
+        rx->requests++;
+        rx->last_activity = now;
+        multipart->stats.requests_sent++;
+        return 1;
+    }
+
+    for (uint8_t i = 0; i < MESHCORE_MULTIPART_TX_SLOTS; i++) {
+        meshcore_multipart_tx_t* tx = &multipart->tx[i];
+        if (!tx->active || tx->pending == 0) {
+            continue;
+        }
+        uint8_t index = __builtin_ctz(tx->pending);
+        build_fragment(multipart, tx, index, out_message);
+        tx->pending &= ~(1U << index);
+        if (tx->pending == 0) {
+            tx->expires = now + MESHCORE_MULTIPART_TX_HOLD;
+        }
+        multipart->stats.fragments_sent++;
+        return 1;
+    }
+
+    return 0;
+}
+
+static int receive_request(meshcore_multipart_t* multipart, const meshcore_message_t* message, int64_t now) {
+    if (message->payload_length < MESHCORE_MULTIPART_REQUEST_SIZE) {
+        return -1;
+    }
+
+    const uint8_t* payload = message->payload;
+    if (payload[1] != multipart->own_hash) {
+        // Someone else asked for a payload we are missing parts of as well, wait for the resent fragments
+        for (uint8_t i = 0; i < MESHCORE_MULTIPART_RX_SLOTS; i++) {
+            meshcore_multipart_rx_t* rx = &multipart->rx[i];
+            if (rx->active && rx->source == payload[1] && rx->sequence == payload[2] &&
+                payload[3] != multipart->own_hash) {
+                rx->last_activity = now;
+                multipart->stats.requests_held++;
+                break;
+            }
+        }
+        return 0;
+    }
+
+    multipart->stats.requests_received++;
+    uint16_t missing = payload[4] | (payload[5] << 8);
+    for (uint8_t i = 0; i < MESHCORE_MULTIPART_TX_SLOTS; i++) {
+        meshcore_multipart_tx_t* tx = &multipart->tx[i];
+        if (tx->active && tx->sequence == payload[2]) {
+            tx->pending |= missing & full_mask(tx->count);
+            break;
+        }
+    }
+
+    return 0;
+}
+
+static meshcore_multipart_rx_t* rx_find(meshcore_multipart_t* multipart, uint8_t source, uint8_t sequence) {
+    meshcore_multipart_rx_t* free_slot = NULL;
+    for (uint8_t i = 0; i < MESHCORE_MULTIPART_RX_SLOTS; i++) {
+        meshcore_multipart_rx_t* rx = &multipart->rx[i];
+        if (rx->active && rx->source == source && rx->sequence == sequence) {
+            return rx;
+        }
+        if (!rx->active && free_slot == NULL) {
+            free_slot = rx;
+        }
+    }
+    return free_slot;
+}
+
+int meshcore_multipart_receive(meshcore_multipart_t* multipart, const meshcore_message_t* message, int64_t now,
+                               uint8_t* out_data, meshcore_multipart_result_t* out_result) {
+    if (message == NULL || out_data == NULL || out_result == NULL) {
+        return -1;
+    }
+
+    if (message->payload_length < 1) {
+        return -1;
+    }
+
+    const uint8_t* payload = message->payload;
+    uint8_t        type    = payload[0] & 0x0F;
+    if (type == MESHCORE_PAYLOAD_TYPE_MULTIPART) {
+        return receive_request(multipart, message, now);
+    }
+
+    if (message->payload_length <= MESHCORE_MULTIPART_HEADER_SIZE) {
+        return -1;
+    }
+
+    uint8_t remaining = payload[0] >> 4;
+    uint8_t source    = payload[1];
+    uint8_t sequence  = payload[2];
+    uint8_t index     = payload[3] >> 4;
+    uint8_t count     = (payload[3] & 0x0F) + 1;
+    uint8_t length    = message->payload_length - MESHCORE_MULTIPART_HEADER_SIZE;
+
+    if (index >= count || remaining != count - 1 - index) {
+        return -1;
+    }
+
+    // Only the last fragment can be shorter
+    if (index < count - 1 && length != MESHCORE_MULTIPART_FRAGMENT_SIZE) {
+        return -1;
+    }
+
+    // Our own fragments repeated back to us, and payloads nobody here has a use for
+    if (source == multipart->own_hash || !(multipart->types & (1U << type))) {
+        return 0;
+    }
+
+    if (is_done(multipart, source, sequence, now)) {
+        multipart->stats.late_fragments++;
+        return 0;
+    }
+
+    meshcore_multipart_rx_t* rx = rx_find(multipart, source, sequence);
+    if (rx == NULL) {
+        multipart->stats.no_buffer++;
+        return 0;
+    }
+
+    if (!rx->active) {
+        rx->active        = true;
+        rx->source        = source;
+        rx->sequence      = sequence;
+        rx->type          = type;
+        rx->count         = count;
+        rx->received      = 0;
+        rx->last_length   = 0;
+        rx->requests      = 0;
+        rx->started       = now;
+        rx->last_activity = now;
+    } else if (rx->type != type || rx->count != count) {
+        return -1;
+    }
+
+    if (rx->received & (1U << index)) {
+        return 0;
+    }
+
+    uint8_t block = block_alloc(multipart);
+    if (block == MESHCORE_MULTIPART_NO_BLOCK) {
+        multipart->stats.no_buffer++;
+        if (rx->received == 0) {
+            rx_release(multipart, rx);
+        }
+        return 0;
+    }
+
+    memcpy(multipart->blocks[block], &payload[MESHCORE_MULTIPART_HEADER_SIZE], length);
+    rx->blocks[index]  = block;
+    rx->received      |= 1U << index;
+    rx->last_activity  = now;
+    if (index == count - 1) {
+        rx->last_length = length;
+    }
+    multipart->stats.fragments_received++;
+
+    if (rx->received != full_mask(rx->count)) {
+        return 0;
+    }
+
+    size_t position = 0;
+    for (uint8_t i = 0; i < rx->count; i++) {
+        size_t part = (i == rx->count - 1) ? rx->last_length : MESHCORE_MULTIPART_FRAGMENT_SIZE;
+        memcpy(&out_data[position], multipart->blocks[rx->blocks[i]], part);
+        position += part;
+    }
+
+    out_result->type     = rx->type;
+    out_result->source   = rx->source;
+    out_result->sequence = rx->sequence;
+    out_result->length   = position;
+
+    rx_finish(multipart, rx, now);
+    multipart->stats.completed++;
+
+    return 1;
+}
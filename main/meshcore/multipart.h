@@ -0,0 +1,146 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "packet.h"
+
+// Definitions
+
+/*
+Fragment header, the first byte has the same layout as a MeshCore multipart packet:
+
+0: remaining fragments (upper 4 bits), payload type of the reassembled payload (lower 4 bits)
+1: hash of the node that sent the payload
+2: sequence number, chosen by the sender
+3: fragment index (upper 4 bits), fragment count minus one (lower 4 bits)
+
+A resend request uses the multipart payload type itself as type, which is never a valid type for a reassembled payload:
+
+0: 0x0A
+1: hash of the node that sent the payload
+2: sequence number
+3: hash of the requesting node
+4: bitmap of the missing fragments (little endian uint16)
+
+Fragments are flooded, so copies keep arriving from other repeaters after a payload was reassembled. Finished transfers
+are remembered for as long as their sender may still resend, late copies of their fragments are dropped. A node that
+overhears a request for a payload it is reassembling holds back its own, the resent fragments reach it as well.
+*/
+
+#define MESHCORE_MULTIPART_HEADER_SIZE   4
+#define MESHCORE_MULTIPART_REQUEST_SIZE  6
+#define MESHCORE_MULTIPART_FRAGMENT_SIZE (MESHCORE_MAX_PAYLOAD_SIZE - MESHCORE_MULTIPART_HEADER_SIZE)
+#define MESHCORE_MULTIPART_MAX_PARTS     16
+#define MESHCORE_MULTIPART_MAX_SIZE      (MESHCORE_MULTIPART_MAX_PARTS * MESHCORE_MULTIPART_FRAGMENT_SIZE)
+
+#define MESHCORE_MULTIPART_NO_BLOCK     0xFF
+#define MESHCORE_MULTIPART_BLOCKS       32           // Fragment buffers shared by all transfers
+#define MESHCORE_MULTIPART_RX_SLOTS     4            // Payloads being reassembled at the same time
+#define MESHCORE_MULTIPART_TX_SLOTS     2            // Sent payloads kept for resend requests
+#define MESHCORE_MULTIPART_GAP_TIMEOUT  (4 * 1000)   // Milliseconds without a fragment before requesting missing ones
+#define MESHCORE_MULTIPART_MAX_REQUESTS 3            // Resend requests before a reassembly is given up
+#define MESHCORE_MULTIPART_RX_TIMEOUT   (30 * 1000)  // Milliseconds a reassembly may take in total
+#define MESHCORE_MULTIPART_TX_HOLD      (30 * 1000)  // Milliseconds a sent payload is kept after its last fragment
+#define MESHCORE_MULTIPART_DONE_SLOTS   8            // Finished transfers remembered
+
+// Milliseconds a finished transfer is remembered, long enough for every resend its sender may still make
+#define MESHCORE_MULTIPART_DONE_HOLD (MESHCORE_MULTIPART_RX_TIMEOUT + MESHCORE_MULTIPART_TX_HOLD)
+
+// Every payload type but the multipart type itself
+#define MESHCORE_MULTIPART_ALL_TYPES (0xFFFF & ~(1U << MESHCORE_PAYLOAD_TYPE_MULTIPART))
+
+typedef struct {
+    bool     active;
+    uint8_t  source;
+    uint8_t  sequence;
+    uint8_t  type;
+    uint8_t  count;                                 // Fragments in the payload
+    uint16_t received;                              // Bitmap of the fragments received
+    uint8_t  blocks[MESHCORE_MULTIPART_MAX_PARTS];  // Block holding each fragment
+    uint8_t  last_length;                           // Length of the last fragment, known once it arrived
+    uint8_t  requests;                              // Resend requests sent
+    int64_t  started;                               // Milliseconds on the caller's monotonic clock
+    int64_t  last_activity;
+} meshcore_multipart_rx_t;
+
+typedef struct {
+    bool     active;
+    uint8_t  sequence;
+    uint8_t  type;
+    uint8_t  count;
+    uint16_t pending;  // Bitmap of the fragments still to be sent
+    uint8_t  blocks[MESHCORE_MULTIPART_MAX_PARTS];
+    uint8_t  last_length;
+    int64_t  expires;
+} meshcore_multipart_tx_t;
+
+typedef struct {
+    uint8_t source;
+    uint8_t sequence;
+    int64_t until;  // Milliseconds, late fragments are dropped until then
+} meshcore_multipart_done_t;
+
+typedef struct {
+    uint32_t fragments_sent;
+    uint32_t fragments_received;
+    uint32_t completed;
+    uint32_t requests_sent;
+    uint32_t requests_received;
+    uint32_t expired;         // Reassemblies given up
+    uint32_t no_buffer;       // Fragments dropped because no slot or block was free
+    uint32_t requests_held;   // Own requests postponed because another node asked first
+    uint32_t late_fragments;  // Copies of fragments of finished transfers
+} meshcore_multipart_stats_t;
+
+typedef struct {
+    uint8_t                    own_hash;
+    uint8_t                    next_sequence;
+    uint32_t                   free_blocks;  // Bitmap of the free blocks
+    uint8_t                    blocks[MESHCORE_MULTIPART_BLOCKS][MESHCORE_MULTIPART_FRAGMENT_SIZE];
+    meshcore_multipart_rx_t    rx[MESHCORE_MULTIPART_RX_SLOTS];
+    meshcore_multipart_tx_t    tx[MESHCORE_MULTIPART_TX_SLOTS];
+    meshcore_multipart_done_t  done[MESHCORE_MULTIPART_DONE_SLOTS];
+    uint8_t                    next_done;
+    uint16_t                   types;  // Bitmap of the payload types that are reassembled
+    meshcore_multipart_stats_t stats;
+} meshcore_multipart_t;
+
+// Reassembled payload
+typedef struct {
+    uint8_t  type;
+    uint8_t  source;
+    uint8_t  sequence;
+    uint16_t length;
+} meshcore_multipart_result_t;
+
+// Functions
+
+/// Initialize the fragmentation state of a node, the sequence numbers start at a random value
+void meshcore_multipart_init(meshcore_multipart_t* multipart, uint8_t own_hash, uint32_t random);
+
+/// Choose the payload types that are reassembled, one bit per type. Fragments of other types are ignored, so a node
+/// without a use for a payload never asks for its missing fragments. All types are reassembled after initialization.
+void meshcore_multipart_set_types(meshcore_multipart_t* multipart, uint16_t types);
+
+/// Split a payload into fragments that are sent by meshcore_multipart_build(). The payload is copied, returns the
+/// sequence number or -1 when it is too large or no slot or blocks are free.
+int meshcore_multipart_send(meshcore_multipart_t* multipart, uint8_t type, const uint8_t* data, size_t length,
+                            int64_t now);
+
+/// Get the milliseconds until meshcore_multipart_build() has something to do, 0 when a frame is ready now and -1 when
+/// nothing is in progress
+int64_t meshcore_multipart_due(const meshcore_multipart_t* multipart, int64_t now);
+
+/// Build the next frame to transmit: a pending fragment or a resend request for a stalled reassembly. Expired
+/// transfers are released here. Returns 1 when a message was built and 0 when there is nothing to send.
+int meshcore_multipart_build(meshcore_multipart_t* multipart, int64_t now, meshcore_message_t* out_message);
+
+/// Handle a received multipart message. Returns 1 when a payload is complete, it is copied to out_data which must hold
+/// MESHCORE_MULTIPART_MAX_SIZE bytes. Returns 0 when the message was consumed and -1 when it is malformed.
+int meshcore_multipart_receive(meshcore_multipart_t* multipart, const meshcore_message_t* message, int64_t now,
+                               uint8_t* out_data, meshcore_multipart_result_t* out_result);
@@ -17,8 +17,7 @@
 #define PACKET_HEADER_VER_MASK    0x03  // 2-bits
 
 typedef struct __attribute__((packed)) {
-    uint8_t  header;
-    uint16_t transport_codes[0];
+    uint8_t header;
 } meshcore_line_header_t;
 
 int meshcore_serialize(const meshcore_message_t* message, uint8_t* out_data, uint8_t* out_size) {
@@ -44,8 +43,8 @@ int meshcore_serialize(const meshcore_message_t* message, uint8_t* out_data, uin
     if (message->route == MESHCORE_ROUTE_TYPE_TRANSPORT_FLOOD ||
         message->route == MESHCORE_ROUTE_TYPE_TRANSPORT_DIRECT) {
         // The message has transport codes
-        memcpy(&out_data[position], message->transport_codes, member_size(meshcore_line_header_t, transport_codes));
-        position += member_size(meshcore_line_header_t, transport_codes);
+        memcpy(&out_data[position], message->transport_codes, member_size(meshcore_message_t, transport_codes));
+        position += member_size(meshcore_message_t, transport_codes);
     }
 
     out_data[position]  = message->path_length;
@@ -84,12 +83,11 @@ int meshcore_deserialize(uint8_t* data, uint8_t size, meshcore_message_t* out_me
     if (out_message->route == MESHCORE_ROUTE_TYPE_TRANSPORT_FLOOD ||
         out_message->route == MESHCORE_ROUTE_TYPE_TRANSPORT_DIRECT) {
         // The message has transport codes
-        if (size - position < sizeof(uint16_t)) {
+        if (size - position < member_size(meshcore_message_t, transport_codes)) {
             return -1;
         }
-        memcpy(out_message->transport_codes, line_header->transport_codes,
-               member_size(meshcore_line_header_t, transport_codes));
-        position += member_size(meshcore_line_header_t, transport_codes);
+        memcpy(out_message->transport_codes, &data[position], member_size(meshcore_message_t, transport_codes));
+        position += member_size(meshcore_message_t, transport_codes);
     }
 
     if (size - position < sizeof(uint8_t)) {
@@ -99,23 +97,19 @@ int meshcore_deserialize(uint8_t* data, uint8_t size, meshcore_message_t* out_me
     out_message->path_length  = data[position];
     position                 += sizeof(uint8_t);
 
-    uint8_t* path  = &data[position];
-    position      += out_message->path_length;
-
-    if (out_message->path_length > MESHCORE_MAX_PATH_SIZE) {
+    if (out_message->path_length > MESHCORE_MAX_PATH_SIZE || out_message->path_length > size - position) {
         return -1;
     }
 
-    memcpy(out_message->path, path, out_message->path_length);
-
-    out_message->payload_length = size - position;
-    uint8_t* payload            = &data[position];
+    memcpy(out_message->path, &data[position], out_message->path_length);
+    position += out_message->path_length;
 
-    if (out_message->payload_length > MESHCORE_MAX_PAYLOAD_SIZE) {
+    if (size - position > MESHCORE_MAX_PAYLOAD_SIZE) {
         return -1;
     }
 
-    memcpy(out_message->payload, payload, out_message->payload_length);
+    out_message->payload_length = size - position;
+    memcpy(out_message->payload, &data[position], out_message->payload_length);
 
     return 0;
 }
@@ -0,0 +1,132 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#include "path_trace.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "flood.h"
+#include "packet.h"
+#include "payload/path_trace.h"
+
+void meshcore_path_tracer_init(meshcore_path_tracer_t* tracer, uint8_t own_hash, uint32_t random) {
+    memset(tracer, 0, sizeof(meshcore_path_tracer_t));
+    tracer->own_hash = own_hash;
+    tracer->next_tag = random;
+    meshcore_flood_init(&tracer->seen);
+}
+
+int meshcore_path_trace_originate(meshcore_path_tracer_t* tracer, const uint8_t* hops, uint8_t hop_count,
+                                  bool round_trip, int64_t now, meshcore_message_t* out_message) {
+    if (hops == NULL || hop_count == 0) {
+        return -1;
+    }
+
+    size_t total = round_trip ? (size_t)hop_count * 2 - 1 : hop_count;
+    if (total > MESHCORE_PATH_TRACE_MAX_HOPS) {
+        return -1;
+    }
+
+    meshcore_path_trace_t trace = {0};
+    trace.tag                   = tracer->next_tag++;
+    trace.hop_count             = total;
+    memcpy(trace.hops, hops, hop_count);
+    for (uint8_t i = hop_count; i < total; i++) {
+        trace.hops[i] = hops[total - 1 - i];
+    }
+
+    memset(out_message, 0, sizeof(meshcore_message_t));
+    out_message->type    = MESHCORE_PAYLOAD_TYPE_TRACE;
+    out_message->route   = MESHCORE_ROUTE_TYPE_DIRECT;
+    out_message->version = 0x00;
+    if (meshcore_path_trace_serialize(&trace, out_message->payload, &out_message->payload_length) < 0) {
+        return -1;
+    }
+
+    uint8_t                       index  = tracer->next_result;
+    meshcore_path_trace_result_t* result = &tracer->results[index];
+    memset(result, 0, sizeof(meshcore_path_trace_result_t));
+    result->state     = MESHCORE_PATH_TRACE_STATE_PENDING;
+    result->tag       = trace.tag;
+    result->hop_count = trace.hop_count;
+    memcpy(result->hops, trace.hops, trace.hop_count);
+    result->sent_at     = now;
+    tracer->next_result = (index + 1) % MESHCORE_PATH_TRACE_RESULTS;
+
+    return index;
+}
+
+static int complete(meshcore_path_tracer_t* tracer, const meshcore_message_t* message,
+                    const meshcore_path_trace_t* trace, int8_t snr, int64_t received_at, uint8_t* out_result) {
+    for (uint8_t i = 0; i < MESHCORE_PATH_TRACE_RESULTS; i++) {
+        meshcore_path_trace_result_t* result = &tracer->results[i];
+        if (result->state != MESHCORE_PATH_TRACE_STATE_PENDING || result->tag != trace->tag ||
+            result->hop_count != trace->hop_count || message->path_length != trace->hop_count) {
+            continue;
+        }
+
+        // The path holds the SNR at which each hop heard the trace
+        memcpy(result->snr, message->path, message->path_length);
+        result->snr[message->path_length] = snr;
+        result->round_trip                = received_at - result->sent_at;
+        result->state                     = MESHCORE_PATH_TRACE_STATE_COMPLETE;
+        *out_result                       = i;
+        return MESHCORE_PATH_TRACE_COMPLETE;
+    }
+    return MESHCORE_PATH_TRACE_IGNORE;
+}
+
+int meshcore_path_trace_handle(meshcore_path_tracer_t* tracer, meshcore_message_t* message, int8_t snr,
+                               int64_t received_at, int64_t now, uint8_t* out_result) {
+    if (message->route != MESHCORE_ROUTE_TYPE_DIRECT && message->route != MESHCORE_ROUTE_TYPE_TRANSPORT_DIRECT) {
+        return MESHCORE_PATH_TRACE_IGNORE;
+    }
+
+    meshcore_path_trace_t trace;
+    if (meshcore_path_trace_deserialize(message->payload, message->payload_length, &trace) < 0) {
+        return -1;
+    }
+
+    if ((trace.flags & MESHCORE_PATH_TRACE_FLAGS_HASH_SIZE) != 0) {
+        return MESHCORE_PATH_TRACE_IGNORE;
+    }
+
+    // Every hop so far added one SNR byte, so the path length is the index of the next hop
+    uint8_t next = message->path_length;
+    if (next >= trace.hop_count) {
+        return complete(tracer, message, &trace, snr, received_at, out_result);
+    }
+
+    if (trace.hops[next] != tracer->own_hash || message->path_length >= MESHCORE_MAX_PATH_SIZE) {
+        return MESHCORE_PATH_TRACE_IGNORE;
+    }
+
+    uint8_t hash[MESHCORE_PACKET_HASH_SIZE];
+    meshcore_packet_hash(message, hash);
+    if (meshcore_flood_check_seen(&tracer->seen, hash)) {
+        return MESHCORE_PATH_TRACE_IGNORE;
+    }
+
+    message->path[message->path_length]  = (uint8_t)snr;
+    message->path_length                += sizeof(int8_t);
+
+    tracer->forwarded++;
+    int64_t delay                = now - received_at;
+    tracer->forward_delay_total += delay;
+    if (delay > tracer->forward_delay_max) {
+        tracer->forward_delay_max = delay;
+    }
+
+    return MESHCORE_PATH_TRACE_FORWARD;
+}
+
+void meshcore_path_trace_expire(meshcore_path_tracer_t* tracer, int64_t now) {
+    for (uint8_t i = 0; i < MESHCORE_PATH_TRACE_RESULTS; i++) {
+        meshcore_path_trace_result_t* result = &tracer->results[i];
+        bool                          late   = now - result->sent_at >= MESHCORE_PATH_TRACE_TIMEOUT;
+        if (result->state == MESHCORE_PATH_TRACE_STATE_PENDING && late) {
+            result->state = MESHCORE_PATH_TRACE_STATE_TIMED_OUT;
+        }
+    }
+}
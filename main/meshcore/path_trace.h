@@ -0,0 +1,71 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "flood.h"
+#include "packet.h"
+#include "payload/path_trace.h"
+
+// Definitions
+
+#define MESHCORE_PATH_TRACE_RESULTS 8                    // Traces we originated that are remembered
+#define MESHCORE_PATH_TRACE_TIMEOUT (30 * 1000 * 1000)  // Microseconds before an unanswered trace is given up
+
+typedef enum {
+    MESHCORE_PATH_TRACE_STATE_FREE = 0,
+    MESHCORE_PATH_TRACE_STATE_PENDING,
+    MESHCORE_PATH_TRACE_STATE_COMPLETE,
+    MESHCORE_PATH_TRACE_STATE_TIMED_OUT,
+} meshcore_path_trace_state_t;
+
+typedef enum {
+    MESHCORE_PATH_TRACE_IGNORE = 0,  // Not for us, or a duplicate
+    MESHCORE_PATH_TRACE_FORWARD,     // We are the next hop, the message was updated for retransmission
+    MESHCORE_PATH_TRACE_COMPLETE,    // One of our traces returned, its result is filled in
+} meshcore_path_trace_action_t;
+
+typedef struct {
+    meshcore_path_trace_state_t state;
+    uint32_t                    tag;
+    uint8_t                     hop_count;
+    uint8_t                     hops[MESHCORE_PATH_TRACE_MAX_HOPS];
+    int8_t                      snr[MESHCORE_PATH_TRACE_MAX_HOPS + 1];  // dB * 4 per link, the last one heard by us
+    int64_t                     sent_at;                                // Microseconds on the caller's clock
+    int64_t                     round_trip;                             // Microseconds until the trace returned
+} meshcore_path_trace_result_t;
+
+typedef struct {
+    uint8_t                      own_hash;
+    uint32_t                     next_tag;
+    meshcore_path_trace_result_t results[MESHCORE_PATH_TRACE_RESULTS];
+    uint8_t                      next_result;
+    meshcore_flood_t             seen;  // Traces already forwarded, per path length
+
+    uint32_t forwarded;
+    int64_t  forward_delay_total;  // Microseconds from reception until a forward was ready
+    int64_t  forward_delay_max;
+} meshcore_path_tracer_t;
+
+// Functions
+
+/// Initialize the trace state of a node, tags start at a random value
+void meshcore_path_tracer_init(meshcore_path_tracer_t* tracer, uint8_t own_hash, uint32_t random);
+
+/// Build a trace through the given hops. A round trip returns along the same hops, so the last hop is the node that
+/// turns it around. Returns the index of the result that tracks it, or -1 when there are too many hops.
+int meshcore_path_trace_originate(meshcore_path_tracer_t* tracer, const uint8_t* hops, uint8_t hop_count,
+                                  bool round_trip, int64_t now, meshcore_message_t* out_message);
+
+/// Handle a received trace. When we are the next hop our SNR is added to the path and the message should be sent
+/// again. When one of our traces reached the end of its path the result is completed and its index is returned in
+/// out_result. Returns -1 when the message is malformed.
+int meshcore_path_trace_handle(meshcore_path_tracer_t* tracer, meshcore_message_t* message, int8_t snr,
+                               int64_t received_at, int64_t now, uint8_t* out_result);
+
+/// Give up on traces that did not return in time
+void meshcore_path_trace_expire(meshcore_path_tracer_t* tracer, int64_t now);
@@ -33,6 +33,10 @@ int meshcore_ack_deserialize(uint8_t* data, uint8_t size, meshcore_ack_t* out_ac
 
     memset(out_ack, 0, sizeof(meshcore_ack_t));
 
+    if (size < sizeof(uint32_t)) {
+        return -1;
+    }
+
     uint8_t position = 0;
 
     memcpy(&out_ack->crc, &data[position], sizeof(uint32_t));
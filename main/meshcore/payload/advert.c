@@ -78,12 +78,21 @@ int meshcore_advert_serialize(const meshcore_advert_t* advert, uint8_t* out_payl
 }
 
 int meshcore_advert_deserialize(uint8_t* data, uint8_t size, meshcore_advert_t* out_advert) {
+    return meshcore_advert_decode(data, size, out_advert, NULL);
+}
+
+int meshcore_advert_decode(const uint8_t* data, uint8_t size, meshcore_advert_t* out_advert,
+                           meshcore_advert_signed_t* out_signed) {
     if (out_advert == NULL || data == NULL) {
         return -1;
     }
 
     memset(out_advert, 0, sizeof(meshcore_advert_t));
 
+    if (size < MESHCORE_PUB_KEY_SIZE + sizeof(uint32_t) + MESHCORE_SIGNATURE_SIZE) {
+        return -1;
+    }
+
     uint8_t position = 0;
 
     memcpy(out_advert->pub_key, &data[position], MESHCORE_PUB_KEY_SIZE);
@@ -97,6 +106,16 @@ int meshcore_advert_deserialize(uint8_t* data, uint8_t size, meshcore_advert_t*
 
     uint8_t app_data_len = size - position;
 
+    if (out_signed != NULL) {
+        // The signature covers everything but itself
+        out_signed->parts[0].data   = data;
+        out_signed->parts[0].length = MESHCORE_PUB_KEY_SIZE + sizeof(uint32_t);
+        out_signed->parts[1].data   = &data[position];
+        out_signed->parts[1].length = app_data_len;
+        out_signed->count           = app_data_len > 0 ? 2 : 1;
+        out_signed->length          = MESHCORE_PUB_KEY_SIZE + sizeof(uint32_t) + app_data_len;
+    }
+
     if (app_data_len > 0) {
         uint8_t flags  = data[position];
         position      += sizeof(uint8_t);
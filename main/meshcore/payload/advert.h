@@ -7,6 +7,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include "ed25519/ed_25519.h"
 
 // Definitions
 
@@ -14,6 +15,7 @@
 #define MESHCORE_SIGNATURE_SIZE       64
 #define MESHCORE_MAX_ADVERT_DATA_SIZE 32
 #define MESHCORE_MAX_NAME_SIZE        32
+#define MESHCORE_ADVERT_SIGNED_PARTS  2  // Public key and timestamp, then the app data
 
 typedef enum {
     MESHCORE_DEVICE_ROLE_UNKNOWN     = 0,
@@ -39,7 +41,19 @@ typedef struct {
     uint16_t               extra2;
 } meshcore_advert_t;
 
+// Byte ranges of a received payload covered by the signature, pointing into the payload itself
+typedef struct {
+    ed25519_iovec_t parts[MESHCORE_ADVERT_SIGNED_PARTS];
+    size_t          count;
+    size_t          length;  // Total of all parts
+} meshcore_advert_signed_t;
+
 // Functions
 
 int meshcore_advert_serialize(const meshcore_advert_t* advert, uint8_t* out_payload, uint8_t* out_size);
 int meshcore_advert_deserialize(uint8_t* payload, uint8_t size, meshcore_advert_t* out_advert);
+
+/// Decode an advert payload in a single pass and, when out_signed is not NULL, return the byte ranges the signature
+/// covers so they can be hashed in place. The ranges stay valid as long as the payload buffer does.
+int meshcore_advert_decode(const uint8_t* payload, uint8_t size, meshcore_advert_t* out_advert,
+                           meshcore_advert_signed_t* out_signed);
@@ -0,0 +1,80 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#include "grp_data.h"
+#include <stdint.h>
+#include <string.h>
+#include "../packet.h"
+#include "grp_txt.h"
+
+int meshcore_grp_data_serialize(const meshcore_grp_data_t* grp_data, uint8_t* out_payload, uint8_t* out_size) {
+    return meshcore_grp_txt_serialize(grp_data, out_payload, out_size);
+}
+
+int meshcore_grp_data_deserialize(uint8_t* payload, uint8_t size, meshcore_grp_data_t* out_grp_data) {
+    return meshcore_grp_txt_deserialize(payload, size, out_grp_data);
+}
+
+int meshcore_grp_data_encode(uint32_t timestamp, uint8_t data_type, const uint8_t* data, uint8_t data_length,
+                             uint8_t* out_data, size_t capacity, uint8_t* out_size) {
+    if (out_data == NULL || out_size == NULL || (data == NULL && data_length > 0)) {
+        return -1;
+    }
+
+    if (data_length > MESHCORE_GRP_DATA_MAX_SIZE || MESHCORE_GRP_DATA_HEADER_SIZE + data_length > capacity) {
+        return -1;
+    }
+
+    uint8_t position = 0;
+
+    memcpy(&out_data[position], &timestamp, sizeof(uint32_t));
+    position += sizeof(uint32_t);
+
+    out_data[position]  = data_type;
+    position           += sizeof(uint8_t);
+
+    out_data[position]  = data_length;
+    position           += sizeof(uint8_t);
+
+    if (data_length > 0) {
+        memcpy(&out_data[position], data, data_length);
+    }
+    position += data_length;
+
+    *out_size = position;
+
+    return 0;
+}
+
+int meshcore_grp_data_decode(const uint8_t* data, uint8_t size, meshcore_grp_data_view_t* out_view) {
+    if (data == NULL || out_view == NULL) {
+        return -1;
+    }
+
+    memset(out_view, 0, sizeof(meshcore_grp_data_view_t));
+
+    if (size < MESHCORE_GRP_DATA_HEADER_SIZE) {
+        return -1;
+    }
+
+    uint8_t position = 0;
+
+    memcpy(&out_view->timestamp, &data[position], sizeof(uint32_t));
+    position += sizeof(uint32_t);
+
+    out_view->data_type  = data[position];
+    position            += sizeof(uint8_t);
+
+    out_view->data_length  = data[position];
+    position              += sizeof(uint8_t);
+
+    // Anything after the blob is padding
+    if (out_view->data_length > size - position) {
+        return -1;
+    }
+
+    out_view->data = &data[position];
+
+    return 0;
+}
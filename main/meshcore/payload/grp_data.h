@@ -0,0 +1,42 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../packet.h"
+#include "grp_txt.h"
+
+// Definitions
+
+// The envelope (channel hash, MAC, ciphertext) and its encryption are the same as for group text messages
+typedef meshcore_grp_txt_t meshcore_grp_data_t;
+
+// The blob starts with a data type and length, the length is needed because the ciphertext is padded to whole blocks
+#define MESHCORE_GRP_DATA_HEADER_SIZE (sizeof(uint32_t) + sizeof(uint8_t) + sizeof(uint8_t))
+#define MESHCORE_GRP_DATA_CIPHER_SIZE (MESHCORE_MAX_PAYLOAD_SIZE - sizeof(uint8_t) - MESHCORE_CIPHER_MAC_SIZE)
+#define MESHCORE_GRP_DATA_PADDED_SIZE (MESHCORE_GRP_DATA_CIPHER_SIZE & ~(MESHCORE_CIPHER_BLOCK_SIZE - 1))
+#define MESHCORE_GRP_DATA_MAX_SIZE    (MESHCORE_GRP_DATA_PADDED_SIZE - MESHCORE_GRP_DATA_HEADER_SIZE)  // 170 bytes
+
+// Decrypted contents, the data points into the buffer that was decoded and is only valid as long as that buffer is
+typedef struct {
+    uint32_t       timestamp;
+    uint8_t        data_type;
+    uint8_t        data_length;
+    const uint8_t* data;
+} meshcore_grp_data_view_t;
+
+// Functions
+
+int meshcore_grp_data_serialize(const meshcore_grp_data_t* grp_data, uint8_t* out_payload, uint8_t* out_size);
+int meshcore_grp_data_deserialize(uint8_t* payload, uint8_t size, meshcore_grp_data_t* out_grp_data);
+
+/// Pack the contents to be encrypted, capacity is the size of out_data
+int meshcore_grp_data_encode(uint32_t timestamp, uint8_t data_type, const uint8_t* data, uint8_t data_length,
+                             uint8_t* out_data, size_t capacity, uint8_t* out_size);
+
+/// Decode decrypted contents without copying the blob, the view refers to the data buffer
+int meshcore_grp_data_decode(const uint8_t* data, uint8_t size, meshcore_grp_data_view_t* out_view);
@@ -16,6 +16,10 @@ int meshcore_grp_txt_serialize(const meshcore_grp_txt_t* grp_txt, uint8_t* out_p
 
     memset(out_payload, 0, MESHCORE_MAX_PAYLOAD_SIZE);
 
+    if (grp_txt->data_length > member_size(meshcore_grp_txt_t, data)) {
+        return -1;
+    }
+
     uint8_t position = 0;
 
     memcpy(&out_payload[position], &grp_txt->channel_hash, sizeof(uint8_t));
@@ -39,6 +43,10 @@ int meshcore_grp_txt_deserialize(uint8_t* data, uint8_t size, meshcore_grp_txt_t
 
     memset(out_grp_txt, 0, sizeof(meshcore_grp_txt_t));
 
+    if (size < sizeof(uint8_t) + MESHCORE_CIPHER_MAC_SIZE) {
+        return -1;
+    }
+
     uint8_t position = 0;
 
     memcpy(&out_grp_txt->channel_hash, &data[position], sizeof(uint8_t));
@@ -48,6 +56,10 @@ int meshcore_grp_txt_deserialize(uint8_t* data, uint8_t size, meshcore_grp_txt_t
     position += MESHCORE_CIPHER_MAC_SIZE;
 
     out_grp_txt->data_length = size - position;
+    if (out_grp_txt->data_length > member_size(meshcore_grp_txt_t, data)) {
+        return -1;
+    }
+
     memcpy(out_grp_txt->data, &data[position], out_grp_txt->data_length);
     position += out_grp_txt->data_length;
 
@@ -55,12 +67,15 @@ int meshcore_grp_txt_deserialize(uint8_t* data, uint8_t size, meshcore_grp_txt_t
 }
 
 int meshcore_grp_txt_data_serialize(const meshcore_grp_txt_data_t* data, uint8_t* out_data, uint8_t* out_size) {
+    if (data == NULL || out_data == NULL) {
+        return -1;
+    }
     uint8_t* ptr = out_data;
     memcpy(ptr, &data->timestamp, sizeof(uint32_t));
     ptr                += sizeof(uint32_t);
     *ptr                = data->text_type;
     ptr                += sizeof(uint8_t);
-    size_t text_length  = strlen(data->text);
+    size_t text_length  = strnlen(data->text, sizeof(data->text) - 1);
     memcpy(ptr, data->text, text_length);
     ptr       += text_length;
     *ptr       = '\0';
@@ -69,8 +84,14 @@ int meshcore_grp_txt_data_serialize(const meshcore_grp_txt_data_t* data, uint8_t
 }
 
 int meshcore_grp_txt_data_deserialize(uint8_t* data, uint8_t size, meshcore_grp_txt_data_t* out_data) {
+    if (data == NULL || out_data == NULL) {
+        return -1;
+    }
     uint8_t* ptr = data;
     memset(out_data, 0, sizeof(meshcore_grp_txt_data_t));
+    if (size < sizeof(uint32_t) + sizeof(uint8_t)) {
+        return -1;
+    }
     memcpy(&out_data->timestamp, ptr, sizeof(uint32_t));
     ptr                 += sizeof(uint32_t);
     out_data->text_type  = *ptr;
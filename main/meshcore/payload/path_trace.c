@@ -0,0 +1,73 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#include "path_trace.h"
+#include <stdint.h>
+#include <string.h>
+#include "../packet.h"
+
+#define member_size(type, member) (sizeof(((type*)0)->member))
+
+int meshcore_path_trace_serialize(const meshcore_path_trace_t* trace, uint8_t* out_payload, uint8_t* out_size) {
+    if (trace == NULL || out_payload == NULL) {
+        return -1;
+    }
+
+    if (trace->hop_count > member_size(meshcore_path_trace_t, hops)) {
+        return -1;
+    }
+
+    memset(out_payload, 0, MESHCORE_MAX_PAYLOAD_SIZE);
+
+    uint8_t position = 0;
+
+    memcpy(&out_payload[position], &trace->tag, sizeof(uint32_t));
+    position += sizeof(uint32_t);
+
+    memcpy(&out_payload[position], &trace->auth_code, sizeof(uint32_t));
+    position += sizeof(uint32_t);
+
+    out_payload[position]  = trace->flags;
+    position              += sizeof(uint8_t);
+
+    memcpy(&out_payload[position], trace->hops, trace->hop_count);
+    position += trace->hop_count;
+
+    *out_size = position;
+
+    return 0;
+}
+
+int meshcore_path_trace_deserialize(uint8_t* payload, uint8_t size, meshcore_path_trace_t* out_trace) {
+    if (payload == NULL || out_trace == NULL) {
+        return -1;
+    }
+
+    memset(out_trace, 0, sizeof(meshcore_path_trace_t));
+
+    if (size < MESHCORE_PATH_TRACE_HEADER_SIZE) {
+        return -1;
+    }
+
+    uint8_t position = 0;
+
+    memcpy(&out_trace->tag, &payload[position], sizeof(uint32_t));
+    position += sizeof(uint32_t);
+
+    memcpy(&out_trace->auth_code, &payload[position], sizeof(uint32_t));
+    position += sizeof(uint32_t);
+
+    out_trace->flags  = payload[position];
+    position         += sizeof(uint8_t);
+
+    out_trace->hop_count = size - position;
+    if (out_trace->hop_count > member_size(meshcore_path_trace_t, hops)) {
+        return -1;
+    }
+
+    memcpy(out_trace->hops, &payload[position], out_trace->hop_count);
+    position += out_trace->hop_count;
+
+    return 0;
+}
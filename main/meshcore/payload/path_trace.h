@@ -0,0 +1,34 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../packet.h"
+
+// Definitions
+
+// Tag, authentication code and flags, followed by the hashes of the hops the trace is routed through
+#define MESHCORE_PATH_TRACE_HEADER_SIZE (sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint8_t))
+
+// Every hop adds its SNR to the packet path, so the path size limits the number of hops
+#define MESHCORE_PATH_TRACE_MAX_HOPS MESHCORE_MAX_PATH_SIZE
+
+// The lower two bits of the flags select the size of the hop hashes (1 << n bytes), only single bytes are supported
+#define MESHCORE_PATH_TRACE_FLAGS_HASH_SIZE 0x03
+
+typedef struct {
+    uint32_t tag;        // Chosen by the originator to match the returning trace
+    uint32_t auth_code;  // Opaque to forwarding nodes
+    uint8_t  flags;
+    uint8_t  hop_count;
+    uint8_t  hops[MESHCORE_PATH_TRACE_MAX_HOPS];
+} meshcore_path_trace_t;
+
+// Functions
+
+int meshcore_path_trace_serialize(const meshcore_path_trace_t* trace, uint8_t* out_payload, uint8_t* out_size);
+int meshcore_path_trace_deserialize(uint8_t* payload, uint8_t size, meshcore_path_trace_t* out_trace);
@@ -45,6 +45,10 @@ int meshcore_request_deserialize(uint8_t* data, uint8_t size, meshcore_request_t
 
     memset(out_request, 0, sizeof(meshcore_request_t));
 
+    if (size < sizeof(uint8_t) * 2 + MESHCORE_CIPHER_MAC_SIZE) {
+        return -1;
+    }
+
     uint8_t position = 0;
 
     out_request->destination_hash  = data[position];
@@ -0,0 +1,132 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#include "txt_msg.h"
+#include <stdint.h>
+#include <string.h>
+#include "../packet.h"
+
+#define member_size(type, member) (sizeof(((type*)0)->member))
+
+#define TXT_MSG_FLAGS_TYPE_SHIFT    2
+#define TXT_MSG_FLAGS_TYPE_MASK     0x3F  // 6-bits
+#define TXT_MSG_FLAGS_ATTEMPT_SHIFT 0
+#define TXT_MSG_FLAGS_ATTEMPT_MASK  0x03  // 2-bits
+
+int meshcore_txt_msg_serialize(const meshcore_txt_msg_t* txt_msg, uint8_t* out_payload, uint8_t* out_size) {
+    if (out_payload == NULL) {
+        return -1;
+    }
+
+    memset(out_payload, 0, MESHCORE_MAX_PAYLOAD_SIZE);
+
+    if (txt_msg->ciphertext_length > member_size(meshcore_txt_msg_t, ciphertext)) {
+        return -1;
+    }
+
+    uint8_t position = 0;
+
+    out_payload[position]  = txt_msg->destination_hash;
+    position              += sizeof(uint8_t);
+
+    out_payload[position]  = txt_msg->source_hash;
+    position              += sizeof(uint8_t);
+
+    memcpy(&out_payload[position], txt_msg->cipher_mac, MESHCORE_CIPHER_MAC_SIZE);
+    position += MESHCORE_CIPHER_MAC_SIZE;
+
+    memcpy(&out_payload[position], txt_msg->ciphertext, txt_msg->ciphertext_length);
+    position += txt_msg->ciphertext_length;
+
+    *out_size = position;
+
+    return 0;
+}
+
+int meshcore_txt_msg_deserialize(uint8_t* data, uint8_t size, meshcore_txt_msg_t* out_txt_msg) {
+    if (out_txt_msg == NULL || data == NULL) {
+        return -1;
+    }
+
+    memset(out_txt_msg, 0, sizeof(meshcore_txt_msg_t));
+
+    if (size < sizeof(uint8_t) * 2 + MESHCORE_CIPHER_MAC_SIZE) {
+        return -1;
+    }
+
+    uint8_t position = 0;
+
+    out_txt_msg->destination_hash  = data[position];
+    position                      += sizeof(uint8_t);
+
+    out_txt_msg->source_hash  = data[position];
+    position                 += sizeof(uint8_t);
+
+    memcpy(out_txt_msg->cipher_mac, &data[position], MESHCORE_CIPHER_MAC_SIZE);
+    position += MESHCORE_CIPHER_MAC_SIZE;
+
+    out_txt_msg->ciphertext_length = size - position;
+    if (out_txt_msg->ciphertext_length > member_size(meshcore_txt_msg_t, ciphertext)) {
+        return -1;
+    }
+
+    memcpy(out_txt_msg->ciphertext, &data[position], out_txt_msg->ciphertext_length);
+    position += out_txt_msg->ciphertext_length;
+
+    return 0;
+}
+
+int meshcore_txt_msg_data_serialize(const meshcore_txt_msg_data_t* data, uint8_t* out_data, uint8_t* out_size) {
+    if (data == NULL || out_data == NULL) {
+        return -1;
+    }
+
+    uint8_t position = 0;
+
+    memcpy(&out_data[position], &data->timestamp, sizeof(uint32_t));
+    position += sizeof(uint32_t);
+
+    out_data[position]  = ((data->text_type & TXT_MSG_FLAGS_TYPE_MASK) << TXT_MSG_FLAGS_TYPE_SHIFT) |
+                         ((data->attempt & TXT_MSG_FLAGS_ATTEMPT_MASK) << TXT_MSG_FLAGS_ATTEMPT_SHIFT);
+    position           += sizeof(uint8_t);
+
+    size_t text_length = strnlen(data->text, sizeof(data->text) - 1);
+    memcpy(&out_data[position], data->text, text_length);
+    position += text_length;
+
+    *out_size = position;
+
+    return 0;
+}
+
+int meshcore_txt_msg_data_deserialize(uint8_t* data, uint8_t size, meshcore_txt_msg_data_t* out_data) {
+    if (data == NULL || out_data == NULL) {
+        return -1;
+    }
+
+    memset(out_data, 0, sizeof(meshcore_txt_msg_data_t));
+
+    if (size < sizeof(uint32_t) + sizeof(uint8_t)) {
+        return -1;
+    }
+
+    uint8_t position = 0;
+
+    memcpy(&out_data->timestamp, &data[position], sizeof(uint32_t));
+    position += sizeof(uint32_t);
+
+    uint8_t flags        = data[position];
+    out_data->text_type  = (flags >> TXT_MSG_FLAGS_TYPE_SHIFT) & TXT_MSG_FLAGS_TYPE_MASK;
+    out_data->attempt    = (flags >> TXT_MSG_FLAGS_ATTEMPT_SHIFT) & TXT_MSG_FLAGS_ATTEMPT_MASK;
+    position            += sizeof(uint8_t);
+
+    // The plaintext is zero padded up to the cipher block size, the text ends at the first null byte
+    size_t text_length = strnlen((const char*)&data[position], size - position);
+    if (text_length >= sizeof(out_data->text)) {
+        text_length = sizeof(out_data->text) - 1;
+    }
+    memcpy(out_data->text, &data[position], text_length);
+
+    return 0;
+}
@@ -0,0 +1,40 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../packet.h"
+
+// Definitions
+
+#define MESHCORE_TXT_TYPE_PLAIN       0x00
+#define MESHCORE_TXT_TYPE_CLI_DATA    0x01
+#define MESHCORE_TXT_TYPE_SIGNED_TEXT 0x02
+
+typedef struct {
+    uint8_t destination_hash;
+    uint8_t source_hash;
+    uint8_t cipher_mac[MESHCORE_CIPHER_MAC_SIZE];
+    uint8_t ciphertext_length;
+    uint8_t ciphertext[MESHCORE_MAX_PAYLOAD_SIZE - MESHCORE_CIPHER_MAC_SIZE - sizeof(uint8_t) * 2];
+} meshcore_txt_msg_t;
+
+typedef struct {
+    uint32_t timestamp;
+    uint8_t  text_type;  // Upper 6 bits of the flags byte
+    uint8_t  attempt;    // Lower 2 bits of the flags byte
+    char     text[MESHCORE_MAX_PAYLOAD_SIZE - MESHCORE_CIPHER_MAC_SIZE - sizeof(uint8_t) * 2 - sizeof(uint32_t) -
+              sizeof(uint8_t)];
+} meshcore_txt_msg_data_t;
+
+// Functions
+
+int meshcore_txt_msg_serialize(const meshcore_txt_msg_t* txt_msg, uint8_t* out_payload, uint8_t* out_size);
+int meshcore_txt_msg_deserialize(uint8_t* payload, uint8_t size, meshcore_txt_msg_t* out_txt_msg);
+
+int meshcore_txt_msg_data_serialize(const meshcore_txt_msg_data_t* data, uint8_t* out_data, uint8_t* out_size);
+int meshcore_txt_msg_data_deserialize(uint8_t* data, uint8_t size, meshcore_txt_msg_data_t* out_data);
@@ -0,0 +1,113 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#include "self_advert.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "ed25519/ed_25519.h"
+#include "packet.h"
+#include "payload/advert.h"
+
+static int64_t jitter(int64_t interval, uint32_t random) {
+    return random % (interval / MESHCORE_SELF_ADVERT_JITTER_DIVIDER);
+}
+
+void meshcore_self_advert_init(meshcore_self_advert_t* self_advert, const uint8_t* pub_key, const uint8_t* prv_key,
+                               meshcore_device_role_t role, int64_t now, uint32_t random) {
+    memset(self_advert, 0, sizeof(meshcore_self_advert_t));
+    self_advert->pub_key = pub_key;
+    self_advert->prv_key = prv_key;
+    self_advert->role    = role;
+
+    // Announce ourselves to the whole mesh soon after start, neighbours are covered by the flood
+    self_advert->next_flood     = now + MESHCORE_SELF_ADVERT_FIRST_DELAY;
+    self_advert->next_flood    += jitter(MESHCORE_SELF_ADVERT_FIRST_DELAY, random);
+    self_advert->next_zero_hop  = self_advert->next_flood + MESHCORE_SELF_ADVERT_ZERO_HOP_INTERVAL;
+}
+
+void meshcore_self_advert_set_name(meshcore_self_advert_t* self_advert, const char* name) {
+    if (strncmp(self_advert->name, name, MESHCORE_MAX_NAME_SIZE) == 0) {
+        return;
+    }
+    strncpy(self_advert->name, name, MESHCORE_MAX_NAME_SIZE);
+    self_advert->name[MESHCORE_MAX_NAME_SIZE] = '\0';
+}
+
+void meshcore_self_advert_set_position(meshcore_self_advert_t* self_advert, bool valid, int32_t lat, int32_t lon) {
+    if (self_advert->position_valid == valid && self_advert->position_lat == lat && self_advert->position_lon == lon) {
+        return;
+    }
+    self_advert->position_valid = valid;
+    self_advert->position_lat   = lat;
+    self_advert->position_lon   = lon;
+}
+
+int64_t meshcore_self_advert_due(const meshcore_self_advert_t* self_advert, int64_t now,
+                                 meshcore_route_type_t* out_route) {
+    int64_t next = self_advert->next_zero_hop;
+    *out_route   = MESHCORE_ROUTE_TYPE_DIRECT;
+    if (self_advert->next_flood <= next) {
+        next       = self_advert->next_flood;
+        *out_route = MESHCORE_ROUTE_TYPE_FLOOD;
+    }
+    return next > now ? next - now : 0;
+}
+
+static int sign_payload(meshcore_self_advert_t* self_advert, uint32_t timestamp) {
+    meshcore_advert_t advert = {0};
+    memcpy(advert.pub_key, self_advert->pub_key, MESHCORE_PUB_KEY_SIZE);
+    advert.timestamp      = timestamp;
+    advert.role           = self_advert->role;
+    advert.position_valid = self_advert->position_valid;
+    advert.position_lat   = self_advert->position_lat;
+    advert.position_lon   = self_advert->position_lon;
+    advert.name_valid     = self_advert->name[0] != '\0';
+    memcpy(advert.name, self_advert->name, sizeof(advert.name));
+
+    if (meshcore_advert_serialize(&advert, self_advert->payload, &self_advert->payload_length) < 0) {
+        return -1;
+    }
+
+    // The signature covers the public key, the timestamp and the app data that follows the signature
+    uint8_t signed_data[MESHCORE_MAX_PAYLOAD_SIZE];
+    size_t  header_length   = MESHCORE_PUB_KEY_SIZE + sizeof(uint32_t);
+    size_t  app_data_offset = header_length + MESHCORE_SIGNATURE_SIZE;
+    size_t  app_data_length = self_advert->payload_length - app_data_offset;
+    memcpy(signed_data, self_advert->payload, header_length);
+    memcpy(&signed_data[header_length], &self_advert->payload[app_data_offset], app_data_length);
+
+    ed25519_sign(&self_advert->payload[header_length], signed_data, header_length + app_data_length,
+                 self_advert->pub_key, self_advert->prv_key);
+
+    self_advert->signed_timestamp = timestamp;
+    return 0;
+}
+
+int meshcore_self_advert_build(meshcore_self_advert_t* self_advert, meshcore_route_type_t route, uint32_t timestamp,
+                               int64_t now, uint32_t random, meshcore_message_t* out_message) {
+    if (self_advert->sent > 0 && timestamp <= self_advert->signed_timestamp) {
+        timestamp = self_advert->signed_timestamp + 1;
+    }
+    if (sign_payload(self_advert, timestamp) < 0) {
+        return -1;
+    }
+
+    memset(out_message, 0, sizeof(meshcore_message_t));
+    out_message->type           = MESHCORE_PAYLOAD_TYPE_ADVERT;
+    out_message->route          = route;
+    out_message->version        = 0x00;
+    out_message->path_length    = 0;  // Direct with an empty path only reaches the neighbours
+    out_message->payload_length = self_advert->payload_length;
+    memcpy(out_message->payload, self_advert->payload, self_advert->payload_length);
+
+    if (route == MESHCORE_ROUTE_TYPE_FLOOD) {
+        self_advert->next_flood = now + MESHCORE_SELF_ADVERT_FLOOD_INTERVAL +
+                                  jitter(MESHCORE_SELF_ADVERT_FLOOD_INTERVAL, random);
+    }
+    self_advert->next_zero_hop = now + MESHCORE_SELF_ADVERT_ZERO_HOP_INTERVAL +
+                                 jitter(MESHCORE_SELF_ADVERT_ZERO_HOP_INTERVAL, random);
+    self_advert->sent++;
+    return 0;
+}
@@ -0,0 +1,62 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "packet.h"
+#include "payload/advert.h"
+
+// Definitions
+
+#define MESHCORE_SELF_ADVERT_ZERO_HOP_INTERVAL (15 * 60 * 1000)    // Milliseconds between adverts to neighbours
+#define MESHCORE_SELF_ADVERT_FLOOD_INTERVAL    (12 * 3600 * 1000)  // Milliseconds between adverts to the whole mesh
+#define MESHCORE_SELF_ADVERT_FIRST_DELAY       (5 * 1000)          // Milliseconds before the first advert after start
+#define MESHCORE_SELF_ADVERT_JITTER_DIVIDER    8                   // Random delay of up to an eighth of the interval
+
+typedef struct {
+    // Identity, owned by the caller
+    const uint8_t*         pub_key;
+    const uint8_t*         prv_key;
+    meshcore_device_role_t role;
+
+    // Announced data, picked up by the next advert
+    char    name[MESHCORE_MAX_NAME_SIZE + sizeof('\0')];
+    bool    position_valid;
+    int32_t position_lat;
+    int32_t position_lon;
+
+    // Payload of the last advert, receivers drop adverts whose timestamp is not newer than the one they have
+    uint8_t  payload[MESHCORE_MAX_PAYLOAD_SIZE];
+    uint8_t  payload_length;
+    uint32_t signed_timestamp;
+
+    // Schedule, in milliseconds on the caller's monotonic clock
+    int64_t next_zero_hop;
+    int64_t next_flood;
+
+    uint32_t sent;  // Adverts built for transmission
+} meshcore_self_advert_t;
+
+// Functions
+
+/// Initialize the self advertisement for an identity and schedule the first advert, a flood, shortly after now
+void meshcore_self_advert_init(meshcore_self_advert_t* self_advert, const uint8_t* pub_key, const uint8_t* prv_key,
+                               meshcore_device_role_t role, int64_t now, uint32_t random);
+
+void meshcore_self_advert_set_name(meshcore_self_advert_t* self_advert, const char* name);
+void meshcore_self_advert_set_position(meshcore_self_advert_t* self_advert, bool valid, int32_t lat, int32_t lon);
+
+/// Get the milliseconds until the next advert is due, 0 when one is due now. The route it should be sent with is
+/// returned in out_route: flood when a flood advert is due, direct with an empty path for a zero-hop advert.
+int64_t meshcore_self_advert_due(const meshcore_self_advert_t* self_advert, int64_t now,
+                                 meshcore_route_type_t* out_route);
+
+/// Build an advert message for the route. Every advert is signed with a timestamp newer than the previous one, even
+/// when the clock stood still or went back, otherwise receivers and repeaters take it for a replay. The next advert on
+/// that route is scheduled with a random jitter, a flood also postpones the next zero-hop advert.
+int meshcore_self_advert_build(meshcore_self_advert_t* self_advert, meshcore_route_type_t route, uint32_t timestamp,
+                               int64_t now, uint32_t random, meshcore_message_t* out_message);
@@ -0,0 +1,202 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#include "trace.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+
+// Definitions
+
+#define TRACE_TASK_STACK        3072
+#define TRACE_TASK_PRIORITY     1  // Just above idle, tracing never delays the packet path
+#define TRACE_DRAIN_INTERVAL_MS 50
+
+// Record header in the ring, followed by the arguments and the data
+typedef struct {
+    const char* format;
+    uint8_t     level;
+    uint8_t     subsystem;
+    uint8_t     arg_count;
+    uint8_t     data_length;
+    uint8_t     is_string;
+} trace_record_t;
+
+volatile uint8_t meshcore_trace_runtime_mask = MESHCORE_TRACE_ALL;
+
+static uint8_t                ring[MESHCORE_TRACE_RING_SIZE];
+static size_t                 ring_head = 0;  // Total bytes written
+static size_t                 ring_tail = 0;  // Total bytes drained
+static meshcore_trace_stats_t stats     = {0};
+
+#ifdef ESP_PLATFORM
+static portMUX_TYPE ring_lock = portMUX_INITIALIZER_UNLOCKED;
+#define RING_LOCK()   taskENTER_CRITICAL(&ring_lock)
+#define RING_UNLOCK() taskEXIT_CRITICAL(&ring_lock)
+#else
+#define RING_LOCK()
+#define RING_UNLOCK()
+#endif
+
+// Functions
+
+static void ring_copy_in(size_t position, const void* data, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    size_t offset = position % MESHCORE_TRACE_RING_SIZE;
+    size_t first  = length < MESHCORE_TRACE_RING_SIZE - offset ? length : MESHCORE_TRACE_RING_SIZE - offset;
+    memcpy(&ring[offset], data, first);
+    memcpy(ring, (const uint8_t*)data + first, length - first);
+}
+
+static void ring_copy_out(size_t position, void* out_data, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    size_t offset = position % MESHCORE_TRACE_RING_SIZE;
+    size_t first  = length < MESHCORE_TRACE_RING_SIZE - offset ? length : MESHCORE_TRACE_RING_SIZE - offset;
+    memcpy(out_data, &ring[offset], first);
+    memcpy((uint8_t*)out_data + first, ring, length - first);
+}
+
+static const char* level_letter(uint8_t level) {
+    switch (level) {
+        case MESHCORE_TRACE_LEVEL_ERROR:
+            return "E";
+        case MESHCORE_TRACE_LEVEL_WARN:
+            return "W";
+        case MESHCORE_TRACE_LEVEL_INFO:
+            return "I";
+        case MESHCORE_TRACE_LEVEL_DEBUG:
+            return "D";
+        default:
+            return "V";
+    }
+}
+
+static const char* subsystem_name(uint8_t subsystem) {
+    switch (subsystem) {
+        case MESHCORE_TRACE_PACKET:
+            return "packet";
+        case MESHCORE_TRACE_ADVERT:
+            return "advert";
+        case MESHCORE_TRACE_GROUP:
+            return "group";
+        case MESHCORE_TRACE_DIRECT:
+            return "direct";
+        case MESHCORE_TRACE_CRYPTO:
+            return "crypto";
+        case MESHCORE_TRACE_ROUTE:
+            return "route";
+        default:
+            return "meshcore";
+    }
+}
+
+void meshcore_trace_write(uint8_t level, uint8_t subsystem, const char* format, const uint32_t* args, size_t arg_count,
+                          const void* data, size_t data_length, bool is_string) {
+    if (arg_count > MESHCORE_TRACE_MAX_ARGS) {
+        arg_count = MESHCORE_TRACE_MAX_ARGS;
+    }
+    if (data_length > MESHCORE_TRACE_MAX_DATA) {
+        data_length = MESHCORE_TRACE_MAX_DATA;
+    }
+
+    trace_record_t record = {
+        .format      = format,
+        .level       = level,
+        .subsystem   = subsystem,
+        .arg_count   = arg_count,
+        .data_length = data_length,
+        .is_string   = is_string,
+    };
+    size_t size = sizeof(record) + arg_count * sizeof(uint32_t) + data_length;
+
+    RING_LOCK();
+    if (ring_head - ring_tail + size > MESHCORE_TRACE_RING_SIZE) {
+        stats.dropped++;
+        RING_UNLOCK();
+        return;
+    }
+    ring_copy_in(ring_head, &record, sizeof(record));
+    ring_copy_in(ring_head + sizeof(record), args, arg_count * sizeof(uint32_t));
+    ring_copy_in(ring_head + sizeof(record) + arg_count * sizeof(uint32_t), data, data_length);
+    ring_head += size;
+    stats.written++;
+    RING_UNLOCK();
+}
+
+static void print_record(const trace_record_t* record, const uint32_t* args, const uint8_t* data) {
+    printf("%s (mc:%s) ", level_letter(record->level), subsystem_name(record->subsystem));
+    if (record->is_string) {
+        char string[MESHCORE_TRACE_MAX_DATA + 1];
+        memcpy(string, data, record->data_length);
+        string[record->data_length] = '\0';
+        printf(record->format, string);
+    } else if (record->data_length > 0 || record->arg_count == 0) {
+        printf("%s", record->format);
+        for (size_t i = 0; i < record->data_length; i++) {
+            printf("%02X", data[i]);
+        }
+    } else {
+        printf(record->format, args[0], args[1], args[2], args[3]);
+    }
+    printf("\n");
+}
+
+size_t meshcore_trace_drain(void) {
+    size_t printed = 0;
+    while (1) {
+        trace_record_t record;
+        uint32_t       args[MESHCORE_TRACE_MAX_ARGS] = {0};
+        uint8_t        data[MESHCORE_TRACE_MAX_DATA];
+
+        RING_LOCK();
+        if (ring_tail == ring_head) {
+            RING_UNLOCK();
+            break;
+        }
+        ring_copy_out(ring_tail, &record, sizeof(record));
+        ring_copy_out(ring_tail + sizeof(record), args, record.arg_count * sizeof(uint32_t));
+        ring_copy_out(ring_tail + sizeof(record) + record.arg_count * sizeof(uint32_t), data, record.data_length);
+        ring_tail += sizeof(record) + record.arg_count * sizeof(uint32_t) + record.data_length;
+        RING_UNLOCK();
+
+        // Formatting and output happen outside of the lock
+        print_record(&record, args, data);
+        printed++;
+    }
+    return printed;
+}
+
+#ifdef ESP_PLATFORM
+static void trace_task(void* arg) {
+    while (1) {
+        meshcore_trace_drain();
+        vTaskDelay(pdMS_TO_TICKS(TRACE_DRAIN_INTERVAL_MS));
+    }
+}
+#endif
+
+int meshcore_trace_start(void) {
+#ifdef ESP_PLATFORM
+    if (xTaskCreate(trace_task, "trace", TRACE_TASK_STACK, NULL, TRACE_TASK_PRIORITY, NULL) != pdPASS) {
+        return -1;
+    }
+#endif
+    return 0;
+}
+
+void meshcore_trace_get_stats(meshcore_trace_stats_t* out_stats) {
+    RING_LOCK();
+    *out_stats = stats;
+    RING_UNLOCK();
+}
@@ -0,0 +1,97 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Definitions
+
+#define MESHCORE_TRACE_LEVEL_NONE    0
+#define MESHCORE_TRACE_LEVEL_ERROR   1
+#define MESHCORE_TRACE_LEVEL_WARN    2
+#define MESHCORE_TRACE_LEVEL_INFO    3
+#define MESHCORE_TRACE_LEVEL_DEBUG   4
+#define MESHCORE_TRACE_LEVEL_VERBOSE 5
+
+#define MESHCORE_TRACE_PACKET 0x01  // Packet header, path and payload
+#define MESHCORE_TRACE_ADVERT 0x02  // Node advertisements and signature checks
+#define MESHCORE_TRACE_GROUP  0x04  // Group channel messages
+#define MESHCORE_TRACE_DIRECT 0x08  // Direct messages
+#define MESHCORE_TRACE_CRYPTO 0x10  // MAC checks and decryption
+#define MESHCORE_TRACE_ROUTE  0x20  // Flooding and forwarding
+#define MESHCORE_TRACE_ALL    0xFF
+
+// Highest level compiled in, traces above it are removed by the compiler together with their arguments
+#ifndef MESHCORE_TRACE_LEVEL
+#define MESHCORE_TRACE_LEVEL MESHCORE_TRACE_LEVEL_WARN
+#endif
+
+// Subsystems compiled in
+#ifndef MESHCORE_TRACE_MASK
+#define MESHCORE_TRACE_MASK MESHCORE_TRACE_ALL
+#endif
+
+#define MESHCORE_TRACE_RING_SIZE 4096  // Bytes of pending trace records
+#define MESHCORE_TRACE_MAX_ARGS  4
+#define MESHCORE_TRACE_MAX_DATA  64  // Bytes of a hex dump or string copied into a record, the rest is cut off
+
+typedef struct {
+    uint32_t written;  // Records added to the ring
+    uint32_t dropped;  // Records lost because the ring was full
+} meshcore_trace_stats_t;
+
+// Subsystems enabled at runtime, a subset of the compiled in mask
+extern volatile uint8_t meshcore_trace_runtime_mask;
+
+#define MESHCORE_TRACE_ENABLED(level, subsystem)                                    \
+    ((level) <= MESHCORE_TRACE_LEVEL && ((subsystem) & MESHCORE_TRACE_MASK) != 0 && \
+     ((subsystem) & meshcore_trace_runtime_mask) != 0)
+
+/// Trace a message with up to MESHCORE_TRACE_MAX_ARGS integer arguments. Only the format pointer and the arguments
+/// are stored, formatting happens later in the drain, so the format must be a string literal and the arguments are
+/// passed to it as 32-bit values (%d, %u, %x and the like).
+#define MESHCORE_TRACE(level, subsystem, format, ...)                                             \
+    do {                                                                                          \
+        if (MESHCORE_TRACE_ENABLED(level, subsystem)) {                                           \
+            const uint32_t _trace_args[] = {0, ##__VA_ARGS__};                                    \
+            _Static_assert(sizeof(_trace_args) / sizeof(uint32_t) <= MESHCORE_TRACE_MAX_ARGS + 1, \
+                           "too many trace arguments");                                           \
+            meshcore_trace_write(level, subsystem, format, &_trace_args[1],                       \
+                                 sizeof(_trace_args) / sizeof(uint32_t) - 1, NULL, 0, false);     \
+        }                                                                                         \
+    } while (0)
+
+/// Trace a hex dump of a buffer, the bytes are copied into the ring and printed after the label
+#define MESHCORE_TRACE_HEX(level, subsystem, label, data, length)                        \
+    do {                                                                                 \
+        if (MESHCORE_TRACE_ENABLED(level, subsystem)) {                                  \
+            meshcore_trace_write(level, subsystem, label, NULL, 0, data, length, false); \
+        }                                                                                \
+    } while (0)
+
+/// Trace a message with a single string argument (%s), the string is copied into the ring
+#define MESHCORE_TRACE_STR(level, subsystem, format, string)                                       \
+    do {                                                                                           \
+        if (MESHCORE_TRACE_ENABLED(level, subsystem)) {                                            \
+            meshcore_trace_write(level, subsystem, format, NULL, 0, string, strlen(string), true); \
+        }                                                                                          \
+    } while (0)
+
+// Functions
+
+/// Append a record to the trace ring, use the MESHCORE_TRACE macros instead of calling this directly
+void meshcore_trace_write(uint8_t level, uint8_t subsystem, const char* format, const uint32_t* args, size_t arg_count,
+                          const void* data, size_t data_length, bool is_string);
+
+/// Format and print all pending records, returns the number of records printed
+size_t meshcore_trace_drain(void);
+
+/// Start a low priority task that drains the ring in the background
+int meshcore_trace_start(void);
+
+void meshcore_trace_get_stats(meshcore_trace_stats_t* out_stats);
@@ -0,0 +1,122 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#include "transport.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include "cipher.h"
+#include "crypto/sha256.h"
+#include "packet.h"
+
+void meshcore_region_hashtag_key(const char* name, uint8_t* out_key) {
+    Sha256Context context;
+    SHA256_HASH   digest;
+    Sha256Initialise(&context);
+    Sha256Update(&context, name, strlen(name));
+    Sha256Finalise(&context, &digest);
+
+    memcpy(out_key, digest.bytes, MESHCORE_TRANSPORT_KEY_SIZE);
+}
+
+void meshcore_regions_init(meshcore_regions_t* regions) {
+    memset(regions, 0, sizeof(meshcore_regions_t));
+}
+
+meshcore_region_t* meshcore_regions_add(meshcore_regions_t* regions, const char* name, const uint8_t* key) {
+    if (regions == NULL || name == NULL || key == NULL) {
+        return NULL;
+    }
+
+    meshcore_region_t* region = NULL;
+    for (uint8_t i = 0; i < MESHCORE_MAX_REGIONS; i++) {
+        meshcore_region_t* candidate = &regions->regions[i];
+        if (candidate->valid && memcmp(candidate->key, key, MESHCORE_TRANSPORT_KEY_SIZE) == 0) {
+            return candidate;
+        }
+        if (!candidate->valid && region == NULL) {
+            region = candidate;
+        }
+    }
+    if (region == NULL) {
+        return NULL;
+    }
+
+    memset(region, 0, sizeof(meshcore_region_t));
+    snprintf(region->name, sizeof(region->name), "%s", name);
+    memcpy(region->key, key, MESHCORE_TRANSPORT_KEY_SIZE);
+    meshcore_hmac_key_init(&region->hmac, key, MESHCORE_TRANSPORT_KEY_SIZE);
+    region->valid = true;
+    regions->count++;
+    return region;
+}
+
+void meshcore_regions_remove(meshcore_regions_t* regions, meshcore_region_t* region) {
+    if (regions == NULL || region == NULL || !region->valid) {
+        return;
+    }
+
+    memset(region, 0, sizeof(meshcore_region_t));
+    regions->count--;
+}
+
+meshcore_region_t* meshcore_regions_find_by_name(meshcore_regions_t* regions, const char* name) {
+    if (regions == NULL || name == NULL || name[0] == '\0') {
+        return NULL;
+    }
+
+    for (uint8_t i = 0; i < MESHCORE_MAX_REGIONS; i++) {
+        if (regions->regions[i].valid && strcasecmp(regions->regions[i].name, name) == 0) {
+            return &regions->regions[i];
+        }
+    }
+
+    return NULL;
+}
+
+uint16_t meshcore_transport_code(const meshcore_region_t* region, const meshcore_message_t* message) {
+    uint8_t       type = message->type;
+    uint8_t       mac[sizeof(uint16_t)];
+    Sha256Context context;
+    meshcore_hmac_begin(&region->hmac, &context);
+    Sha256Update(&context, &type, sizeof(type));
+    Sha256Update(&context, message->payload, message->payload_length);
+    meshcore_hmac_finish(&region->hmac, &context, mac, sizeof(mac));
+
+    uint16_t code = mac[0] | (mac[1] << 8);
+    if (code == 0x0000) {
+        code = 0x0001;
+    } else if (code == 0xFFFF) {
+        code = 0xFFFE;
+    }
+    return code;
+}
+
+bool meshcore_regions_in_scope(const meshcore_regions_t* regions, const meshcore_message_t* message) {
+    if (message->route != MESHCORE_ROUTE_TYPE_TRANSPORT_FLOOD || regions->count == 0) {
+        return true;
+    }
+
+    for (uint8_t i = 0; i < MESHCORE_MAX_REGIONS; i++) {
+        const meshcore_region_t* region = &regions->regions[i];
+        if (region->valid && meshcore_transport_code(region, message) == message->transport_codes[0]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int meshcore_transport_apply(const meshcore_region_t* region, meshcore_message_t* message) {
+    if (region == NULL || message->route != MESHCORE_ROUTE_TYPE_FLOOD) {
+        return -1;
+    }
+
+    message->route              = MESHCORE_ROUTE_TYPE_TRANSPORT_FLOOD;
+    message->transport_codes[0] = meshcore_transport_code(region, message);
+    message->transport_codes[1] = 0;
+    return 0;
+}
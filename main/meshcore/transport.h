@@ -0,0 +1,66 @@
+// SPDX-FileCopyrightText: 2025 Scott Powell / rippleradios.com
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "cipher.h"
+#include "packet.h"
+
+// Definitions
+
+/*
+A region scopes flood packets to the part of the mesh that knows its key. The first transport code of a
+TRANSPORT_FLOOD packet is the HMAC-SHA256 of the payload type and payload with the region key, truncated to a little
+endian uint16. The second transport code is reserved and sent as 0. The codes 0000 and FFFF are reserved, a calculated
+code that equals one of them is changed into 0001 or FFFE.
+*/
+
+#define MESHCORE_MAX_REGIONS        8
+#define MESHCORE_REGION_NAME_SIZE   32
+#define MESHCORE_TRANSPORT_KEY_SIZE 16
+
+typedef struct {
+    bool                valid;
+    char                name[MESHCORE_REGION_NAME_SIZE + sizeof('\0')];
+    uint8_t             key[MESHCORE_TRANSPORT_KEY_SIZE];
+    meshcore_hmac_key_t hmac;  // Computed once when the region is added
+} meshcore_region_t;
+
+typedef struct {
+    meshcore_region_t regions[MESHCORE_MAX_REGIONS];
+    uint8_t           count;
+} meshcore_regions_t;
+
+// Functions
+
+/// Derive the key of a public hashtag region from its name (including the '#'), the key is the first 16 bytes of the
+/// SHA-256 of the name
+void meshcore_region_hashtag_key(const char* name, uint8_t* out_key);
+
+/// Initialize an empty region table
+void meshcore_regions_init(meshcore_regions_t* regions);
+
+/// Add a region, the HMAC state is derived here. Returns the existing region when the key was already added, NULL when
+/// the table is full.
+meshcore_region_t* meshcore_regions_add(meshcore_regions_t* regions, const char* name, const uint8_t* key);
+
+/// Remove a region, the pointer is invalid afterwards
+void meshcore_regions_remove(meshcore_regions_t* regions, meshcore_region_t* region);
+
+/// Find a region by its name, case insensitive
+meshcore_region_t* meshcore_regions_find_by_name(meshcore_regions_t* regions, const char* name);
+
+/// Calculate the transport code of a message for a region
+uint16_t meshcore_transport_code(const meshcore_region_t* region, const meshcore_message_t* message);
+
+/// Check whether a received message should be processed and repeated. Unscoped floods and direct messages always are,
+/// a scoped flood only when its transport code matches one of the regions. A node without regions accepts all.
+bool meshcore_regions_in_scope(const meshcore_regions_t* regions, const meshcore_message_t* message);
+
+/// Scope a flood message to a region by turning it into a TRANSPORT_FLOOD message. Other routes are left untouched.
+/// The payload must not change afterwards. Returns -1 when the message was not changed.
+int meshcore_transport_apply(const meshcore_region_t* region, meshcore_message_t* message);
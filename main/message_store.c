@@ -0,0 +1,369 @@
+#include "message_store.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_vfs_fat.h"
+
+#define RECORD_MAGIC          0xA5
+#define RECORD_FLAG_SENT      0x01
+#define RECORD_FLAG_REPEATED  0x02
+#define RECORD_FLAG_DIRECT    0x04
+#define INDEX_INITIAL_ENTRIES 64
+
+static const char* TAG = "message_store";
+
+// On-disk record, followed by the name and text without terminators
+typedef struct __attribute__((packed)) {
+    uint8_t  magic;
+    uint8_t  flags;
+    uint8_t  name_length;
+    uint8_t  text_length;
+    uint32_t timestamp;
+    uint32_t received_at;
+} record_header_t;
+
+typedef struct {
+    uint32_t offset;
+    uint16_t segment;
+    uint8_t  flags;
+} index_entry_t;
+
+struct message_store {
+    bool           used;
+    uint8_t        id[MESSAGE_STORE_ID_SIZE];
+    bool           direct;
+    index_entry_t* index;  // In append order
+    size_t         count;
+    size_t         read_count;  // Messages seen by the user, the rest are unread
+    size_t         capacity;
+    uint16_t       segment;  // Segment currently being appended to
+    uint32_t       segment_size;
+};
+
+static message_store_t stores[MESSAGE_STORE_MAX_STORES] = {0};
+static wl_handle_t     wl_handle                        = WL_INVALID_HANDLE;
+static bool            mounted                          = false;
+
+static void format_id(const message_store_t* store, char* out_hex) {
+    for (size_t i = 0; i < MESSAGE_STORE_ID_SIZE; i++) {
+        sprintf(&out_hex[i * 2], "%02X", store->id[i]);
+    }
+}
+
+static void segment_path(message_store_t* store, uint16_t segment, char* out_path, size_t max_length) {
+    char id[MESSAGE_STORE_ID_SIZE * 2 + 1];
+    format_id(store, id);
+    snprintf(out_path, max_length, "%s/%c%s_%04u.log", MESSAGE_STORE_BASE_PATH, store->direct ? 'd' : 'c', id,
+             segment);
+}
+
+static bool index_grow(message_store_t* store) {
+    size_t         capacity = store->capacity ? store->capacity * 2 : INDEX_INITIAL_ENTRIES;
+    index_entry_t* index    = heap_caps_realloc(store->index, capacity * sizeof(index_entry_t), MALLOC_CAP_SPIRAM);
+    if (index == NULL) {
+        index = realloc(store->index, capacity * sizeof(index_entry_t));
+    }
+    if (index == NULL) {
+        return false;
+    }
+    store->index    = index;
+    store->capacity = capacity;
+    return true;
+}
+
+static bool index_add(message_store_t* store, const record_header_t* header, uint16_t segment, uint32_t offset) {
+    if (store->count >= store->capacity && !index_grow(store)) {
+        return false;
+    }
+    index_entry_t* entry = &store->index[store->count++];
+    entry->offset        = offset;
+    entry->segment       = segment;
+    entry->flags         = header->flags;
+    return true;
+}
+
+// Segments can be damaged or foreign, the lengths must leave room for the terminators of chat_message_t
+static bool record_valid(const record_header_t* header) {
+    return header->magic == RECORD_MAGIC && header->name_length < CHAT_MESSAGE_NAME_SIZE &&
+           header->text_length < CHAT_MESSAGE_TEXT_SIZE;
+}
+
+static FILE* open_segment(message_store_t* store, uint16_t segment, const char* mode) {
+    char path[64];
+    segment_path(store, segment, path, sizeof(path));
+    return fopen(path, mode);
+}
+
+// Scan all segments of a store to rebuild the in-RAM index
+static void index_rebuild(message_store_t* store) {
+    uint16_t segment = 0;
+    while (1) {
+        FILE* file = open_segment(store, segment, "rb");
+        if (file == NULL) {
+            break;
+        }
+
+        // Seeking past the end succeeds, so records are checked against the file size instead
+        long file_size = -1;
+        if (fseek(file, 0, SEEK_END) == 0) {
+            file_size = ftell(file);
+        }
+        rewind(file);
+
+        uint32_t        offset = 0;
+        bool            intact = file_size >= 0;
+        record_header_t header;
+        while (intact && fread(&header, sizeof(header), 1, file) == 1) {
+            uint32_t length = sizeof(header) + header.name_length + header.text_length;
+            if (!record_valid(&header) || offset + length > (uint32_t)file_size) {
+                // A corrupt record or one cut short by power loss during an append
+                intact = false;
+                break;
+            }
+            if (fseek(file, header.name_length + header.text_length, SEEK_CUR) != 0) {
+                intact = false;
+                break;
+            }
+            if (!index_add(store, &header, segment, offset)) {
+                ESP_LOGE(TAG, "Out of memory while indexing %02X", store->id[0]);
+                intact = false;
+                break;
+            }
+            offset += length;
+        }
+        if (intact && offset != (uint32_t)file_size) {
+            // A partial record header at the end of the segment
+            intact = false;
+        }
+        fclose(file);
+
+        store->segment      = segment;
+        store->segment_size = offset;
+        if (!intact) {
+            // Never append behind a damaged record, continue in a fresh segment instead. Later segments are still
+            // scanned, the damaged one may have been left behind by an earlier boot.
+            store->segment++;
+            store->segment_size = 0;
+        }
+        segment++;
+    }
+}
+
+static FILE* open_append_file(message_store_t* store) {
+    FILE* file = open_segment(store, store->segment, "r+b");
+    if (file == NULL) {
+        file = open_segment(store, store->segment, "w+b");
+    }
+    return file;
+}
+
+esp_err_t message_store_init(void) {
+    // The partition is shared with the launcher and other apps, never format it from here
+    const esp_vfs_fat_mount_config_t mount_config = {
+        .format_if_mount_failed = false,
+        .max_files              = 4,
+        .allocation_unit_size   = 4096,
+    };
+    esp_err_t res = esp_vfs_fat_spiflash_mount_rw_wl(MESSAGE_STORE_MOUNT_POINT, MESSAGE_STORE_PARTITION,
+                                                     &mount_config, &wl_handle);
+    if (res != ESP_OK && res != ESP_ERR_INVALID_STATE) {  // Already mounted is fine
+        ESP_LOGE(TAG, "Failed to mount %s, messages will not be stored: %s", MESSAGE_STORE_PARTITION,
+                 esp_err_to_name(res));
+        return res;
+    }
+    mounted = true;
+    mkdir(MESSAGE_STORE_BASE_PATH, 0775);
+    return ESP_OK;
+}
+
+message_store_t* message_store_open(const uint8_t* id, bool direct) {
+    message_store_t* free_store = NULL;
+    for (size_t i = 0; i < MESSAGE_STORE_MAX_STORES; i++) {
+        message_store_t* store = &stores[i];
+        if (store->used && store->direct == direct && memcmp(store->id, id, MESSAGE_STORE_ID_SIZE) == 0) {
+            return store;
+        }
+        if (!store->used && free_store == NULL) {
+            free_store = store;
+        }
+    }
+
+    if (free_store == NULL) {
+        ESP_LOGE(TAG, "Too many open message stores");
+        return NULL;
+    }
+
+    message_store_t* store = free_store;
+    memset(store, 0, sizeof(message_store_t));
+    store->used   = true;
+    store->direct = direct;
+    memcpy(store->id, id, MESSAGE_STORE_ID_SIZE);
+    if (mounted) {
+        index_rebuild(store);
+    }
+    store->read_count = store->count;
+
+    char hex[MESSAGE_STORE_ID_SIZE * 2 + 1];
+    format_id(store, hex);
+    ESP_LOGI(TAG, "Opened store %c%s with %u messages", direct ? 'd' : 'c', hex, (unsigned int)store->count);
+    return store;
+}
+
+esp_err_t message_store_append(message_store_t* store, const chat_message_t* message) {
+    if (store == NULL || message == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!mounted) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    record_header_t header = {
+        .magic       = RECORD_MAGIC,
+        .flags       = (message->sent ? RECORD_FLAG_SENT : 0) | (message->repeated ? RECORD_FLAG_REPEATED : 0) |
+                 (message->direct ? RECORD_FLAG_DIRECT : 0),
+        .name_length = strnlen(message->name, CHAT_MESSAGE_NAME_SIZE - 1),
+        .text_length = strnlen(message->text, CHAT_MESSAGE_TEXT_SIZE - 1),
+        .timestamp   = message->timestamp,
+        .received_at = message->received_at,
+    };
+    uint32_t length = sizeof(header) + header.name_length + header.text_length;
+
+    if (store->segment_size > 0 && store->segment_size + length > MESSAGE_STORE_SEGMENT_SIZE) {
+        store->segment++;
+        store->segment_size = 0;
+    }
+
+    if (store->count >= store->capacity && !index_grow(store)) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // The segment is closed again after every append, the mount only has a few file handles for all stores
+    FILE* file = open_append_file(store);
+    if (file == NULL) {
+        return ESP_FAIL;
+    }
+    bool written = fseek(file, store->segment_size, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(message->name, 1, header.name_length, file) == header.name_length &&
+                   fwrite(message->text, 1, header.text_length, file) == header.text_length;
+    if (fclose(file) != 0 || !written) {
+        return ESP_FAIL;
+    }
+
+    index_add(store, &header, store->segment, store->segment_size);
+    store->segment_size += length;
+    return ESP_OK;
+}
+
+esp_err_t message_store_set_repeated(message_store_t* store, size_t index) {
+    if (store == NULL || index >= store->count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    index_entry_t* entry  = &store->index[index];
+    entry->flags         |= RECORD_FLAG_REPEATED;
+
+    FILE* file = open_segment(store, entry->segment, "r+b");
+    if (file == NULL) {
+        return ESP_FAIL;
+    }
+    fseek(file, entry->offset + offsetof(record_header_t, flags), SEEK_SET);
+    fputc(entry->flags, file);
+    fclose(file);
+    return ESP_OK;
+}
+
+size_t message_store_count(message_store_t* store) {
+    return store ? store->count : 0;
+}
+
+size_t message_store_read(message_store_t* store, size_t index, chat_message_t* out_messages, size_t count) {
+    if (store == NULL || out_messages == NULL) {
+        return 0;
+    }
+
+    FILE*    file         = NULL;
+    uint16_t file_segment = 0;
+    size_t   read         = 0;
+
+    for (; read < count && index + read < store->count; read++) {
+        index_entry_t* entry = &store->index[index + read];
+
+        if (file == NULL || file_segment != entry->segment) {
+            if (file != NULL) {
+                fclose(file);
+            }
+            file         = open_segment(store, entry->segment, "rb");
+            file_segment = entry->segment;
+            if (file == NULL) {
+                break;
+            }
+        }
+
+        record_header_t header;
+        if (fseek(file, entry->offset, SEEK_SET) != 0 || fread(&header, sizeof(header), 1, file) != 1 ||
+            !record_valid(&header)) {
+            break;
+        }
+
+        chat_message_t* message = &out_messages[read];
+        memset(message, 0, sizeof(chat_message_t));
+        if (fread(message->name, 1, header.name_length, file) != header.name_length ||
+            fread(message->text, 1, header.text_length, file) != header.text_length) {
+            break;
+        }
+        message->channel_hash = store->id[0];
+        message->received_at  = header.received_at;
+        message->timestamp    = header.timestamp;
+        message->sent         = entry->flags & RECORD_FLAG_SENT;
+        message->repeated     = entry->flags & RECORD_FLAG_REPEATED;
+        message->direct       = entry->flags & RECORD_FLAG_DIRECT;
+    }
+
+    if (file != NULL) {
+        fclose(file);
+    }
+    return read;
+}
+
+size_t message_store_get_unread(message_store_t* store) {
+    return store ? store->count - store->read_count : 0;
+}
+
+void message_store_mark_read(message_store_t* store) {
+    if (store != NULL) {
+        store->read_count = store->count;
+    }
+}
+
+void message_store_close(message_store_t* store) {
+    if (store == NULL || !store->used) {
+        return;
+    }
+    free(store->index);
+    memset(store, 0, sizeof(message_store_t));
+}
+
+message_store_t* message_store_next(message_store_t* store) {
+    size_t start = store ? (size_t)(store - stores) + 1 : 0;
+    for (size_t i = 0; i < MESSAGE_STORE_MAX_STORES; i++) {
+        message_store_t* candidate = &stores[(start + i) % MESSAGE_STORE_MAX_STORES];
+        if (candidate->used) {
+            return candidate;
+        }
+    }
+    return NULL;
+}
+
+const uint8_t* message_store_get_id(message_store_t* store) {
+    return store->id;
+}
+
+bool message_store_is_direct(message_store_t* store) {
+    return store->direct;
+}
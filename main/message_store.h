@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#define MESSAGE_STORE_MOUNT_POINT  "/int"
+#define MESSAGE_STORE_PARTITION    "locfd"
+#define MESSAGE_STORE_BASE_PATH    MESSAGE_STORE_MOUNT_POINT "/meshcore"
+#define MESSAGE_STORE_SEGMENT_SIZE (64 * 1024)  // Bytes per append-only segment file
+#define MESSAGE_STORE_MAX_STORES   16           // Channels and direct conversations kept open
+#define MESSAGE_STORE_ID_SIZE      8            // Channel id or public key prefix of the contact
+
+#define CHAT_MESSAGE_NAME_SIZE 40
+#define CHAT_MESSAGE_TEXT_SIZE 200
+
+typedef struct {
+    uint8_t  channel_hash;
+    char     name[CHAT_MESSAGE_NAME_SIZE];  // sender name (UTF-8)
+    char     text[CHAT_MESSAGE_TEXT_SIZE];  // Message text (UTF-8)
+    uint32_t received_at;                   // Unix timestamp (local clock)
+    uint32_t timestamp;                     // Unix timestamp (remote clock)
+    bool     sent;                          // Sent by us
+    bool     repeated;                      // Repeated by others
+    bool     direct;                        // Direct message, channel hash is the contact hash
+} chat_message_t;
+
+typedef struct message_store message_store_t;
+
+// Mount the storage partition and prepare the message directory
+esp_err_t message_store_init(void);
+
+// Open (or create) the store of a channel or direct conversation, the index is rebuilt from disk on first open. The id
+// is the channel id or the start of the contact's public key, the first MESSAGE_STORE_ID_SIZE bytes are used.
+message_store_t* message_store_open(const uint8_t* id, bool direct);
+
+// Append a message, constant time apart from the occasional index growth or segment roll-over
+esp_err_t message_store_append(message_store_t* store, const chat_message_t* message);
+
+// Mark a stored message as repeated by others
+esp_err_t message_store_set_repeated(message_store_t* store, size_t index);
+
+// Number of messages in the store
+size_t message_store_count(message_store_t* store);
+
+// Read up to count messages starting at index (oldest first), returns the number of messages read
+size_t message_store_read(message_store_t* store, size_t index, chat_message_t* out_messages, size_t count);
+
+// Messages appended since the store was last marked as read, messages already on disk when it was opened count as read
+size_t message_store_get_unread(message_store_t* store);
+void   message_store_mark_read(message_store_t* store);
+
+// Close a store and release its index, the messages stay on disk
+void message_store_close(message_store_t* store);
+
+// Next open store after the given one (wraps around), the first open store when NULL is passed
+message_store_t* message_store_next(message_store_t* store);
+
+// Identification of a store, the id is MESSAGE_STORE_ID_SIZE bytes
+const uint8_t* message_store_get_id(message_store_t* store);
+bool           message_store_is_direct(message_store_t* store);
@@ -0,0 +1,192 @@
+#include "multipart_manager.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "meshcore/multipart.h"
+#include "meshcore/packet.h"
+#include "meshcore/trace.h"
+#include "packet_pool.h"
+#include "perf_counters.h"
+
+static const char* TAG = "multipart";
+
+typedef struct {
+    multipart_handler_t handler;  // NULL for an unused entry
+    uint8_t             type;
+    void*               context;
+} handler_entry_t;
+
+// The mutex guards the fragmentation state and the handlers, the reassembled payload is only used by the meshcore task
+static meshcore_multipart_t multipart                                = {0};
+static SemaphoreHandle_t    mutex                                    = NULL;
+static multipart_transmit_t transmit_function                        = NULL;
+static handler_entry_t      handlers[MULTIPART_MANAGER_MAX_HANDLERS] = {0};
+static uint8_t              reassembled[MESHCORE_MULTIPART_MAX_SIZE] = {0};
+
+static int64_t now_ms(void) {
+    return esp_timer_get_time() / 1000;
+}
+
+// Only payloads with a handler are reassembled, the caller holds the mutex
+static void update_types(void) {
+    uint16_t types = 0;
+    for (size_t i = 0; i < MULTIPART_MANAGER_MAX_HANDLERS; i++) {
+        if (handlers[i].handler != NULL) {
+            types |= 1U << (handlers[i].type & 0x0F);
+        }
+    }
+    meshcore_multipart_set_types(&multipart, types);
+}
+
+esp_err_t multipart_manager_init(uint8_t own_hash, multipart_transmit_t transmit) {
+    mutex = xSemaphoreCreateMutex();
+    if (mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    meshcore_multipart_init(&multipart, own_hash, esp_random());
+    update_types();
+    transmit_function = transmit;
+    return ESP_OK;
+}
+
+esp_err_t multipart_manager_register(uint8_t type, multipart_handler_t handler, void* context) {
+    if (handler == NULL || mutex == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t res = ESP_ERR_NO_MEM;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (size_t i = 0; i < MULTIPART_MANAGER_MAX_HANDLERS; i++) {
+        if (handlers[i].handler == NULL) {
+            handlers[i].handler = handler;
+            handlers[i].type    = type;
+            handlers[i].context = context;
+            res                 = ESP_OK;
+            break;
+        }
+    }
+    update_types();
+    xSemaphoreGive(mutex);
+    return res;
+}
+
+void multipart_manager_unregister(uint8_t type, multipart_handler_t handler) {
+    if (mutex == NULL) {
+        return;
+    }
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (size_t i = 0; i < MULTIPART_MANAGER_MAX_HANDLERS; i++) {
+        if (handlers[i].handler == handler && handlers[i].type == type) {
+            memset(&handlers[i], 0, sizeof(handler_entry_t));
+        }
+    }
+    update_types();
+    xSemaphoreGive(mutex);
+}
+
+esp_err_t multipart_manager_send(uint8_t type, const uint8_t* payload, size_t length, uint8_t* out_sequence) {
+    if (mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (payload == NULL || length == 0 || length > MESHCORE_MULTIPART_MAX_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    int sequence = meshcore_multipart_send(&multipart, type, payload, length, now_ms());
+    xSemaphoreGive(mutex);
+    if (sequence < 0) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (out_sequence != NULL) {
+        *out_sequence = (uint8_t)sequence;
+    }
+    return ESP_OK;
+}
+
+TickType_t multipart_manager_run(void) {
+    if (mutex == NULL) {
+        return portMAX_DELAY;
+    }
+
+    while (true) {
+        int64_t now = now_ms();
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        int64_t wait = meshcore_multipart_due(&multipart, now);
+        xSemaphoreGive(mutex);
+        if (wait != 0) {
+            return wait < 0 ? portMAX_DELAY : pdMS_TO_TICKS(wait);
+        }
+
+        packet_buffer_t* buffer = packet_pool_alloc();
+        if (buffer == NULL) {
+            return pdMS_TO_TICKS(1000);  // Try again once received packets have been handled
+        }
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        int built = meshcore_multipart_build(&multipart, now, &buffer->message);
+        xSemaphoreGive(mutex);
+        if (built == 1 && transmit_function != NULL) {
+            transmit_function(buffer);
+        }
+        packet_pool_free(buffer);
+    }
+}
+
+void multipart_manager_receive(packet_buffer_t* buffer) {
+    if (mutex == NULL) {
+        perf_count_drop(PERF_DROP_UNHANDLED);
+        return;
+    }
+
+    meshcore_multipart_result_t result;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    int res = meshcore_multipart_receive(&multipart, &buffer->message, now_ms(), reassembled, &result);
+    xSemaphoreGive(mutex);
+    if (res < 0) {
+        MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_WARN, MESHCORE_TRACE_PACKET, "Malformed multipart fragment");
+        perf_count_drop(PERF_DROP_PAYLOAD);
+        return;
+    }
+    if (res == 0) {
+        return;
+    }
+    MESHCORE_TRACE(MESHCORE_TRACE_LEVEL_DEBUG, MESHCORE_TRACE_PACKET, "Reassembled %u bytes of type %u from %02X",
+                   result.length, result.type, result.source);
+
+    // Handlers run without the lock so they are free to send, register and unregister
+    handler_entry_t matches[MULTIPART_MANAGER_MAX_HANDLERS];
+    size_t          count = 0;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (size_t i = 0; i < MULTIPART_MANAGER_MAX_HANDLERS; i++) {
+        if (handlers[i].handler != NULL && handlers[i].type == result.type) {
+            matches[count++] = handlers[i];
+        }
+    }
+    xSemaphoreGive(mutex);
+
+    if (count == 0) {
+        ESP_LOGD(TAG, "No handler for payload type %u", result.type);
+        perf_count_drop(PERF_DROP_UNHANDLED);
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        matches[i].handler(&result, reassembled, matches[i].context);
+    }
+}
+
+bool multipart_manager_get_stats(meshcore_multipart_stats_t* out_stats) {
+    if (mutex == NULL) {
+        return false;
+    }
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    *out_stats = multipart.stats;
+    xSemaphoreGive(mutex);
+    return true;
+}
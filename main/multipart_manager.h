@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "meshcore/multipart.h"
+#include "packet_pool.h"
+
+#define MULTIPART_MANAGER_MAX_HANDLERS 8
+
+// Called on the meshcore task for every reassembled payload of the registered type. The data is only valid until the
+// handler returns, it must be copied when it is needed later. Handlers must not block.
+typedef void (*multipart_handler_t)(const meshcore_multipart_result_t* result, const uint8_t* data, void* context);
+
+// Serializes and sends a packet, returns false when it could not be sent
+typedef bool (*multipart_transmit_t)(packet_buffer_t* buffer);
+
+// Prepare fragmentation and reassembly for our node hash, nothing is sent or reassembled before this is called
+esp_err_t multipart_manager_init(uint8_t own_hash, multipart_transmit_t transmit);
+
+// Deliver reassembled payloads of a payload type to a handler, a payload type can have several handlers
+esp_err_t multipart_manager_register(uint8_t type, multipart_handler_t handler, void* context);
+void      multipart_manager_unregister(uint8_t type, multipart_handler_t handler);
+
+// Queue a payload of up to MESHCORE_MULTIPART_MAX_SIZE bytes, the fragments are flooded by multipart_manager_run()
+esp_err_t multipart_manager_send(uint8_t type, const uint8_t* data, size_t length, uint8_t* out_sequence);
+
+// Transmit pending fragments and resend requests, returns how long the meshcore task may sleep until the next one
+TickType_t multipart_manager_run(void);
+
+// Handle a received MULTIPART packet and pass a completed payload to the handlers of its type
+void multipart_manager_receive(packet_buffer_t* buffer);
+
+// Copy the fragmentation counters, false before the manager is initialized
+bool multipart_manager_get_stats(meshcore_multipart_stats_t* out_stats);
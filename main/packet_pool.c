@@ -0,0 +1,35 @@
+#include "packet_pool.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+_Static_assert(PACKET_POOL_SIZE <= 32, "The free list is a 32-bit mask");
+
+static packet_buffer_t      packet_pool[PACKET_POOL_SIZE] = {0};
+static atomic_uint_fast32_t packet_pool_free_mask         = (uint32_t)((1ULL << PACKET_POOL_SIZE) - 1);
+
+packet_buffer_t* packet_pool_alloc(void) {
+    uint_fast32_t mask = atomic_load_explicit(&packet_pool_free_mask, memory_order_relaxed);
+    while (mask != 0) {
+        unsigned int index = __builtin_ctz(mask);
+        if (atomic_compare_exchange_weak_explicit(&packet_pool_free_mask, &mask, mask & ~(1UL << index),
+                                                  memory_order_acquire, memory_order_relaxed)) {
+            packet_buffer_t* buffer = &packet_pool[index];
+            memset(buffer, 0, sizeof(packet_buffer_t));
+            return buffer;
+        }
+    }
+    return NULL;
+}
+
+void packet_pool_free(packet_buffer_t* buffer) {
+    if (buffer == NULL) {
+        return;
+    }
+    size_t index = buffer - packet_pool;
+    atomic_fetch_or_explicit(&packet_pool_free_mask, 1UL << index, memory_order_release);
+}
+
+size_t packet_pool_get_free(void) {
+    return __builtin_popcount(atomic_load_explicit(&packet_pool_free_mask, memory_order_relaxed));
+}
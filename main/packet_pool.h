@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "lora.h"
+#include "meshcore/packet.h"
+#include "meshcore/payload/advert.h"
+#include "meshcore/payload/grp_data.h"
+#include "meshcore/payload/grp_txt.h"
+#include "meshcore/payload/txt_msg.h"
+
+#define PACKET_POOL_SIZE 16
+
+#define PACKET_RSSI_UNKNOWN INT16_MIN
+#define PACKET_SNR_UNKNOWN  INT8_MIN
+
+// Reception metadata, RSSI and SNR stay at their unknown values when the radio link does not report them
+typedef struct {
+    int64_t received_at;  // esp_timer timestamp (us) at which the frame reached the host
+    int16_t rssi;         // dBm
+    int8_t  snr;          // dB * 4
+} packet_rx_info_t;
+
+// A packet buffer carries a frame through the RX, parse, forward and TX stages. The raw frame, the decoded message and
+// the scratch space for the payload decoders live together so no stage needs large objects on its own stack. A buffer
+// has a single owner at a time: the RX ring hands it to the meshcore task, which parses, forwards and frees it.
+typedef struct {
+    lora_protocol_lora_packet_t packet;   // Raw frame as exchanged with the radio
+    packet_rx_info_t            rx;       // Reception metadata
+    meshcore_message_t          message;  // Decoded packet header, path and payload
+    union {
+        meshcore_advert_t   advert;
+        meshcore_grp_txt_t  grp_txt;
+        meshcore_grp_data_t grp_data;
+        meshcore_txt_msg_t  txt_msg;
+    } payload;  // Decoded payload
+    union {
+        meshcore_grp_txt_data_t grp_txt;
+        meshcore_txt_msg_data_t txt_msg;
+    } data;  // Decrypted payload contents
+} packet_buffer_t;
+
+// Take a cleared buffer from the pool, safe from any task and the radio callback. Returns NULL when it is exhausted.
+packet_buffer_t* packet_pool_alloc(void);
+
+// Return a buffer to the pool, NULL is ignored
+void packet_pool_free(packet_buffer_t* buffer);
+
+// Number of buffers currently available
+size_t packet_pool_get_free(void);
@@ -0,0 +1,50 @@
+#include "packet_ring.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+void packet_ring_init(packet_ring_t* ring) {
+    memset(ring->descriptors, 0, sizeof(ring->descriptors));
+    memset(&ring->stats, 0, sizeof(ring->stats));
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+}
+
+bool packet_ring_push(packet_ring_t* ring, const packet_descriptor_t* descriptor) {
+    uint_fast32_t head  = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint_fast32_t tail  = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    uint32_t      count = (uint32_t)(head - tail);
+
+    if (count >= PACKET_RING_SIZE) {
+        ring->stats.overflows++;
+        return false;
+    }
+
+    ring->descriptors[head & (PACKET_RING_SIZE - 1)] = *descriptor;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    ring->stats.received++;
+    if (count + 1 > ring->stats.high_water) {
+        ring->stats.high_water = count + 1;
+    }
+    return true;
+}
+
+bool packet_ring_pop(packet_ring_t* ring, packet_descriptor_t* out_descriptor) {
+    uint_fast32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint_fast32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (head == tail) {
+        return false;
+    }
+
+    *out_descriptor = ring->descriptors[tail & (PACKET_RING_SIZE - 1)];
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+size_t packet_ring_count(packet_ring_t* ring) {
+    uint_fast32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint_fast32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return (uint32_t)(head - tail);
+}
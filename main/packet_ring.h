@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "packet_pool.h"
+
+#define PACKET_RING_SIZE 16  // Must be a power of two
+
+_Static_assert((PACKET_RING_SIZE & (PACKET_RING_SIZE - 1)) == 0, "PACKET_RING_SIZE must be a power of two");
+
+typedef struct {
+    packet_buffer_t* buffer;
+    packet_rx_info_t rx;
+} packet_descriptor_t;
+
+typedef struct {
+    uint32_t received;    // Descriptors pushed into the ring
+    uint32_t overflows;   // Frames dropped because the ring was full
+    uint32_t no_buffer;   // Frames dropped because the packet pool was exhausted
+    uint32_t high_water;  // Highest ring occupancy seen
+} packet_ring_stats_t;
+
+// Single-producer / single-consumer ring of packet descriptors. The producer (radio callback) and the consumer
+// (meshcore task) each own one index, so no locks are needed.
+typedef struct {
+    packet_descriptor_t  descriptors[PACKET_RING_SIZE];
+    atomic_uint_fast32_t head;   // Written by the producer
+    atomic_uint_fast32_t tail;   // Written by the consumer
+    packet_ring_stats_t  stats;  // Written by the producer
+} packet_ring_t;
+
+void packet_ring_init(packet_ring_t* ring);
+
+// Producer side, returns false (and counts an overflow) when the ring is full
+bool packet_ring_push(packet_ring_t* ring, const packet_descriptor_t* descriptor);
+
+// Consumer side, returns false when the ring is empty
+bool packet_ring_pop(packet_ring_t* ring, packet_descriptor_t* out_descriptor);
+
+// Number of descriptors waiting to be consumed
+size_t packet_ring_count(packet_ring_t* ring);
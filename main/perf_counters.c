@@ -0,0 +1,107 @@
+#include "perf_counters.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+static const char* TAG = "perf";
+
+static perf_stage_stats_t stages[PERF_STAGE_COUNT]  = {0};
+static uint32_t           types[PERF_PAYLOAD_TYPES] = {0};
+static uint32_t           drops[PERF_DROP_COUNT]    = {0};
+
+static const char* stage_names[PERF_STAGE_COUNT] = {
+    "parse", "decode", "payload", "mac", "decrypt", "verify",
+};
+
+static const char* drop_names[PERF_DROP_COUNT] = {
+    "malformed", "payload", "mac", "signature", "not for us", "unhandled", "out of scope",
+};
+
+static const char* type_names[PERF_PAYLOAD_TYPES] = {
+    "req",  "response", "txt_msg",   "ack", "advert", "grp_txt", "grp_data", "anon_req",
+    "path", "trace",    "multipart", "0xB", "0xC",    "0xD",     "0xE",      "raw_custom",
+};
+
+void perf_end(perf_stage_t stage, uint32_t start) {
+    uint32_t            cycles = esp_cpu_get_cycle_count() - start;
+    perf_stage_stats_t* stats  = &stages[stage];
+    if (stats->samples == 0 || cycles < stats->min_cycles) {
+        stats->min_cycles = cycles;
+    }
+    if (cycles > stats->max_cycles) {
+        stats->max_cycles = cycles;
+    }
+    stats->samples++;
+    stats->total_cycles += cycles;
+    stats->histogram[cycles ? 31 - __builtin_clz(cycles) : 0]++;
+}
+
+void perf_count_type(uint8_t type) {
+    types[type % PERF_PAYLOAD_TYPES]++;
+}
+
+void perf_count_drop(perf_drop_t reason) {
+    drops[reason]++;
+}
+
+void perf_get_stage(perf_stage_t stage, perf_stage_stats_t* out_stats) {
+    *out_stats = stages[stage];
+}
+
+void perf_reset(void) {
+    memset(stages, 0, sizeof(stages));
+    memset(types, 0, sizeof(types));
+    memset(drops, 0, sizeof(drops));
+}
+
+static uint32_t cycles_to_us(uint64_t cycles) {
+    return (uint32_t)(cycles / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+}
+
+void perf_report(void) {
+    char line[256];
+    for (size_t i = 0; i < PERF_STAGE_COUNT; i++) {
+        perf_stage_stats_t stats = stages[i];
+        if (stats.samples == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "%-8s %6u samples, min %u us, average %u us, max %u us", stage_names[i],
+                 (unsigned int)stats.samples, (unsigned int)cycles_to_us(stats.min_cycles),
+                 (unsigned int)cycles_to_us(stats.total_cycles / stats.samples),
+                 (unsigned int)cycles_to_us(stats.max_cycles));
+
+        // Only the populated buckets, as "2^n:count"
+        size_t length = 0;
+        line[0]       = '\0';
+        for (size_t bucket = 0; bucket < PERF_HISTOGRAM_BUCKETS && length < sizeof(line); bucket++) {
+            if (stats.histogram[bucket] > 0) {
+                length += snprintf(&line[length], sizeof(line) - length, " 2^%u:%u", (unsigned int)bucket,
+                                   (unsigned int)stats.histogram[bucket]);
+            }
+        }
+        ESP_LOGI(TAG, "%-8s cycles%s", stage_names[i], line);
+    }
+
+    size_t length = 0;
+    line[0]       = '\0';
+    for (size_t i = 0; i < PERF_PAYLOAD_TYPES && length < sizeof(line); i++) {
+        if (types[i] > 0) {
+            length += snprintf(&line[length], sizeof(line) - length, " %s:%u", type_names[i], (unsigned int)types[i]);
+        }
+    }
+    ESP_LOGI(TAG, "Packets by type:%s", length > 0 ? line : " none");
+
+    length  = 0;
+    line[0] = '\0';
+    for (size_t i = 0; i < PERF_DROP_COUNT && length < sizeof(line); i++) {
+        if (drops[i] > 0) {
+            length += snprintf(&line[length], sizeof(line) - length, " %s:%u", drop_names[i], (unsigned int)drops[i]);
+        }
+    }
+    ESP_LOGI(TAG, "Dropped:%s", length > 0 ? line : " none");
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_cpu.h"
+
+#define PERF_HISTOGRAM_BUCKETS 32  // Bucket n counts samples of 2^n up to 2^(n+1) - 1 cycles
+#define PERF_PAYLOAD_TYPES     16
+
+typedef enum {
+    PERF_STAGE_PARSE,    // Whole handling of a received frame
+    PERF_STAGE_DECODE,   // Packet header, path and payload split
+    PERF_STAGE_PAYLOAD,  // Payload decoders (advert, group and direct message)
+    PERF_STAGE_MAC,      // Truncated HMAC-SHA256 checks, one sample per key tried
+    PERF_STAGE_DECRYPT,  // AES decryption after a MAC matched
+    PERF_STAGE_VERIFY,   // Ed25519 signature verification of adverts
+    PERF_STAGE_COUNT,
+} perf_stage_t;
+
+typedef enum {
+    PERF_DROP_MALFORMED,   // Packet could not be decoded
+    PERF_DROP_PAYLOAD,     // Payload could not be decoded
+    PERF_DROP_MAC,         // No key matched the MAC
+    PERF_DROP_SIGNATURE,   // Advert signature invalid
+    PERF_DROP_NOT_FOR_US,  // Direct message addressed to another node
+    PERF_DROP_UNHANDLED,   // Payload type this app does not process
+    PERF_DROP_SCOPE,       // Flood for a region we do not know
+    PERF_DROP_COUNT,
+} perf_drop_t;
+
+typedef struct {
+    uint32_t samples;
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+    uint32_t histogram[PERF_HISTOGRAM_BUCKETS];
+} perf_stage_stats_t;
+
+// Cycle counter at the start of a measured stage
+static inline uint32_t perf_begin(void) {
+    return esp_cpu_get_cycle_count();
+}
+
+// Record the cycles spent since perf_begin() returned start. Only the meshcore task records samples, so no locking is
+// done, a report taken concurrently can be off by the sample being recorded.
+void perf_end(perf_stage_t stage, uint32_t start);
+
+void perf_count_type(uint8_t type);
+void perf_count_drop(perf_drop_t reason);
+
+void perf_get_stage(perf_stage_t stage, perf_stage_stats_t* out_stats);
+void perf_reset(void);
+
+// Log all counters and histograms
+void perf_report(void);
@@ -0,0 +1,159 @@
+#include "region_manager.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "device_settings.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "hex.h"
+#include "meshcore/transport.h"
+
+static const char* TAG = "regions";
+
+// Stored region, the HMAC state is derived again when loading
+typedef struct __attribute__((packed)) {
+    char    name[MESHCORE_REGION_NAME_SIZE + sizeof('\0')];
+    uint8_t key[MESHCORE_TRANSPORT_KEY_SIZE];
+    uint8_t flags;  // 0 for an unused record
+} region_record_t;
+
+#define REGION_RECORD_USED  0x01
+#define REGION_RECORD_SCOPE 0x02
+
+static meshcore_regions_t regions = {0};
+static meshcore_region_t* scope   = NULL;  // Region our floods are sent to, NULL for unscoped
+static SemaphoreHandle_t  mutex   = NULL;  // Held by the meshcore task while checking codes, by the UI for changes
+
+// Call with the mutex held
+static esp_err_t save(void) {
+    region_record_t records[MESHCORE_MAX_REGIONS] = {0};
+    for (size_t i = 0; i < MESHCORE_MAX_REGIONS; i++) {
+        const meshcore_region_t* region = &regions.regions[i];
+        if (region->valid) {
+            memcpy(records[i].name, region->name, sizeof(records[i].name));
+            memcpy(records[i].key, region->key, sizeof(records[i].key));
+            records[i].flags = REGION_RECORD_USED | (region == scope ? REGION_RECORD_SCOPE : 0);
+        }
+    }
+    esp_err_t res = device_settings_set_meshcore_regions(records, sizeof(records));
+    if (res != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to store regions: %s", esp_err_to_name(res));
+    }
+    return res;
+}
+
+esp_err_t region_manager_init(void) {
+    mutex = xSemaphoreCreateMutex();
+    if (mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    meshcore_regions_init(&regions);
+
+    region_record_t records[MESHCORE_MAX_REGIONS];
+    if (device_settings_get_meshcore_regions(records, sizeof(records)) == ESP_OK) {
+        for (size_t i = 0; i < MESHCORE_MAX_REGIONS; i++) {
+            if ((records[i].flags & REGION_RECORD_USED) == 0) {
+                continue;
+            }
+            records[i].name[MESHCORE_REGION_NAME_SIZE] = '\0';
+            meshcore_region_t* region = meshcore_regions_add(&regions, records[i].name, records[i].key);
+            if (region == NULL) {
+                ESP_LOGW(TAG, "Ignoring stored region %s", records[i].name);
+            } else if (records[i].flags & REGION_RECORD_SCOPE) {
+                scope = region;
+            }
+        }
+    }
+
+    ESP_LOGI(TAG, "%u regions, sending %s", (unsigned int)regions.count, scope != NULL ? scope->name : "unscoped");
+    return ESP_OK;
+}
+
+esp_err_t region_manager_add(const char* name, const char* key_hex) {
+    if (name == NULL || name[0] == '\0' || strlen(name) > MESHCORE_REGION_NAME_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t key[MESHCORE_TRANSPORT_KEY_SIZE];
+    if (key_hex == NULL) {
+        if (name[0] != '#') {
+            return ESP_ERR_INVALID_ARG;
+        }
+        meshcore_region_hashtag_key(name, key);
+    } else if (!hex_to_bytes(key_hex, key, sizeof(key))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    uint8_t            count  = regions.count;
+    meshcore_region_t* region = meshcore_regions_add(&regions, name, key);
+    esp_err_t          res    = ESP_ERR_NO_MEM;
+    if (region != NULL) {
+        res = regions.count != count ? save() : ESP_OK;
+    }
+    xSemaphoreGive(mutex);
+    return res;
+}
+
+esp_err_t region_manager_remove(const char* name) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    meshcore_region_t* region = meshcore_regions_find_by_name(&regions, name);
+    esp_err_t          res    = ESP_ERR_NOT_FOUND;
+    if (region != NULL) {
+        if (region == scope) {
+            scope = NULL;
+        }
+        meshcore_regions_remove(&regions, region);
+        res = save();
+    }
+    xSemaphoreGive(mutex);
+    return res;
+}
+
+esp_err_t region_manager_set_scope(const char* name) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    meshcore_region_t* region = name != NULL ? meshcore_regions_find_by_name(&regions, name) : NULL;
+    esp_err_t          res    = ESP_ERR_NOT_FOUND;
+    if (name == NULL || region != NULL) {
+        scope = region;
+        res   = save();
+    }
+    xSemaphoreGive(mutex);
+    return res;
+}
+
+size_t region_manager_list(region_info_t* out_info, size_t max_count) {
+    size_t count = 0;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (size_t i = 0; i < MESHCORE_MAX_REGIONS && count < max_count; i++) {
+        const meshcore_region_t* region = &regions.regions[i];
+        if (region->valid) {
+            snprintf(out_info[count].name, sizeof(out_info[count].name), "%s", region->name);
+            out_info[count].scope = region == scope;
+            count++;
+        }
+    }
+    xSemaphoreGive(mutex);
+    return count;
+}
+
+bool region_manager_in_scope(const meshcore_message_t* message) {
+    // Unscoped packets need no codes calculated, skip the lock for the common case
+    if (message->route != MESHCORE_ROUTE_TYPE_TRANSPORT_FLOOD) {
+        return true;
+    }
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    bool in_scope = meshcore_regions_in_scope(&regions, message);
+    xSemaphoreGive(mutex);
+    return in_scope;
+}
+
+void region_manager_apply(meshcore_message_t* message) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    meshcore_transport_apply(scope, message);
+    xSemaphoreGive(mutex);
+}
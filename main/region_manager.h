@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "meshcore/packet.h"
+#include "meshcore/transport.h"
+
+typedef struct {
+    char name[MESHCORE_REGION_NAME_SIZE + sizeof('\0')];
+    bool scope;  // Floods we send are scoped to this region
+} region_info_t;
+
+// Load the regions from NVS, without regions all floods are accepted and ours are sent unscoped
+esp_err_t region_manager_init(void);
+
+// Add a region. Without a key the name must be a #hashtag and the key is derived from it, otherwise the key is given as
+// 32 hex digits. The region is stored in NVS.
+esp_err_t region_manager_add(const char* name, const char* key_hex);
+
+// Remove a region by name, it stops being the send scope when it was
+esp_err_t region_manager_remove(const char* name);
+
+// Scope the floods we send to a region, NULL sends them unscoped again
+esp_err_t region_manager_set_scope(const char* name);
+
+// Copy the regions, returns the number copied
+size_t region_manager_list(region_info_t* out_info, size_t max_count);
+
+// Check a received message right after the header was parsed, false when it is a flood for a region we do not know
+bool region_manager_in_scope(const meshcore_message_t* message);
+
+// Scope a flood message we are about to send to the send scope, call after the payload is final
+void region_manager_apply(meshcore_message_t* message);
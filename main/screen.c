@@ -0,0 +1,297 @@
+#include "screen.h"
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "bsp/display.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "pax_gfx.h"
+
+static const char* TAG = "screen";
+
+static pax_buf_t*        screen_fb              = NULL;
+static size_t            screen_h_res           = 0;
+static size_t            screen_v_res           = 0;
+static size_t            screen_bytes_per_pixel = 0;
+static pax_orientation_t screen_orientation     = PAX_O_UPRIGHT;
+static uint8_t*          staging                = NULL;
+static screen_stats_t    stats                  = {0};
+
+// Double buffering, front buffers hold packed copies of dirty rectangles until the blit task has sent them
+typedef struct {
+    uint8_t* pixels;
+    int      x;
+    int      y;
+    int      width;
+    int      height;
+} blit_job_t;
+
+static uint8_t*      front_buffers[SCREEN_FRONT_BUFFERS] = {0};
+static QueueHandle_t blit_jobs                           = NULL;  // blit_job_t, consumed by the blit task
+static QueueHandle_t free_buffers                        = NULL;  // Front buffers that can be filled again
+
+// Dirty bounding box in panel coordinates, empty when x0 >= x1
+static int dirty_x0 = INT_MAX;
+static int dirty_y0 = INT_MAX;
+static int dirty_x1 = 0;
+static int dirty_y1 = 0;
+
+static void record_blit(int64_t start) {
+    uint32_t duration  = (uint32_t)(esp_timer_get_time() - start);
+    stats.last_blit_us = duration;
+    if (duration > stats.max_blit_us) {
+        stats.max_blit_us = duration;
+    }
+}
+
+static void blit_task(void* arg) {
+    blit_job_t job;
+    while (1) {
+        if (xQueueReceive(blit_jobs, &job, portMAX_DELAY) == pdTRUE) {
+            int64_t start = esp_timer_get_time();
+            bsp_display_blit(job.x, job.y, job.width, job.height, job.pixels);
+            record_blit(start);
+            xQueueSend(free_buffers, &job.pixels, portMAX_DELAY);
+        }
+    }
+}
+
+static bool start_double_buffering(void) {
+    size_t frame_size = screen_h_res * screen_v_res * screen_bytes_per_pixel;
+    for (size_t i = 0; i < SCREEN_FRONT_BUFFERS; i++) {
+        front_buffers[i] = heap_caps_malloc(frame_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_DMA);
+        if (front_buffers[i] == NULL) {
+            front_buffers[i] = heap_caps_malloc(frame_size, MALLOC_CAP_SPIRAM);
+        }
+        if (front_buffers[i] == NULL) {
+            return false;
+        }
+    }
+
+    blit_jobs    = xQueueCreate(SCREEN_FRONT_BUFFERS, sizeof(blit_job_t));
+    free_buffers = xQueueCreate(SCREEN_FRONT_BUFFERS, sizeof(uint8_t*));
+    if (blit_jobs == NULL || free_buffers == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < SCREEN_FRONT_BUFFERS; i++) {
+        xQueueSend(free_buffers, &front_buffers[i], 0);
+    }
+
+    return xTaskCreatePinnedToCore(blit_task, "blit", SCREEN_BLIT_TASK_STACK, NULL, SCREEN_BLIT_TASK_PRIORITY, NULL,
+                                   0) == pdPASS;
+}
+
+static void stop_double_buffering(void) {
+    for (size_t i = 0; i < SCREEN_FRONT_BUFFERS; i++) {
+        heap_caps_free(front_buffers[i]);
+        front_buffers[i] = NULL;
+    }
+    if (blit_jobs != NULL) {
+        vQueueDelete(blit_jobs);
+        blit_jobs = NULL;
+    }
+    if (free_buffers != NULL) {
+        vQueueDelete(free_buffers);
+        free_buffers = NULL;
+    }
+}
+
+esp_err_t screen_init(pax_buf_t* fb, size_t h_res, size_t v_res, size_t bytes_per_pixel,
+                      pax_orientation_t orientation, bool double_buffered) {
+    screen_fb              = fb;
+    screen_h_res           = h_res;
+    screen_v_res           = v_res;
+    screen_bytes_per_pixel = bytes_per_pixel;
+    screen_orientation     = orientation;
+
+    size_t staging_size = SCREEN_STAGING_ROWS * h_res * bytes_per_pixel;
+    staging             = heap_caps_malloc(staging_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_DMA);
+    if (staging == NULL) {
+        staging = heap_caps_malloc(staging_size, MALLOC_CAP_SPIRAM);
+    }
+    if (staging == NULL) {
+        // Partial updates fall back to full panel rows, which need no packing
+        ESP_LOGW(TAG, "No memory for the staging buffer");
+    }
+
+    if (double_buffered && !start_double_buffering()) {
+        ESP_LOGW(TAG, "Failed to set up double buffering, falling back to blocking transfers");
+        stop_double_buffering();
+    }
+    return ESP_OK;
+}
+
+// Map a point from PAX coordinates to panel coordinates, this mirrors the transformation PAX applies when drawing
+static void to_panel(int x, int y, int* out_x, int* out_y) {
+    switch (screen_orientation) {
+        case PAX_O_ROT_CCW:
+            *out_x = y;
+            *out_y = (int)screen_v_res - x;
+            break;
+        case PAX_O_ROT_HALF:
+            *out_x = (int)screen_h_res - x;
+            *out_y = (int)screen_v_res - y;
+            break;
+        case PAX_O_ROT_CW:
+            *out_x = (int)screen_h_res - y;
+            *out_y = x;
+            break;
+        case PAX_O_UPRIGHT:
+        default:
+            *out_x = x;
+            *out_y = y;
+            break;
+    }
+}
+
+void screen_mark_dirty(int x, int y, int width, int height) {
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
+    int ax, ay, bx, by;
+    to_panel(x, y, &ax, &ay);
+    to_panel(x + width, y + height, &bx, &by);
+
+    int x0 = ax < bx ? ax : bx;
+    int x1 = ax < bx ? bx : ax;
+    int y0 = ay < by ? ay : by;
+    int y1 = ay < by ? by : ay;
+
+    if (x0 < dirty_x0) {
+        dirty_x0 = x0;
+    }
+    if (y0 < dirty_y0) {
+        dirty_y0 = y0;
+    }
+    if (x1 > dirty_x1) {
+        dirty_x1 = x1;
+    }
+    if (y1 > dirty_y1) {
+        dirty_y1 = y1;
+    }
+}
+
+static void reset_dirty(void) {
+    dirty_x0 = INT_MAX;
+    dirty_y0 = INT_MAX;
+    dirty_x1 = 0;
+    dirty_y1 = 0;
+}
+
+static void account(int64_t start, size_t bytes, bool full) {
+    uint32_t duration = (uint32_t)(esp_timer_get_time() - start);
+    stats.frames++;
+    stats.full_frames   += full ? 1 : 0;
+    stats.bytes         += bytes;
+    stats.last_bytes     = bytes;
+    stats.last_time_us   = duration;
+    stats.total_time_us += duration;
+    if (duration > stats.max_time_us) {
+        stats.max_time_us = duration;
+    }
+}
+
+// Hand a copy of the rectangle to the blit task, only waits when all front buffers are still in flight
+static void flush_async(const uint8_t* pixels, int x0, int y0, int x1, int y1) {
+    uint8_t* buffer;
+    if (xQueueReceive(free_buffers, &buffer, 0) != pdTRUE) {
+        stats.waits++;
+        xQueueReceive(free_buffers, &buffer, portMAX_DELAY);
+    }
+
+    size_t stride    = screen_h_res * screen_bytes_per_pixel;
+    size_t row_bytes = (x1 - x0) * screen_bytes_per_pixel;
+    if (row_bytes == stride) {
+        memcpy(buffer, &pixels[y0 * stride], (y1 - y0) * stride);
+    } else {
+        for (int y = y0; y < y1; y++) {
+            memcpy(&buffer[(y - y0) * row_bytes], &pixels[y * stride + x0 * screen_bytes_per_pixel], row_bytes);
+        }
+    }
+
+    blit_job_t job = {
+        .pixels = buffer,
+        .x      = x0,
+        .y      = y0,
+        .width  = x1 - x0,
+        .height = y1 - y0,
+    };
+    xQueueSend(blit_jobs, &job, portMAX_DELAY);
+}
+
+static void flush_blocking(const uint8_t* pixels, int x0, int y0, int x1, int y1) {
+    int64_t start  = esp_timer_get_time();
+    size_t  stride = screen_h_res * screen_bytes_per_pixel;
+    size_t  width  = x1 - x0;
+    if (width == screen_h_res) {
+        bsp_display_blit(0, y0, width, y1 - y0, &pixels[y0 * stride]);
+    } else {
+        // Pack the rectangle into the staging buffer a few rows at a time
+        size_t row_bytes = width * screen_bytes_per_pixel;
+        for (int y = y0; y < y1; y += SCREEN_STAGING_ROWS) {
+            int rows = (y1 - y) < SCREEN_STAGING_ROWS ? (y1 - y) : SCREEN_STAGING_ROWS;
+            for (int row = 0; row < rows; row++) {
+                memcpy(&staging[row * row_bytes], &pixels[(y + row) * stride + x0 * screen_bytes_per_pixel],
+                       row_bytes);
+            }
+            bsp_display_blit(x0, y, width, rows, staging);
+        }
+    }
+    record_blit(start);
+}
+
+static void flush_rect(int x0, int y0, int x1, int y1, bool full) {
+    int64_t        start  = esp_timer_get_time();
+    const uint8_t* pixels = pax_buf_get_pixels(screen_fb);
+
+    if (blit_jobs != NULL) {
+        flush_async(pixels, x0, y0, x1, y1);
+    } else {
+        if (staging == NULL) {
+            // Whole panel rows are contiguous in the framebuffer
+            x0 = 0;
+            x1 = screen_h_res;
+        }
+        flush_blocking(pixels, x0, y0, x1, y1);
+    }
+
+    account(start, (x1 - x0) * (y1 - y0) * screen_bytes_per_pixel, full);
+}
+
+void screen_flush(void) {
+    if (screen_fb == NULL) {
+        return;
+    }
+
+    // Clamp to the panel
+    int x0 = dirty_x0 < 0 ? 0 : dirty_x0;
+    int y0 = dirty_y0 < 0 ? 0 : dirty_y0;
+    int x1 = dirty_x1 > (int)screen_h_res ? (int)screen_h_res : dirty_x1;
+    int y1 = dirty_y1 > (int)screen_v_res ? (int)screen_v_res : dirty_y1;
+    reset_dirty();
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    flush_rect(x0, y0, x1, y1, false);
+}
+
+void screen_flush_full(void) {
+    if (screen_fb == NULL) {
+        return;
+    }
+    reset_dirty();
+    flush_rect(0, 0, screen_h_res, screen_v_res, true);
+}
+
+void screen_get_stats(screen_stats_t* out_stats) {
+    *out_stats = stats;
+}
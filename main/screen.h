@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "pax_gfx.h"
+
+#define SCREEN_STAGING_ROWS       32  // Panel rows packed per transfer for rectangles narrower than the panel
+#define SCREEN_FRONT_BUFFERS      2   // Frames that can be in flight to the panel while the next one is rendered
+#define SCREEN_BLIT_TASK_STACK    3072
+#define SCREEN_BLIT_TASK_PRIORITY 5
+
+typedef struct {
+    uint32_t frames;         // Flushes that transferred pixels
+    uint32_t full_frames;    // Flushes of the whole framebuffer
+    uint64_t bytes;          // Pixel bytes handed to the display
+    uint32_t last_bytes;     // Pixel bytes of the last flush
+    uint32_t last_time_us;   // Time the caller spent in the last flush
+    uint32_t max_time_us;    // Longest time a caller spent in a flush
+    uint64_t total_time_us;  // Sum of the time callers spent flushing
+    uint32_t last_blit_us;   // Duration of the last transfer to the panel
+    uint32_t max_blit_us;    // Longest transfer to the panel
+    uint32_t waits;          // Flushes that had to wait for a front buffer to become free
+} screen_stats_t;
+
+// Attach to the framebuffer, h_res and v_res are the native panel dimensions (before PAX orientation is applied).
+// When double buffered, a flush copies the dirty rectangle into a front buffer and a background task transfers it to
+// the panel, so drawing the next frame can start right away. Falls back to blocking transfers when out of memory.
+esp_err_t screen_init(pax_buf_t* fb, size_t h_res, size_t v_res, size_t bytes_per_pixel,
+                      pax_orientation_t orientation, bool double_buffered);
+
+// Record that a rectangle (in PAX coordinates) has been drawn to
+void screen_mark_dirty(int x, int y, int width, int height);
+
+// Push the dirty region to the display, only the bounding box of the damage is transferred
+void screen_flush(void);
+
+// Push the whole framebuffer to the display
+void screen_flush_full(void);
+
+void screen_get_stats(screen_stats_t* out_stats);
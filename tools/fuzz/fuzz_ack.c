@@ -0,0 +1,29 @@
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+// Fuzz target for ACK payloads, the checksum is the first four bytes and anything after it is ignored
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "fuzz_target.h"
+#include "meshcore/packet.h"
+#include "meshcore/payload/ack.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    uint8_t* payload = fuzz_copy(data, size);
+    if (payload == NULL) {
+        return 0;
+    }
+
+    meshcore_ack_t ack;
+    if (meshcore_ack_deserialize(payload, size, &ack) == 0) {
+        uint8_t output[MESHCORE_MAX_PAYLOAD_SIZE];
+        uint8_t output_size = 0;
+        FUZZ_CHECK(meshcore_ack_serialize(&ack, output, &output_size) == 0);
+        fuzz_check_round_trip(data, sizeof(uint32_t), output, output_size);
+    }
+
+    free(payload);
+    return 0;
+}
@@ -0,0 +1,38 @@
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+// Fuzz target for ADVERT payloads: decoding, and the signature check every received advert goes through
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ed25519/ed_25519.h"
+#include "fuzz_target.h"
+#include "meshcore/payload/advert.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    uint8_t* payload = fuzz_copy(data, size);
+    if (payload == NULL) {
+        return 0;
+    }
+
+    meshcore_advert_t        advert;
+    meshcore_advert_signed_t signed_parts;
+    if (meshcore_advert_decode(payload, size, &advert, &signed_parts) == 0) {
+        FUZZ_CHECK(!advert.name_valid || strlen(advert.name) <= MESHCORE_MAX_NAME_SIZE);
+        size_t length = 0;
+        for (size_t i = 0; i < signed_parts.count; i++) {
+            const uint8_t* part = signed_parts.parts[i].data;
+            FUZZ_CHECK(part >= payload && part + signed_parts.parts[i].length <= payload + size);
+            length += signed_parts.parts[i].length;
+        }
+        FUZZ_CHECK(length == signed_parts.length);
+        ed25519_verify_iov(advert.signature, signed_parts.parts, signed_parts.count, advert.pub_key);
+    }
+
+    meshcore_advert_deserialize(payload, size, &advert);
+
+    free(payload);
+    return 0;
+}
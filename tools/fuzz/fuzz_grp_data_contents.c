@@ -0,0 +1,34 @@
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+// Fuzz target for decrypted GRP_DATA contents, the view must stay inside the decrypted buffer
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "fuzz_target.h"
+#include "meshcore/payload/grp_data.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    uint8_t* contents = fuzz_copy(data, size);
+    if (contents == NULL) {
+        return 0;
+    }
+
+    meshcore_grp_data_view_t view;
+    if (meshcore_grp_data_decode(contents, size, &view) == 0) {
+        FUZZ_CHECK(view.data >= contents + MESHCORE_GRP_DATA_HEADER_SIZE);
+        FUZZ_CHECK(view.data + view.data_length <= contents + size);
+
+        // Re-encoding the view gives the contents without the padding
+        uint8_t output[MESHCORE_GRP_DATA_CIPHER_SIZE];
+        uint8_t output_size = 0;
+        if (meshcore_grp_data_encode(view.timestamp, view.data_type, view.data, view.data_length, output,
+                                     sizeof(output), &output_size) == 0) {
+            fuzz_check_round_trip(data, output_size, output, output_size);
+        }
+    }
+
+    free(contents);
+    return 0;
+}
@@ -0,0 +1,29 @@
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+// Fuzz target for GRP_TXT payloads, every accepted payload must serialize back to the same bytes
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "fuzz_target.h"
+#include "meshcore/packet.h"
+#include "meshcore/payload/grp_txt.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    uint8_t* payload = fuzz_copy(data, size);
+    if (payload == NULL) {
+        return 0;
+    }
+
+    meshcore_grp_txt_t grp_txt;
+    if (meshcore_grp_txt_deserialize(payload, size, &grp_txt) == 0) {
+        uint8_t output[MESHCORE_MAX_PAYLOAD_SIZE];
+        uint8_t output_size = 0;
+        FUZZ_CHECK(meshcore_grp_txt_serialize(&grp_txt, output, &output_size) == 0);
+        fuzz_check_round_trip(data, size, output, output_size);
+    }
+
+    free(payload);
+    return 0;
+}
@@ -0,0 +1,26 @@
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+// Fuzz target for decrypted GRP_TXT contents: timestamp, text type and the zero padded text
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fuzz_target.h"
+#include "meshcore/payload/grp_txt.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    uint8_t* contents = fuzz_copy(data, size);
+    if (contents == NULL) {
+        return 0;
+    }
+
+    meshcore_grp_txt_data_t grp_txt_data;
+    if (meshcore_grp_txt_data_deserialize(contents, size, &grp_txt_data) == 0) {
+        FUZZ_CHECK(strnlen(grp_txt_data.text, sizeof(grp_txt_data.text)) < sizeof(grp_txt_data.text));
+    }
+
+    free(contents);
+    return 0;
+}
@@ -0,0 +1,63 @@
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+// Fuzz target for multipart fragmentation and reassembly. The input is a series of MULTIPART payloads, each prefixed
+// with its length. They are received a second apart, and after each one the frames that became due are built. A payload
+// of our own is in flight, so resend requests for it are served as well.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "fuzz_target.h"
+#include "meshcore/multipart.h"
+#include "meshcore/packet.h"
+
+#define OWN_HASH     0x42
+#define OWN_TYPE     0x0F
+#define OWN_LENGTH   400   // Three fragments
+#define STEP         1000  // Milliseconds between the received payloads
+#define MAX_BUILDS   8     // Frames built after a payload
+
+static meshcore_multipart_t multipart;
+static uint8_t              own_payload[OWN_LENGTH];
+static uint8_t              reassembled[MESHCORE_MULTIPART_MAX_SIZE];
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    meshcore_multipart_init(&multipart, OWN_HASH, 0);
+    for (size_t i = 0; i < OWN_LENGTH; i++) {
+        own_payload[i] = (uint8_t)i;
+    }
+    FUZZ_CHECK(meshcore_multipart_send(&multipart, OWN_TYPE, own_payload, OWN_LENGTH, 0) >= 0);
+
+    int64_t now      = 0;
+    size_t  position = 0;
+    while (position < size) {
+        uint8_t length = data[position++];
+        if (length > MESHCORE_MAX_PAYLOAD_SIZE || length > size - position) {
+            break;
+        }
+
+        meshcore_message_t message = {
+            .type           = MESHCORE_PAYLOAD_TYPE_MULTIPART,
+            .route          = MESHCORE_ROUTE_TYPE_FLOOD,
+            .payload_length = length,
+        };
+        memcpy(message.payload, &data[position], length);
+        position += length;
+        now      += STEP;
+
+        meshcore_multipart_result_t result;
+        if (meshcore_multipart_receive(&multipart, &message, now, reassembled, &result) == 1) {
+            FUZZ_CHECK(result.length > 0 && result.length <= MESHCORE_MULTIPART_MAX_SIZE);
+        }
+
+        for (size_t i = 0; i < MAX_BUILDS && meshcore_multipart_due(&multipart, now) == 0; i++) {
+            meshcore_message_t built;
+            if (meshcore_multipart_build(&multipart, now, &built) == 1) {
+                FUZZ_CHECK(built.payload_length <= MESHCORE_MAX_PAYLOAD_SIZE);
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,31 @@
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+// Fuzz target for the packet framing: every frame meshcore_deserialize accepts must serialize back to the same bytes
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "fuzz_target.h"
+#include "meshcore/packet.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    uint8_t* frame = fuzz_copy(data, size);
+    if (frame == NULL) {
+        return 0;
+    }
+
+    meshcore_message_t message;
+    if (meshcore_deserialize(frame, size, &message) == 0) {
+        FUZZ_CHECK(message.path_length <= MESHCORE_MAX_PATH_SIZE);
+        FUZZ_CHECK(message.payload_length <= MESHCORE_MAX_PAYLOAD_SIZE);
+
+        uint8_t output[MESHCORE_MAX_TRANS_UNIT];
+        uint8_t output_size = 0;
+        FUZZ_CHECK(meshcore_serialize(&message, output, &output_size) == 0);
+        fuzz_check_round_trip(data, size, output, output_size);
+    }
+
+    free(frame);
+    return 0;
+}
@@ -0,0 +1,30 @@
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+// Fuzz target for TRACE payloads, every accepted payload must serialize back to the same bytes
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "fuzz_target.h"
+#include "meshcore/packet.h"
+#include "meshcore/payload/path_trace.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    uint8_t* payload = fuzz_copy(data, size);
+    if (payload == NULL) {
+        return 0;
+    }
+
+    meshcore_path_trace_t trace;
+    if (meshcore_path_trace_deserialize(payload, size, &trace) == 0) {
+        FUZZ_CHECK(trace.hop_count <= MESHCORE_PATH_TRACE_MAX_HOPS);
+        uint8_t output[MESHCORE_MAX_PAYLOAD_SIZE];
+        uint8_t output_size = 0;
+        FUZZ_CHECK(meshcore_path_trace_serialize(&trace, output, &output_size) == 0);
+        fuzz_check_round_trip(data, size, output, output_size);
+    }
+
+    free(payload);
+    return 0;
+}
@@ -0,0 +1,107 @@
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+// Runs a fuzz target over corpus files without libFuzzer, so the corpus doubles as a regression test with any compiler
+// that has the address and undefined behaviour sanitizers. Arguments are files or directories of files.
+
+#include <dirent.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "fuzz_target.h"
+
+static bool run_file(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return false;
+    }
+    uint8_t* data   = NULL;
+    size_t   size   = 0;
+    size_t   length = 0;
+    while (true) {
+        if (length == size) {
+            size          = size > 0 ? size * 2 : 256;
+            uint8_t* grow = realloc(data, size);
+            if (grow == NULL) {
+                free(data);
+                fclose(file);
+                return false;
+            }
+            data = grow;
+        }
+        size_t read = fread(&data[length], 1, size - length, file);
+        if (read == 0) {
+            break;
+        }
+        length += read;
+    }
+    fclose(file);
+
+    // Give the target a buffer of exactly the input size, like libFuzzer does
+    uint8_t* input = malloc(length > 0 ? length : 1);
+    if (input == NULL) {
+        free(data);
+        return false;
+    }
+    memcpy(input, data, length);
+    free(data);
+    LLVMFuzzerTestOneInput(input, length);
+    free(input);
+    return true;
+}
+
+static long run_path(const char* path) {
+    struct stat status;
+    if (stat(path, &status) != 0) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return -1;
+    }
+    if (!S_ISDIR(status.st_mode)) {
+        return run_file(path) ? 1 : -1;
+    }
+
+    DIR* directory = opendir(path);
+    if (directory == NULL) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return -1;
+    }
+    long           count = 0;
+    struct dirent* entry;
+    while ((entry = readdir(directory)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        char file_path[4096];
+        snprintf(file_path, sizeof(file_path), "%s/%s", path, entry->d_name);
+        if (!run_file(file_path)) {
+            closedir(directory);
+            return -1;
+        }
+        count++;
+    }
+    closedir(directory);
+    return count;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s FILE|DIRECTORY...\n", argv[0]);
+        return 1;
+    }
+
+    long total = 0;
+    for (int i = 1; i < argc; i++) {
+        long count = run_path(argv[i]);
+        if (count < 0) {
+            return 1;
+        }
+        total += count;
+    }
+    printf("%s: %ld inputs\n", argv[0], total);
+    return 0;
+}
@@ -0,0 +1,44 @@
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+// Shared by the fuzz targets. Every target defines LLVMFuzzerTestOneInput() and links against libFuzzer (make fuzz) or
+// against fuzz_standalone.c, which replays corpus files without libFuzzer (make fuzz-regression).
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Abort on a broken invariant, both drivers report the input that caused it
+#define FUZZ_CHECK(condition)                                                             \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            abort();                                                                      \
+        }                                                                                 \
+    } while (0)
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+// The decoders take a mutable buffer and a uint8_t size. The input is copied to a heap buffer of exactly its size so
+// AddressSanitizer catches reads past the end. Returns NULL for inputs longer than a frame, they are skipped.
+static inline uint8_t* fuzz_copy(const uint8_t* data, size_t size) {
+    if (size > UINT8_MAX) {
+        return NULL;
+    }
+    uint8_t* copy = malloc(size > 0 ? size : 1);
+    if (copy != NULL && size > 0) {
+        memcpy(copy, data, size);
+    }
+    return copy;
+}
+
+// Check that re-encoding a decoded input gives back the same bytes
+static inline void fuzz_check_round_trip(const uint8_t* input, size_t input_size, const uint8_t* output,
+                                         uint8_t output_size) {
+    FUZZ_CHECK(output_size == input_size);
+    FUZZ_CHECK(memcmp(output, input, input_size) == 0);
+}
@@ -0,0 +1,26 @@
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+// Fuzz target for decrypted TXT_MSG contents: timestamp, flags and the zero padded text
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fuzz_target.h"
+#include "meshcore/payload/txt_msg.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    uint8_t* contents = fuzz_copy(data, size);
+    if (contents == NULL) {
+        return 0;
+    }
+
+    meshcore_txt_msg_data_t txt_msg_data;
+    if (meshcore_txt_msg_data_deserialize(contents, size, &txt_msg_data) == 0) {
+        FUZZ_CHECK(strnlen(txt_msg_data.text, sizeof(txt_msg_data.text)) < sizeof(txt_msg_data.text));
+    }
+
+    free(contents);
+    return 0;
+}
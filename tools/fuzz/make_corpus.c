@@ -0,0 +1,492 @@
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+// Builds the seed corpus of the fuzz targets from frame captures, the same files tools/mcap_replay reads. Every frame
+// seeds the packet target and its payload the target of its type. Group and direct messages that decrypt with one of
+// the known secrets also seed the targets for their decrypted contents. Frames of every payload type the firmware
+// handles are built with the protocol code as well, so the corpus covers types that are missing from the captures.
+// Those frames can be written to a capture of their own, which mcap_replay reads like any other.
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "capture_format.h"
+#include "crypto/sha256.h"
+#include "ed25519/ed_25519.h"
+#include "meshcore/channels.h"
+#include "meshcore/cipher.h"
+#include "meshcore/flood.h"
+#include "meshcore/multipart.h"
+#include "meshcore/packet.h"
+#include "meshcore/path_trace.h"
+#include "meshcore/payload/ack.h"
+#include "meshcore/payload/advert.h"
+#include "meshcore/payload/grp_data.h"
+#include "meshcore/payload/grp_txt.h"
+#include "meshcore/payload/path_trace.h"
+#include "meshcore/payload/request.h"
+#include "meshcore/payload/txt_msg.h"
+#include "meshcore/self_advert.h"
+#include "meshcore/transport.h"
+
+#define MAX_SECRETS     8
+#define MAX_FRAMES      64                                  // Frames built with the protocol code
+#define MULTIPART_INPUT 4096                                // Largest input of the multipart target
+#define TIMESTAMP       1735689600                          // 2025-01-01, the remote clock of the built frames
+#define PUBLIC_SECRET   "8b3387e9c5cdea6ac9e5edbaa115cd72"  // Public channel
+#define HASHTAG_CHANNEL "#test"
+#define HASHTAG_REGION  "#nl"
+
+typedef struct {
+    uint8_t length;
+    uint8_t data[MESHCORE_MAX_TRANS_UNIT];
+} frame_t;
+
+static uint8_t     secrets[MAX_SECRETS][MESHCORE_SHARED_SECRET_SIZE];
+static size_t      secret_count = 0;
+static const char* corpus_dir   = NULL;
+static size_t      inputs       = 0;
+
+// Multipart payloads are collected into one input, so the target sees the fragments of a payload together
+static uint8_t multipart_input[MULTIPART_INPUT];
+static size_t  multipart_length = 0;
+
+static frame_t frames[MAX_FRAMES];
+static size_t  frame_count = 0;
+
+static bool add_secret(const uint8_t* secret, size_t length) {
+    if (secret_count >= MAX_SECRETS || length > MESHCORE_SHARED_SECRET_SIZE) {
+        return false;
+    }
+    memset(secrets[secret_count], 0, MESHCORE_SHARED_SECRET_SIZE);
+    memcpy(secrets[secret_count], secret, length);
+    secret_count++;
+    return true;
+}
+
+static bool add_channel_key(const char* hex) {
+    if (strlen(hex) != MESHCORE_CIPHER_KEY_SIZE * 2) {
+        return false;
+    }
+    uint8_t key[MESHCORE_CIPHER_KEY_SIZE];
+    for (size_t i = 0; i < MESHCORE_CIPHER_KEY_SIZE; i++) {
+        unsigned int value;
+        if (sscanf(&hex[i * 2], "%2x", &value) != 1) {
+            return false;
+        }
+        key[i] = (uint8_t)value;
+    }
+    return add_secret(key, sizeof(key));
+}
+
+static bool make_directory(const char* path) {
+    if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+        perror(path);
+        return false;
+    }
+    return true;
+}
+
+// Write an input for a target, the file is named after the SHA-256 of its contents so duplicates collapse into one
+static bool write_input(const char* target, const uint8_t* data, size_t size) {
+    char directory[1024];
+    snprintf(directory, sizeof(directory), "%s/%s", corpus_dir, target);
+    if (!make_directory(directory)) {
+        return false;
+    }
+
+    SHA256_HASH digest;
+    Sha256Calculate(data, (uint32_t)size, &digest);
+    char path[1100];
+    int  length = snprintf(path, sizeof(path), "%s/", directory);
+    for (size_t i = 0; i < 8; i++) {
+        length += snprintf(&path[length], sizeof(path) - length, "%02x", digest.bytes[i]);
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL || fwrite(data, 1, size, file) != size) {
+        perror(path);
+        if (file != NULL) {
+            fclose(file);
+        }
+        return false;
+    }
+    fclose(file);
+    inputs++;
+    return true;
+}
+
+// Decrypt a ciphertext with the first secret whose MAC matches, returns false when none does
+static bool decrypt(const uint8_t* mac, const uint8_t* ciphertext, uint8_t length, uint8_t* out_plaintext) {
+    for (size_t i = 0; i < secret_count; i++) {
+        memcpy(out_plaintext, ciphertext, length);
+        if (meshcore_mac_then_decrypt(secrets[i], MESHCORE_SHARED_SECRET_SIZE, mac, out_plaintext, length) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool add_multipart(const uint8_t* payload, uint8_t length) {
+    uint8_t input[MESHCORE_MAX_PAYLOAD_SIZE + 1];
+    input[0] = length;
+    memcpy(&input[1], payload, length);
+    if (!write_input("multipart", input, length + 1)) {
+        return false;
+    }
+    if (multipart_length + length + 1 <= sizeof(multipart_input)) {
+        memcpy(&multipart_input[multipart_length], input, length + 1);
+        multipart_length += length + 1;
+    }
+    return true;
+}
+
+static bool split_frame(const uint8_t* data, uint8_t length) {
+    if (!write_input("packet", data, length)) {
+        return false;
+    }
+
+    uint8_t frame[MESHCORE_MAX_TRANS_UNIT];
+    memcpy(frame, data, length);
+    meshcore_message_t message;
+    if (meshcore_deserialize(frame, length, &message) < 0) {
+        return true;  // Malformed frames only seed the packet target
+    }
+
+    uint8_t plaintext[MESHCORE_MAX_PAYLOAD_SIZE];
+    switch (message.type) {
+        case MESHCORE_PAYLOAD_TYPE_REQ:
+            return write_input("request", message.payload, message.payload_length);
+        case MESHCORE_PAYLOAD_TYPE_TXT_MSG: {
+            meshcore_txt_msg_t txt_msg;
+            if (!write_input("txt_msg", message.payload, message.payload_length)) {
+                return false;
+            }
+            if (meshcore_txt_msg_deserialize(message.payload, message.payload_length, &txt_msg) < 0) {
+                return true;
+            }
+            if (decrypt(txt_msg.cipher_mac, txt_msg.ciphertext, txt_msg.ciphertext_length, plaintext)) {
+                return write_input("txt_msg_data", plaintext, txt_msg.ciphertext_length);
+            }
+            return true;
+        }
+        case MESHCORE_PAYLOAD_TYPE_ACK:
+            return write_input("ack", message.payload, message.payload_length);
+        case MESHCORE_PAYLOAD_TYPE_ADVERT:
+            return write_input("advert", message.payload, message.payload_length);
+        case MESHCORE_PAYLOAD_TYPE_GRP_TXT:
+        case MESHCORE_PAYLOAD_TYPE_GRP_DATA: {
+            bool               text = message.type == MESHCORE_PAYLOAD_TYPE_GRP_TXT;
+            meshcore_grp_txt_t grp_txt;
+            if (!write_input(text ? "grp_txt" : "grp_data", message.payload, message.payload_length)) {
+                return false;
+            }
+            if (meshcore_grp_txt_deserialize(message.payload, message.payload_length, &grp_txt) < 0) {
+                return true;
+            }
+            if (decrypt(grp_txt.mac, grp_txt.data, grp_txt.data_length, plaintext)) {
+                return write_input(text ? "grp_txt_data" : "grp_data_contents", plaintext, grp_txt.data_length);
+            }
+            return true;
+        }
+        case MESHCORE_PAYLOAD_TYPE_TRACE:
+            return write_input("path_trace", message.payload, message.payload_length);
+        case MESHCORE_PAYLOAD_TYPE_MULTIPART:
+            return add_multipart(message.payload, message.payload_length);
+        default:
+            return true;
+    }
+}
+
+static bool split_capture(const char* filename) {
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL) {
+        perror(filename);
+        return false;
+    }
+    capture_file_header_t header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != CAPTURE_MAGIC ||
+        header.version != CAPTURE_VERSION || header.header_size < sizeof(header) ||
+        fseek(file, header.header_size, SEEK_SET) != 0) {
+        fprintf(stderr, "%s: not a capture file\n", filename);
+        fclose(file);
+        return false;
+    }
+
+    capture_record_header_t record;
+    uint8_t                 data[CAPTURE_MAX_FRAME_SIZE];
+    while (fread(&record, sizeof(record), 1, file) == 1) {
+        if (fread(data, 1, record.length, file) != record.length) {
+            fprintf(stderr, "%s: truncated record\n", filename);
+            break;
+        }
+        if (!split_frame(data, record.length)) {
+            fclose(file);
+            return false;
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+static void add_frame(const meshcore_message_t* message) {
+    if (frame_count >= MAX_FRAMES || meshcore_serialize(message, frames[frame_count].data,
+                                                        &frames[frame_count].length) < 0) {
+        fprintf(stderr, "Failed to build frame %zu\n", frame_count);
+        exit(1);
+    }
+    frame_count++;
+}
+
+static void add_grp_txt(const uint8_t* secret, uint8_t hash, const char* text, meshcore_message_t* out_message) {
+    meshcore_grp_txt_data_t data = {.timestamp = TIMESTAMP};
+    snprintf(data.text, sizeof(data.text), "%s", text);
+
+    meshcore_grp_txt_t grp_txt = {.channel_hash = hash};
+    uint8_t            length  = 0;
+    meshcore_grp_txt_data_serialize(&data, grp_txt.data, &length);
+    meshcore_encrypt_then_mac(secret, MESHCORE_SHARED_SECRET_SIZE, grp_txt.data, length, sizeof(grp_txt.data),
+                              &grp_txt.data_length, grp_txt.mac);
+
+    memset(out_message, 0, sizeof(meshcore_message_t));
+    out_message->type  = MESHCORE_PAYLOAD_TYPE_GRP_TXT;
+    out_message->route = MESHCORE_ROUTE_TYPE_FLOOD;
+    meshcore_grp_txt_serialize(&grp_txt, out_message->payload, &out_message->payload_length);
+}
+
+static uint8_t channel_hash(const uint8_t* secret, size_t length) {
+    SHA256_HASH digest;
+    Sha256Calculate(secret, (uint32_t)length, &digest);
+    return digest.bytes[0];
+}
+
+// One frame of every payload type the firmware handles, between two nodes with fixed keys
+static void build_frames(void) {
+    uint8_t seed[32];
+    uint8_t pub_a[MESHCORE_PUB_KEY_SIZE], prv_a[64];
+    uint8_t pub_b[MESHCORE_PUB_KEY_SIZE], prv_b[64];
+    memset(seed, 0xA1, sizeof(seed));
+    ed25519_create_keypair(pub_a, prv_a, seed);
+    memset(seed, 0xB2, sizeof(seed));
+    ed25519_create_keypair(pub_b, prv_b, seed);
+
+    uint8_t shared_secret[MESHCORE_SHARED_SECRET_SIZE];
+    ed25519_key_exchange(shared_secret, pub_b, prv_a);
+    add_secret(shared_secret, sizeof(shared_secret));
+
+    meshcore_message_t message;
+
+    // Adverts: a chat node with a position flooded, a repeater to its neighbours
+    meshcore_self_advert_t self_advert;
+    meshcore_self_advert_init(&self_advert, pub_a, prv_a, MESHCORE_DEVICE_ROLE_CHAT_NODE, 0, 0);
+    meshcore_self_advert_set_name(&self_advert, "Tanmatsu");
+    meshcore_self_advert_set_position(&self_advert, true, 52370216, 4895168);
+    meshcore_self_advert_build(&self_advert, MESHCORE_ROUTE_TYPE_FLOOD, TIMESTAMP, 0, 0, &message);
+    add_frame(&message);
+    meshcore_self_advert_init(&self_advert, pub_b, prv_b, MESHCORE_DEVICE_ROLE_REPEATER, 0, 0);
+    meshcore_self_advert_set_name(&self_advert, "Repeater");
+    meshcore_self_advert_build(&self_advert, MESHCORE_ROUTE_TYPE_DIRECT, TIMESTAMP, 0, 0, &message);
+    add_frame(&message);
+
+    // Group text on the public channel, as sent and after two repeaters
+    const uint8_t* public_secret = secrets[0];
+    uint8_t        public_hash   = channel_hash(public_secret, MESHCORE_CIPHER_KEY_SIZE);
+    add_grp_txt(public_secret, public_hash, "Tanmatsu: Hello mesh", &message);
+    add_frame(&message);
+    meshcore_flood_prepare_forward(&message, 0x12);
+    meshcore_flood_prepare_forward(&message, 0x34);
+    add_frame(&message);
+
+    // Group text on a hashtag channel, scoped to a region
+    uint8_t hashtag_secret[MESHCORE_SHARED_SECRET_SIZE] = {0};
+    uint8_t hashtag_length = meshcore_channel_hashtag_secret(HASHTAG_CHANNEL, hashtag_secret);
+    add_secret(hashtag_secret, hashtag_length);
+    add_grp_txt(hashtag_secret, channel_hash(hashtag_secret, hashtag_length), "Repeater: test 1 2 3", &message);
+    meshcore_regions_t regions;
+    uint8_t            region_key[MESHCORE_TRANSPORT_KEY_SIZE];
+    meshcore_regions_init(&regions);
+    meshcore_region_hashtag_key(HASHTAG_REGION, region_key);
+    meshcore_transport_apply(meshcore_regions_add(&regions, HASHTAG_REGION, region_key), &message);
+    add_frame(&message);
+
+    // Group datagram on the public channel
+    static const uint8_t blob[] = {0xDE, 0xAD, 0xBE, 0xEF, 0x00, 0x01, 0x02, 0x03};
+    meshcore_grp_data_t  grp_data = {.channel_hash = public_hash};
+    uint8_t              length   = 0;
+    meshcore_grp_data_encode(TIMESTAMP, 0x01, blob, sizeof(blob), grp_data.data, sizeof(grp_data.data), &length);
+    meshcore_encrypt_then_mac(public_secret, MESHCORE_SHARED_SECRET_SIZE, grp_data.data, length,
+                              sizeof(grp_data.data), &grp_data.data_length, grp_data.mac);
+    memset(&message, 0, sizeof(message));
+    message.type  = MESHCORE_PAYLOAD_TYPE_GRP_DATA;
+    message.route = MESHCORE_ROUTE_TYPE_FLOOD;
+    meshcore_grp_data_serialize(&grp_data, message.payload, &message.payload_length);
+    add_frame(&message);
+
+    // Direct message along a known path, and its acknowledgement on the way back
+    meshcore_txt_msg_data_t txt_msg_data = {.timestamp = TIMESTAMP, .text_type = MESHCORE_TXT_TYPE_PLAIN, .attempt = 1};
+    snprintf(txt_msg_data.text, sizeof(txt_msg_data.text), "Hi there");
+    meshcore_txt_msg_t txt_msg = {.destination_hash = pub_b[0], .source_hash = pub_a[0]};
+    meshcore_txt_msg_data_serialize(&txt_msg_data, txt_msg.ciphertext, &length);
+    meshcore_encrypt_then_mac(shared_secret, sizeof(shared_secret), txt_msg.ciphertext, length,
+                              sizeof(txt_msg.ciphertext), &txt_msg.ciphertext_length, txt_msg.cipher_mac);
+    memset(&message, 0, sizeof(message));
+    message.type        = MESHCORE_PAYLOAD_TYPE_TXT_MSG;
+    message.route       = MESHCORE_ROUTE_TYPE_DIRECT;
+    message.path_length = 2;
+    message.path[0]     = 0x12;
+    message.path[1]     = 0x34;
+    meshcore_txt_msg_serialize(&txt_msg, message.payload, &message.payload_length);
+    add_frame(&message);
+
+    meshcore_ack_t ack = {.crc = 0x1D2C3B4A};
+    memset(&message, 0, sizeof(message));
+    message.type        = MESHCORE_PAYLOAD_TYPE_ACK;
+    message.route       = MESHCORE_ROUTE_TYPE_DIRECT;
+    message.path_length = 2;
+    message.path[0]     = 0x34;
+    message.path[1]     = 0x12;
+    meshcore_ack_serialize(&ack, message.payload, &message.payload_length);
+    add_frame(&message);
+
+    // Request with a timestamp and an opaque body
+    meshcore_request_t request = {.destination_hash = pub_b[0], .source_hash = pub_a[0]};
+    uint32_t           now     = TIMESTAMP;
+    memcpy(request.ciphertext, &now, sizeof(now));
+    memcpy(&request.ciphertext[sizeof(now)], blob, sizeof(blob));
+    meshcore_encrypt_then_mac(shared_secret, sizeof(shared_secret), request.ciphertext, sizeof(now) + sizeof(blob),
+                              sizeof(request.ciphertext), &request.ciphertext_length, request.ciphher_mac);
+    memset(&message, 0, sizeof(message));
+    message.type  = MESHCORE_PAYLOAD_TYPE_REQ;
+    message.route = MESHCORE_ROUTE_TYPE_FLOOD;
+    meshcore_request_serialize(&request, message.payload, &message.payload_length);
+    add_frame(&message);
+
+    // Round trip trace through three repeaters
+    static const uint8_t   hops[] = {0x12, 0x34, 0x56};
+    meshcore_path_tracer_t tracer;
+    meshcore_path_tracer_init(&tracer, pub_a[0], 0);
+    meshcore_path_trace_originate(&tracer, hops, sizeof(hops), true, 0, &message);
+    add_frame(&message);
+
+    // A payload of three fragments, and the resend request of a node that missed the second one
+    static meshcore_multipart_t sender, receiver;
+    static uint8_t              payload[400], reassembled[MESHCORE_MULTIPART_MAX_SIZE];
+    for (size_t i = 0; i < sizeof(payload); i++) {
+        payload[i] = (uint8_t)i;
+    }
+    meshcore_multipart_init(&sender, pub_a[0], 0);
+    meshcore_multipart_init(&receiver, pub_b[0], 0);
+    meshcore_multipart_send(&sender, MESHCORE_PAYLOAD_TYPE_RAW_CUSTOM, payload, sizeof(payload), 0);
+    for (size_t fragment = 0; meshcore_multipart_build(&sender, 0, &message) == 1; fragment++) {
+        add_frame(&message);
+        meshcore_multipart_result_t result;
+        if (fragment != 1) {
+            meshcore_multipart_receive(&receiver, &message, 0, reassembled, &result);
+        }
+    }
+    if (meshcore_multipart_build(&receiver, MESHCORE_MULTIPART_GAP_TIMEOUT, &message) == 1) {
+        add_frame(&message);
+    }
+}
+
+static bool write_capture(const char* filename) {
+    FILE* file = fopen(filename, "wb");
+    if (file == NULL) {
+        perror(filename);
+        return false;
+    }
+    capture_file_header_t header = {
+        .magic       = CAPTURE_MAGIC,
+        .version     = CAPTURE_VERSION,
+        .header_size = sizeof(capture_file_header_t),
+    };
+    fwrite(&header, sizeof(header), 1, file);
+    for (size_t i = 0; i < frame_count; i++) {
+        capture_record_header_t record = {
+            .timestamp = (int64_t)i * 1000000,
+            .rssi      = CAPTURE_RSSI_UNKNOWN,
+            .snr       = CAPTURE_SNR_UNKNOWN,
+            .flags     = CAPTURE_FLAG_TX,
+            .length    = frames[i].length,
+        };
+        fwrite(&record, sizeof(record), 1, file);
+        fwrite(frames[i].data, 1, frames[i].length, file);
+    }
+    if (fclose(file) != 0) {
+        perror(filename);
+        return false;
+    }
+    return true;
+}
+
+static void usage(const char* name) {
+    fprintf(stderr,
+            "Usage: %s [options] CORPUS_DIR [CAPTURE...]\n"
+            "  -k, --key HEX      channel key (32 hex digits) to decrypt group messages with, repeatable\n"
+            "  -w, --write FILE   write the frames built with the protocol code as a capture\n",
+            name);
+}
+
+int main(int argc, char** argv) {
+    static const struct option options[] = {
+        {"key", required_argument, NULL, 'k'},
+        {"write", required_argument, NULL, 'w'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+
+    add_channel_key(PUBLIC_SECRET);
+
+    const char* capture_out = NULL;
+    int         option;
+    while ((option = getopt_long(argc, argv, "k:w:h", options, NULL)) != -1) {
+        switch (option) {
+            case 'k':
+                if (!add_channel_key(optarg)) {
+                    fprintf(stderr, "Invalid channel key: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'w':
+                capture_out = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return option == 'h' ? 0 : 1;
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 1;
+    }
+    corpus_dir = argv[optind];
+    if (!make_directory(corpus_dir)) {
+        return 1;
+    }
+
+    build_frames();
+    if (capture_out != NULL && !write_capture(capture_out)) {
+        return 1;
+    }
+    for (size_t i = 0; i < frame_count; i++) {
+        if (!split_frame(frames[i].data, frames[i].length)) {
+            return 1;
+        }
+    }
+    for (int i = optind + 1; i < argc; i++) {
+        if (!split_capture(argv[i])) {
+            return 1;
+        }
+    }
+    if (multipart_length > 0 && !write_input("multipart", multipart_input, multipart_length)) {
+        return 1;
+    }
+
+    printf("%zu frames built, %zu inputs written to %s\n", frame_count, inputs, corpus_dir);
+    return 0;
+}
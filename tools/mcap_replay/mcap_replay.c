@@ -0,0 +1,319 @@
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+// Replays frame captures recorded by the firmware (/capture) through the MeshCore parser on the host. Frames are
+// loaded into memory first and then parsed back to back, so the run measures parser throughput and gives a
+// reproducible correctness check against real traffic.
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "capture_format.h"
+#include "meshcore/cipher.h"
+#include "meshcore/packet.h"
+#include "meshcore/payload/ack.h"
+#include "meshcore/payload/advert.h"
+#include "meshcore/payload/grp_txt.h"
+#include "meshcore/payload/request.h"
+#include "meshcore/payload/txt_msg.h"
+
+#define PAYLOAD_TYPES 16
+
+typedef struct {
+    capture_record_header_t header;
+    const uint8_t*          data;
+} frame_t;
+
+typedef struct {
+    uint64_t frames;
+    uint64_t bytes;
+    uint64_t packet_errors;   // Frames meshcore_deserialize rejected
+    uint64_t payload_errors;  // Packets whose payload could not be decoded
+    uint64_t decrypted;       // Group messages decrypted with one of the channel keys
+    uint64_t types[PAYLOAD_TYPES];
+} replay_stats_t;
+
+static uint8_t channel_keys[8][MESHCORE_SHARED_SECRET_SIZE];
+static size_t  channel_key_count = 0;
+static bool    verbose           = false;
+
+static const char* type_names[PAYLOAD_TYPES] = {
+    "REQ", "RESPONSE", "TXT_MSG", "ACK", "ADVERT", "GRP_TXT", "GRP_DATA", "ANON_REQ",
+    "PATH", "TRACE", "MULTIPART", "0xB", "0xC", "0xD", "0xE", "RAW_CUSTOM",
+};
+
+static bool add_channel_key(const char* hex) {
+    if (channel_key_count >= sizeof(channel_keys) / sizeof(channel_keys[0]) ||
+        strlen(hex) != MESHCORE_CIPHER_KEY_SIZE * 2) {
+        return false;
+    }
+    uint8_t* key = channel_keys[channel_key_count];
+    memset(key, 0, MESHCORE_SHARED_SECRET_SIZE);
+    for (size_t i = 0; i < MESHCORE_CIPHER_KEY_SIZE; i++) {
+        unsigned int value;
+        if (sscanf(&hex[i * 2], "%2x", &value) != 1) {
+            return false;
+        }
+        key[i] = value;
+    }
+    channel_key_count++;
+    return true;
+}
+
+static uint8_t* load_file(const char* filename, size_t* out_size) {
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL) {
+        perror(filename);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t* data = malloc(size > 0 ? size : 1);
+    if (data == NULL || fread(data, 1, size, file) != (size_t)size) {
+        fprintf(stderr, "%s: failed to read\n", filename);
+        free(data);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+    *out_size = size;
+    return data;
+}
+
+// Split a capture into frames, returns the number of frames or -1 when the file is not a capture
+static long index_frames(const char* filename, const uint8_t* data, size_t size, frame_t** frames,
+                         size_t* frame_capacity, size_t frame_count) {
+    capture_file_header_t header;
+    if (size < sizeof(header)) {
+        fprintf(stderr, "%s: too short for a capture\n", filename);
+        return -1;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != CAPTURE_MAGIC || header.header_size < sizeof(header) || header.header_size > size) {
+        fprintf(stderr, "%s: not a capture file\n", filename);
+        return -1;
+    }
+    if (header.version != CAPTURE_VERSION) {
+        fprintf(stderr, "%s: unsupported capture version %u\n", filename, header.version);
+        return -1;
+    }
+
+    size_t position = header.header_size;
+    long   count    = 0;
+    while (position + sizeof(capture_record_header_t) <= size) {
+        frame_t frame;
+        memcpy(&frame.header, &data[position], sizeof(frame.header));
+        position += sizeof(frame.header);
+        if (position + frame.header.length > size) {
+            fprintf(stderr, "%s: truncated record at offset %zu\n", filename, position - sizeof(frame.header));
+            break;
+        }
+        frame.data  = &data[position];
+        position   += frame.header.length;
+
+        if (frame_count + count >= *frame_capacity) {
+            *frame_capacity = *frame_capacity ? *frame_capacity * 2 : 1024;
+            *frames         = realloc(*frames, *frame_capacity * sizeof(frame_t));
+            if (*frames == NULL) {
+                fprintf(stderr, "Out of memory\n");
+                exit(1);
+            }
+        }
+        (*frames)[frame_count + count] = frame;
+        count++;
+    }
+    return count;
+}
+
+static void print_frame(const frame_t* frame, const meshcore_message_t* message, int result) {
+    printf("%12.6f %s", frame->header.timestamp / 1e6, frame->header.flags & CAPTURE_FLAG_TX ? "TX" : "RX");
+    if (frame->header.rssi != CAPTURE_RSSI_UNKNOWN) {
+        printf(" %4d dBm", frame->header.rssi);
+    }
+    if (frame->header.snr != CAPTURE_SNR_UNKNOWN) {
+        printf(" %5.2f dB", frame->header.snr / 4.0);
+    }
+    if (result < 0) {
+        printf(" malformed (%u bytes):", frame->header.length);
+        for (unsigned int i = 0; i < frame->header.length; i++) {
+            printf(" %02X", frame->data[i]);
+        }
+        printf("\n");
+        return;
+    }
+    printf(" %s route %d path %u payload %u\n", type_names[message->type & 0xF], message->route, message->path_length,
+           message->payload_length);
+}
+
+static bool decode_payload(meshcore_message_t* message, replay_stats_t* stats) {
+    union {
+        meshcore_advert_t  advert;
+        meshcore_grp_txt_t grp_txt;
+        meshcore_txt_msg_t txt_msg;
+        meshcore_ack_t     ack;
+        meshcore_request_t request;
+    } payload;
+    meshcore_grp_txt_data_t data;
+
+    switch (message->type) {
+        case MESHCORE_PAYLOAD_TYPE_ADVERT:
+            return meshcore_advert_deserialize(message->payload, message->payload_length, &payload.advert) >= 0;
+        case MESHCORE_PAYLOAD_TYPE_TXT_MSG:
+            return meshcore_txt_msg_deserialize(message->payload, message->payload_length, &payload.txt_msg) >= 0;
+        case MESHCORE_PAYLOAD_TYPE_ACK:
+            return meshcore_ack_deserialize(message->payload, message->payload_length, &payload.ack) >= 0;
+        case MESHCORE_PAYLOAD_TYPE_REQ:
+            return meshcore_request_deserialize(message->payload, message->payload_length, &payload.request) >= 0;
+        case MESHCORE_PAYLOAD_TYPE_GRP_TXT:
+            if (meshcore_grp_txt_deserialize(message->payload, message->payload_length, &payload.grp_txt) < 0) {
+                return false;
+            }
+            for (size_t i = 0; i < channel_key_count; i++) {
+                if (meshcore_mac_then_decrypt(channel_keys[i], MESHCORE_SHARED_SECRET_SIZE, payload.grp_txt.mac,
+                                              payload.grp_txt.data, payload.grp_txt.data_length) < 0) {
+                    continue;
+                }
+                stats->decrypted++;
+                if (meshcore_grp_txt_data_deserialize(payload.grp_txt.data, payload.grp_txt.data_length,
+                                                      &data) < 0) {
+                    return false;
+                }
+                if (verbose) {
+                    printf("             channel %zu: %s\n", i, data.text);
+                }
+                break;
+            }
+            return true;
+        default:
+            return true;
+    }
+}
+
+static void replay(const frame_t* frames, size_t count, replay_stats_t* stats) {
+    for (size_t i = 0; i < count; i++) {
+        const frame_t*     frame = &frames[i];
+        uint8_t            raw[CAPTURE_MAX_FRAME_SIZE];
+        meshcore_message_t message;
+
+        // The parser takes a mutable buffer, like the packet buffers on the device
+        memcpy(raw, frame->data, frame->header.length);
+        stats->frames++;
+        stats->bytes += frame->header.length;
+
+        int result = meshcore_deserialize(raw, frame->header.length, &message);
+        if (verbose) {
+            print_frame(frame, &message, result);
+        }
+        if (result < 0) {
+            stats->packet_errors++;
+            continue;
+        }
+        stats->types[message.type & 0xF]++;
+        if (!decode_payload(&message, stats)) {
+            stats->payload_errors++;
+        }
+    }
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void usage(const char* name) {
+    fprintf(stderr,
+            "Usage: %s [options] capture...\n"
+            "  -k, --key HEX      channel key (32 hex digits) to decrypt group messages with, repeatable\n"
+            "  -n, --repeat N     timed passes over the captures (default 1)\n"
+            "  -v, --verbose      print every frame\n",
+            name);
+}
+
+int main(int argc, char** argv) {
+    unsigned long repeat = 1;
+
+    static const struct option options[] = {
+        {"key", required_argument, NULL, 'k'},
+        {"repeat", required_argument, NULL, 'n'},
+        {"verbose", no_argument, NULL, 'v'},
+        {NULL, 0, NULL, 0},
+    };
+
+    add_channel_key("8b3387e9c5cdea6ac9e5edbaa115cd72");  // Public channel
+
+    int option;
+    while ((option = getopt_long(argc, argv, "k:n:vh", options, NULL)) != -1) {
+        switch (option) {
+            case 'k':
+                if (!add_channel_key(optarg)) {
+                    fprintf(stderr, "Invalid channel key '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'n':
+                repeat = strtoul(optarg, NULL, 0);
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind >= argc || repeat == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    frame_t* frames         = NULL;
+    size_t   frame_capacity = 0;
+    size_t   frame_count    = 0;
+    for (int i = optind; i < argc; i++) {
+        size_t   size;
+        uint8_t* data = load_file(argv[i], &size);
+        if (data == NULL) {
+            return 1;
+        }
+        long count = index_frames(argv[i], data, size, &frames, &frame_capacity, frame_count);
+        if (count < 0) {
+            return 1;
+        }
+        frame_count += count;  // The file stays loaded, frames point into it
+    }
+
+    // The first pass collects the statistics (and prints), the timed passes run quietly
+    replay_stats_t stats = {0};
+    replay(frames, frame_count, &stats);
+
+    verbose      = false;
+    double start = now_seconds();
+    for (unsigned long i = 0; i < repeat; i++) {
+        replay_stats_t timing_stats = {0};
+        replay(frames, frame_count, &timing_stats);
+    }
+    double elapsed = now_seconds() - start;
+
+    printf("Frames:         %" PRIu64 " (%" PRIu64 " bytes)\n", stats.frames, stats.bytes);
+    printf("Malformed:      %" PRIu64 " packets, %" PRIu64 " payloads\n", stats.packet_errors, stats.payload_errors);
+    printf("Decrypted:      %" PRIu64 " group messages\n", stats.decrypted);
+    for (size_t i = 0; i < PAYLOAD_TYPES; i++) {
+        if (stats.types[i] > 0) {
+            printf("  %-12s  %" PRIu64 "\n", type_names[i], stats.types[i]);
+        }
+    }
+    if (frame_count > 0 && elapsed > 0) {
+        double frames_parsed = (double)frame_count * repeat;
+        printf("Throughput:     %.0f frames/s, %.0f ns per frame over %lu passes\n", frames_parsed / elapsed,
+               elapsed * 1e9 / frames_parsed, repeat);
+    }
+
+    return stats.packet_errors > 0 || stats.payload_errors > 0 ? 2 : 0;
+}
@@ -0,0 +1,914 @@
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+// Discrete-event simulator for MeshCore flood routing. Every virtual node runs the packet, cipher and flood code from
+// main/meshcore against a modeled LoRa channel: time-on-air from SF/BW/CR, half-duplex radios, collisions with
+// capture, and SNR dependent loss. Reports flood amplification, delivery ratio, latency and airtime. With --multipart
+// the clients exchange payloads split by main/meshcore/multipart.c instead of channel messages.
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "capture_format.h"
+#include "crypto/sha256.h"
+#include "meshcore/cipher.h"
+#include "meshcore/flood.h"
+#include "meshcore/multipart.h"
+#include "meshcore/packet.h"
+#include "meshcore/payload/grp_txt.h"
+
+#define CAPTURE_THRESHOLD_DB 6.0   // A frame survives an overlapping one when it is this much stronger
+#define LOSS_SLOPE           2.0   // Steepness of the reception probability around the demodulation floor
+#define LINK_MARGIN_DB       5.0   // Links weaker than the demodulation floor minus this margin are not modeled
+#define PATH_LOSS_EXPONENT   3.0   // Log-distance path loss exponent for generated topologies
+#define SNR_AT_1KM_DB        0.0   // SNR at 1 km for generated topologies
+#define CAD_SYMBOLS          4     // Symbols of a preamble needed before channel activity detection sees a frame
+#define CHANNEL_SECRET       "8b3387e9c5cdea6ac9e5edbaa115cd72"  // Public channel key
+
+typedef enum {
+    EVENT_ORIGINATE,
+    EVENT_TX_START,
+    EVENT_TX_END,
+    EVENT_MULTIPART,  // The fragmentation state of a node has something to send or a timer ran out
+} event_type_t;
+
+typedef struct {
+    int64_t      time;  // Microseconds since the start of the simulation
+    uint64_t     sequence;
+    event_type_t type;
+    int          node;
+    int          transmission;  // Generation of the wake for EVENT_MULTIPART
+} event_t;
+
+typedef struct {
+    int    peer;
+    double snr;
+} link_t;
+
+typedef struct {
+    int  transmission;
+    bool corrupted;
+} reception_t;
+
+typedef struct {
+    bool                  repeater;
+    uint8_t               hash;
+    link_t*               links;
+    size_t                link_count;
+    size_t                link_capacity;
+    reception_t*          receptions;  // Frames currently arriving at this node
+    size_t                reception_count;
+    size_t                reception_capacity;
+    int64_t               transmitting_until;
+    meshcore_flood_t      flood;
+    uint8_t*              delivered;             // Per message, set once the node received it
+    meshcore_multipart_t* multipart;             // Clients only, when payloads are sent in fragments
+    int64_t               multipart_wake;        // Pending wake, INT64_MAX when there is none
+    int64_t               multipart_paced;       // No frame is built before this time
+    int                   multipart_generation;  // Wakes of older generations were superseded
+} node_t;
+
+typedef struct {
+    int     sender;
+    int     message;
+    int64_t start;
+    int64_t end;
+    uint8_t data[MESHCORE_MAX_TRANS_UNIT];
+    uint8_t length;
+} transmission_t;
+
+typedef struct {
+    int     origin;
+    int64_t created;
+    int     delivered;
+    uint8_t sequence;  // Multipart sequence number
+} message_t;
+
+typedef struct {
+    int    sf;
+    double bw;
+    int    cr;  // 1..4 for 4/5..4/8
+    int    preamble;
+    double delay_factor;
+} radio_t;
+
+static struct {
+    node_t*         nodes;
+    int             node_count;
+    transmission_t* transmissions;
+    size_t          transmission_count;
+    size_t          transmission_capacity;
+    message_t*      messages;
+    int             message_count;
+    event_t*        events;
+    size_t          event_count;
+    size_t          event_capacity;
+    uint64_t        event_sequence;
+    int64_t         now;
+    radio_t         radio;
+    uint64_t        random_state;
+    uint8_t         channel_secret[MESHCORE_SHARED_SECRET_SIZE];
+    uint8_t         channel_hash;
+    FILE*           capture;         // Frames heard and sent by node 0, in the firmware capture format
+    size_t          multipart_size;  // Payload size in bytes, 0 for channel messages
+
+    // Statistics
+    uint64_t transmitted;
+    uint64_t forwarded;
+    uint64_t received;
+    uint64_t duplicates;
+    uint64_t collisions;
+    uint64_t half_duplex_losses;
+    uint64_t snr_losses;
+    uint64_t backoffs;
+    uint64_t decrypt_failures;
+    int64_t  airtime;
+    uint64_t multipart_duplicates;  // Payloads handed to a client more than once
+    uint64_t multipart_unsent;      // Payloads the origin had no room for
+    int64_t* latencies;
+    size_t   latency_count;
+    size_t   latency_capacity;
+} sim;
+
+// Random numbers (xorshift64*), seeded for reproducible runs
+
+static uint64_t random_next(void) {
+    sim.random_state ^= sim.random_state >> 12;
+    sim.random_state ^= sim.random_state << 25;
+    sim.random_state ^= sim.random_state >> 27;
+    return sim.random_state * 2685821657736338717ULL;
+}
+
+static double random_uniform(void) {
+    return (random_next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void* grow(void* array, size_t* capacity, size_t needed, size_t element_size) {
+    if (needed <= *capacity) {
+        return array;
+    }
+    size_t new_capacity = *capacity ? *capacity * 2 : 16;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+    array = realloc(array, new_capacity * element_size);
+    if (array == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    *capacity = new_capacity;
+    return array;
+}
+
+// Event queue (binary min-heap on time, ties in scheduling order)
+
+static bool event_before(const event_t* a, const event_t* b) {
+    return a->time < b->time || (a->time == b->time && a->sequence < b->sequence);
+}
+
+static void schedule(int64_t time, event_type_t type, int node, int transmission) {
+    sim.events = grow(sim.events, &sim.event_capacity, sim.event_count + 1, sizeof(event_t));
+    event_t event = {
+        .time         = time,
+        .sequence     = sim.event_sequence++,
+        .type         = type,
+        .node         = node,
+        .transmission = transmission,
+    };
+    size_t index = sim.event_count++;
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (!event_before(&event, &sim.events[parent])) {
+            break;
+        }
+        sim.events[index] = sim.events[parent];
+        index             = parent;
+    }
+    sim.events[index] = event;
+}
+
+static bool next_event(event_t* out_event) {
+    if (sim.event_count == 0) {
+        return false;
+    }
+    *out_event    = sim.events[0];
+    event_t last  = sim.events[--sim.event_count];
+    size_t  index = 0;
+    while (1) {
+        size_t child = index * 2 + 1;
+        if (child >= sim.event_count) {
+            break;
+        }
+        if (child + 1 < sim.event_count && event_before(&sim.events[child + 1], &sim.events[child])) {
+            child++;
+        }
+        if (!event_before(&sim.events[child], &last)) {
+            break;
+        }
+        sim.events[index] = sim.events[child];
+        index             = child;
+    }
+    if (sim.event_count > 0) {
+        sim.events[index] = last;
+    }
+    return true;
+}
+
+// LoRa channel model
+
+static int64_t airtime_us(int length) {
+    double symbol = (double)(1 << sim.radio.sf) / sim.radio.bw * 1e6;
+    int    de     = symbol > 16000.0 ? 1 : 0;  // Low data rate optimization
+    double bits   = 8.0 * length - 4.0 * sim.radio.sf + 28.0 + 16.0;  // Explicit header, CRC enabled
+    double blocks = ceil(bits / (4.0 * (sim.radio.sf - 2 * de)));
+    double symbols = 8.0 + fmax(blocks * (sim.radio.cr + 4), 0.0);
+    return (int64_t)((sim.radio.preamble + 4.25) * symbol + symbols * symbol);
+}
+
+static double demodulation_floor(void) {
+    // Minimum SNR for SF7..SF12
+    static const double floors[] = {-7.5, -10.0, -12.5, -15.0, -17.5, -20.0};
+    int                 index    = sim.radio.sf - 7;
+    if (index < 0) {
+        index = 0;
+    }
+    if (index > 5) {
+        index = 5;
+    }
+    return floors[index];
+}
+
+static double link_snr(int receiver, int transmitter) {
+    node_t* node = &sim.nodes[receiver];
+    for (size_t i = 0; i < node->link_count; i++) {
+        if (node->links[i].peer == transmitter) {
+            return node->links[i].snr;
+        }
+    }
+    return -INFINITY;
+}
+
+// Topology
+
+static void add_link(int a, int b, double snr) {
+    node_t* nodes[2] = {&sim.nodes[a], &sim.nodes[b]};
+    int     peers[2] = {b, a};
+    for (int i = 0; i < 2; i++) {
+        nodes[i]->links = grow(nodes[i]->links, &nodes[i]->link_capacity, nodes[i]->link_count + 1, sizeof(link_t));
+        nodes[i]->links[nodes[i]->link_count++] = (link_t){.peer = peers[i], .snr = snr};
+    }
+}
+
+static void create_nodes(int count) {
+    sim.node_count = count;
+    sim.nodes      = calloc(count, sizeof(node_t));
+    if (sim.nodes == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    for (int i = 0; i < count; i++) {
+        sim.nodes[i].repeater = true;
+        sim.nodes[i].hash     = random_next() & 0xFF;  // Path hashes are one byte, collisions are part of the model
+        meshcore_flood_init(&sim.nodes[i].flood);
+    }
+}
+
+// Topology file: "nodes <count>", "client <id>" and "link <a> <b> <snr dB>" lines, '#' starts a comment
+static bool load_topology(const char* filename) {
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) {
+        perror(filename);
+        return false;
+    }
+    char line[256];
+    int  line_number = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line_number++;
+        char* comment = strchr(line, '#');
+        if (comment != NULL) {
+            *comment = '\0';
+        }
+        int    a, b;
+        double snr;
+        if (sscanf(line, " nodes %d", &a) == 1 && sim.nodes == NULL && a > 1) {
+            create_nodes(a);
+        } else if (sscanf(line, " client %d", &a) == 1 && sim.nodes != NULL && a >= 0 && a < sim.node_count) {
+            sim.nodes[a].repeater = false;
+        } else if (sscanf(line, " link %d %d %lf", &a, &b, &snr) == 3 && sim.nodes != NULL && a >= 0 &&
+                   a < sim.node_count && b >= 0 && b < sim.node_count && a != b) {
+            add_link(a, b, snr);
+        } else if (strspn(line, " \t\r\n") != strlen(line)) {
+            fprintf(stderr, "%s:%d: invalid line\n", filename, line_number);
+            fclose(file);
+            return false;
+        }
+    }
+    fclose(file);
+    if (sim.nodes == NULL) {
+        fprintf(stderr, "%s: missing nodes line\n", filename);
+        return false;
+    }
+    return true;
+}
+
+// Random geometric topology with log-distance path loss, on average 'density' nodes per square km
+static void generate_topology(int count, double density, double client_fraction) {
+    create_nodes(count);
+    double  side = sqrt(count / density);
+    double* x    = malloc(count * sizeof(double));
+    double* y    = malloc(count * sizeof(double));
+    for (int i = 0; i < count; i++) {
+        x[i]                  = random_uniform() * side;
+        y[i]                  = random_uniform() * side;
+        sim.nodes[i].repeater = random_uniform() >= client_fraction;
+    }
+    double floor = demodulation_floor() - LINK_MARGIN_DB;
+    for (int a = 0; a < count; a++) {
+        for (int b = a + 1; b < count; b++) {
+            double distance = fmax(hypot(x[a] - x[b], y[a] - y[b]), 0.01);
+            double snr      = SNR_AT_1KM_DB - 10.0 * PATH_LOSS_EXPONENT * log10(distance);
+            if (snr >= floor) {
+                add_link(a, b, snr);
+            }
+        }
+    }
+    free(x);
+    free(y);
+}
+
+// Node behaviour
+
+static int new_transmission(int sender, int message, const meshcore_message_t* packet) {
+    sim.transmissions = grow(sim.transmissions, &sim.transmission_capacity, sim.transmission_count + 1,
+                             sizeof(transmission_t));
+    transmission_t* transmission = &sim.transmissions[sim.transmission_count];
+    memset(transmission, 0, sizeof(transmission_t));
+    transmission->sender  = sender;
+    transmission->message = message;
+    if (meshcore_serialize(packet, transmission->data, &transmission->length) < 0) {
+        fprintf(stderr, "Failed to serialize packet\n");
+        exit(1);
+    }
+    return sim.transmission_count++;
+}
+
+static void record_latency(int64_t latency) {
+    sim.latencies = grow(sim.latencies, &sim.latency_capacity, sim.latency_count + 1, sizeof(int64_t));
+    sim.latencies[sim.latency_count++] = latency;
+}
+
+// Multipart payloads, the fragmentation state runs on a millisecond clock like in the firmware
+
+static void multipart_schedule(int node_index) {
+    node_t* node = &sim.nodes[node_index];
+    int64_t due  = meshcore_multipart_due(node->multipart, sim.now / 1000);
+    if (due < 0) {
+        return;
+    }
+    int64_t time = sim.now + due * 1000;
+    if (time < node->multipart_paced) {
+        time = node->multipart_paced;
+    }
+    if (node->multipart_wake <= time) {
+        return;
+    }
+    node->multipart_wake = time;
+    schedule(time, EVENT_MULTIPART, node_index, ++node->multipart_generation);
+}
+
+static void multipart_wake(int node_index, int generation) {
+    node_t* node = &sim.nodes[node_index];
+    if (generation != node->multipart_generation) {
+        return;
+    }
+    node->multipart_wake = INT64_MAX;
+
+    meshcore_message_t packet;
+    if (meshcore_multipart_build(node->multipart, sim.now / 1000, &packet) == 1) {
+        int transmission = new_transmission(node_index, -1, &packet);
+        schedule(sim.now, EVENT_TX_START, node_index, transmission);
+        // One frame per airtime, the firmware queues them behind each other as well
+        node->multipart_paced = sim.now + airtime_us(sim.transmissions[transmission].length);
+    }
+    multipart_schedule(node_index);
+}
+
+static void multipart_receive(int node_index, const meshcore_message_t* packet) {
+    static uint8_t data[MESHCORE_MULTIPART_MAX_SIZE];
+
+    node_t*                     node = &sim.nodes[node_index];
+    meshcore_multipart_result_t result;
+    if (meshcore_multipart_receive(node->multipart, packet, sim.now / 1000, data, &result) == 1) {
+        for (int i = 0; i < sim.message_count; i++) {
+            message_t* message = &sim.messages[i];
+            if (!sim.nodes[message->origin].delivered[i] || sim.nodes[message->origin].hash != result.source ||
+                message->sequence != result.sequence) {
+                continue;
+            }
+            if (node->delivered[i]) {
+                sim.multipart_duplicates++;
+            } else {
+                node->delivered[i] = 1;
+                message->delivered++;
+                record_latency(sim.now - message->created);
+            }
+            break;
+        }
+    }
+    multipart_schedule(node_index);
+}
+
+static void originate_multipart(int node, int message) {
+    uint8_t data[MESHCORE_MULTIPART_MAX_SIZE];
+    for (size_t i = 0; i < sim.multipart_size; i++) {
+        data[i] = random_next() & 0xFF;
+    }
+    int sequence = meshcore_multipart_send(sim.nodes[node].multipart, MESHCORE_PAYLOAD_TYPE_RAW_CUSTOM, data,
+                                           sim.multipart_size, sim.now / 1000);
+    if (sequence < 0) {
+        sim.multipart_unsent++;
+        return;
+    }
+    sim.nodes[node].delivered[message] = 1;
+    sim.messages[message].sequence     = sequence;
+    sim.messages[message].created      = sim.now;
+    multipart_schedule(node);
+}
+
+static void originate(int node, int message) {
+    if (sim.multipart_size > 0) {
+        originate_multipart(node, message);
+        return;
+    }
+
+    meshcore_grp_txt_data_t data = {
+        .timestamp = (uint32_t)(sim.now / 1000000),
+        .text_type = 0,
+    };
+    snprintf(data.text, sizeof(data.text), "node%d: simulated message %d", node, message);
+
+    meshcore_grp_txt_t grp_txt = {.channel_hash = sim.channel_hash};
+    uint8_t            length  = 0;
+    if (meshcore_grp_txt_data_serialize(&data, grp_txt.data, &length) < 0 ||
+        meshcore_encrypt_then_mac(sim.channel_secret, sizeof(sim.channel_secret), grp_txt.data, length,
+                                  sizeof(grp_txt.data), &grp_txt.data_length, grp_txt.mac) < 0) {
+        fprintf(stderr, "Failed to build message\n");
+        exit(1);
+    }
+
+    meshcore_message_t packet = {
+        .type  = MESHCORE_PAYLOAD_TYPE_GRP_TXT,
+        .route = MESHCORE_ROUTE_TYPE_FLOOD,
+    };
+    meshcore_grp_txt_serialize(&grp_txt, packet.payload, &packet.payload_length);
+
+    uint8_t hash[MESHCORE_PACKET_HASH_SIZE];
+    meshcore_packet_hash(&packet, hash);
+    meshcore_flood_check_seen(&sim.nodes[node].flood, hash);
+    sim.nodes[node].delivered[message] = 1;
+    sim.messages[message].created      = sim.now;
+
+    schedule(sim.now, EVENT_TX_START, node, new_transmission(node, message, &packet));
+}
+
+static void capture_frame(const transmission_t* transmission, double snr, bool transmitted) {
+    if (sim.capture == NULL) {
+        return;
+    }
+    capture_record_header_t header = {
+        .timestamp = sim.now,
+        .rssi      = CAPTURE_RSSI_UNKNOWN,
+        .snr       = transmitted ? CAPTURE_SNR_UNKNOWN : (int8_t)fmax(fmin(snr * 4, INT8_MAX), INT8_MIN + 1),
+        .flags     = transmitted ? CAPTURE_FLAG_TX : 0,
+        .length    = transmission->length,
+    };
+    fwrite(&header, sizeof(header), 1, sim.capture);
+    fwrite(transmission->data, 1, transmission->length, sim.capture);
+}
+
+static void receive(int node_index, int transmission_index) {
+    node_t*         node         = &sim.nodes[node_index];
+    transmission_t* transmission = &sim.transmissions[transmission_index];
+
+    if (node_index == 0) {
+        capture_frame(transmission, link_snr(0, transmission->sender), false);
+    }
+
+    meshcore_message_t packet;
+    if (meshcore_deserialize(transmission->data, transmission->length, &packet) < 0) {
+        return;
+    }
+    sim.received++;
+
+    // Clients keep no table of seen packets, every copy reaches their fragmentation state
+    if (node->multipart != NULL && packet.type == MESHCORE_PAYLOAD_TYPE_MULTIPART) {
+        multipart_receive(node_index, &packet);
+    }
+
+    uint8_t hash[MESHCORE_PACKET_HASH_SIZE];
+    meshcore_packet_hash(&packet, hash);
+    if (meshcore_flood_check_seen(&node->flood, hash)) {
+        sim.duplicates++;
+        return;
+    }
+
+    meshcore_grp_txt_t grp_txt;
+    if (packet.type == MESHCORE_PAYLOAD_TYPE_GRP_TXT &&
+        meshcore_grp_txt_deserialize(packet.payload, packet.payload_length, &grp_txt) == 0) {
+        if (meshcore_mac_then_decrypt(sim.channel_secret, sizeof(sim.channel_secret), grp_txt.mac, grp_txt.data,
+                                      grp_txt.data_length) < 0) {
+            sim.decrypt_failures++;
+        } else if (!node->delivered[transmission->message]) {
+            node->delivered[transmission->message] = 1;
+            sim.messages[transmission->message].delivered++;
+            record_latency(sim.now - sim.messages[transmission->message].created);
+        }
+    }
+
+    if (node->repeater && meshcore_flood_prepare_forward(&packet, node->hash) == 0) {
+        int     forward = new_transmission(node_index, transmission->message, &packet);
+        int64_t delay   = (int64_t)(random_uniform() * 5.0 * sim.radio.delay_factor *
+                                  airtime_us(sim.transmissions[forward].length) / 2.0);
+        sim.forwarded++;
+        schedule(sim.now + delay, EVENT_TX_START, node_index, forward);
+    }
+}
+
+static int64_t symbol_us(void) {
+    return (int64_t)((double)(1 << sim.radio.sf) / sim.radio.bw * 1e6);
+}
+
+// Channel activity detection only notices a frame once part of its preamble has been on the air
+static bool channel_busy(const node_t* node) {
+    for (size_t i = 0; i < node->reception_count; i++) {
+        if (sim.transmissions[node->receptions[i].transmission].start + CAD_SYMBOLS * symbol_us() <= sim.now) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void remove_reception(node_t* node, size_t index) {
+    node->receptions[index] = node->receptions[--node->reception_count];
+}
+
+static void start_transmission(int node_index, int transmission_index) {
+    node_t*         node         = &sim.nodes[node_index];
+    transmission_t* transmission = &sim.transmissions[transmission_index];
+    int64_t         duration     = airtime_us(transmission->length);
+
+    // Listen before talk, back off while the channel is busy or we are still sending
+    if (channel_busy(node) || node->transmitting_until > sim.now) {
+        sim.backoffs++;
+        schedule(sim.now + (int64_t)(random_uniform() * duration) + 1, EVENT_TX_START, node_index, transmission_index);
+        return;
+    }
+
+    transmission->start      = sim.now;
+    transmission->end        = sim.now + duration;
+    node->transmitting_until = transmission->end;
+    sim.transmitted++;
+    if (node_index == 0) {
+        capture_frame(transmission, 0, true);
+    }
+    sim.airtime += duration;
+
+    // Half duplex, whatever was still arriving at the sender is lost
+    for (size_t i = 0; i < node->reception_count; i++) {
+        if (!node->receptions[i].corrupted) {
+            node->receptions[i].corrupted = true;
+            sim.half_duplex_losses++;
+        }
+    }
+
+    for (size_t i = 0; i < node->link_count; i++) {
+        node_t* peer = &sim.nodes[node->links[i].peer];
+        if (peer->transmitting_until > sim.now) {
+            sim.half_duplex_losses++;
+            continue;
+        }
+
+        bool   corrupted = false;
+        double snr       = node->links[i].snr;
+        for (size_t j = 0; j < peer->reception_count; j++) {
+            reception_t* other     = &peer->receptions[j];
+            double       other_snr = link_snr(node->links[i].peer, sim.transmissions[other->transmission].sender);
+            if (other_snr < snr + CAPTURE_THRESHOLD_DB && !other->corrupted) {
+                other->corrupted = true;
+                sim.collisions++;
+            }
+            if (snr < other_snr + CAPTURE_THRESHOLD_DB) {
+                corrupted = true;
+            }
+        }
+        if (corrupted) {
+            sim.collisions++;
+        }
+
+        peer->receptions = grow(peer->receptions, &peer->reception_capacity, peer->reception_count + 1,
+                                sizeof(reception_t));
+        peer->receptions[peer->reception_count++] = (reception_t){
+            .transmission = transmission_index,
+            .corrupted    = corrupted,
+        };
+    }
+
+    schedule(transmission->end, EVENT_TX_END, node_index, transmission_index);
+}
+
+static void end_transmission(int node_index, int transmission_index) {
+    node_t* node = &sim.nodes[node_index];
+
+    for (size_t i = 0; i < node->link_count; i++) {
+        int     peer_index = node->links[i].peer;
+        node_t* peer       = &sim.nodes[peer_index];
+        for (size_t j = 0; j < peer->reception_count; j++) {
+            if (peer->receptions[j].transmission != transmission_index) {
+                continue;
+            }
+            bool corrupted = peer->receptions[j].corrupted;
+            remove_reception(peer, j);
+            if (corrupted) {
+                break;
+            }
+            double margin      = node->links[i].snr - demodulation_floor();
+            double probability = 1.0 / (1.0 + exp(-LOSS_SLOPE * margin));
+            if (random_uniform() < probability) {
+                receive(peer_index, transmission_index);
+            } else {
+                sim.snr_losses++;
+            }
+            break;
+        }
+    }
+}
+
+static int compare_int64(const void* a, const void* b) {
+    int64_t x = *(const int64_t*)a;
+    int64_t y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void report(void) {
+    int    repeaters = 0;
+    size_t links     = 0;
+    for (int i = 0; i < sim.node_count; i++) {
+        repeaters += sim.nodes[i].repeater ? 1 : 0;
+        links     += sim.nodes[i].link_count;
+    }
+
+    // Multipart payloads are only for the clients, the repeaters just forward their fragments
+    int    receivers = (sim.multipart_size > 0 ? sim.node_count - repeaters : sim.node_count) - 1;
+    double delivery  = 0;
+    for (int i = 0; i < sim.message_count; i++) {
+        delivery += (double)sim.messages[i].delivered / receivers;
+    }
+
+    printf("Nodes:               %d (%d repeaters), %.1f neighbours on average\n", sim.node_count, repeaters,
+           (double)links / sim.node_count);
+    printf("Radio:               SF%d, %.1f kHz, CR 4/%d, %d symbol preamble\n", sim.radio.sf, sim.radio.bw / 1000,
+           sim.radio.cr + 4, sim.radio.preamble);
+    printf("Messages:            %d\n", sim.message_count);
+    printf("Delivery ratio:      %.2f%%\n", sim.message_count ? 100.0 * delivery / sim.message_count : 0.0);
+    printf("Transmissions:       %" PRIu64 " (%.1f per message, %" PRIu64 " forwards)\n", sim.transmitted,
+           sim.message_count ? (double)sim.transmitted / sim.message_count : 0.0, sim.forwarded);
+    printf("Airtime:             %.1f s total, %.2f%% per node over %.1f s\n", sim.airtime / 1e6,
+           sim.now ? 100.0 * sim.airtime / sim.now / sim.node_count : 0.0, sim.now / 1e6);
+    printf("Receptions:          %" PRIu64 " (%" PRIu64 " duplicates)\n", sim.received, sim.duplicates);
+    printf("Losses:              %" PRIu64 " collisions, %" PRIu64 " half duplex, %" PRIu64 " below noise floor\n",
+           sim.collisions, sim.half_duplex_losses, sim.snr_losses);
+    printf("Backoffs:            %" PRIu64 "\n", sim.backoffs);
+    if (sim.decrypt_failures > 0) {
+        printf("Decrypt failures:    %" PRIu64 "\n", sim.decrypt_failures);
+    }
+    if (sim.multipart_size > 0) {
+        meshcore_multipart_stats_t total = {0};
+        for (int i = 0; i < sim.node_count; i++) {
+            if (sim.nodes[i].multipart != NULL) {
+                total.completed      += sim.nodes[i].multipart->stats.completed;
+                total.expired        += sim.nodes[i].multipart->stats.expired;
+                total.requests_sent  += sim.nodes[i].multipart->stats.requests_sent;
+                total.requests_held  += sim.nodes[i].multipart->stats.requests_held;
+                total.late_fragments += sim.nodes[i].multipart->stats.late_fragments;
+            }
+        }
+        printf("Multipart:           %zu bytes, %" PRIu32 " reassembled (%" PRIu64 " twice), %" PRIu32
+               " given up, %" PRIu64 " unsent\n",
+               sim.multipart_size, total.completed, sim.multipart_duplicates, total.expired, sim.multipart_unsent);
+        printf("Resend requests:     %" PRIu32 " sent, %" PRIu32 " held, %" PRIu32 " late fragments dropped\n",
+               total.requests_sent, total.requests_held, total.late_fragments);
+    }
+
+    if (sim.latency_count > 0) {
+        qsort(sim.latencies, sim.latency_count, sizeof(int64_t), compare_int64);
+        double total = 0;
+        for (size_t i = 0; i < sim.latency_count; i++) {
+            total += sim.latencies[i];
+        }
+        printf("Latency:             mean %.0f ms, p50 %.0f ms, p95 %.0f ms, max %.0f ms\n",
+               total / sim.latency_count / 1000, sim.latencies[sim.latency_count / 2] / 1000.0,
+               sim.latencies[sim.latency_count * 95 / 100] / 1000.0, sim.latencies[sim.latency_count - 1] / 1000.0);
+    }
+}
+
+static void usage(const char* name) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -t, --topology FILE   load nodes and links from a topology file\n"
+            "  -n, --nodes N         generate a random topology with N nodes (default 100)\n"
+            "  -d, --density D       nodes per square km for generated topologies (default 1)\n"
+            "  -c, --clients F       fraction of generated nodes that do not repeat (default 0)\n"
+            "  -m, --messages M      messages to originate (default 20)\n"
+            "  -i, --interval S      seconds between messages (default 30)\n"
+            "  -s, --sf SF           spreading factor (default 8)\n"
+            "  -b, --bw KHZ          bandwidth in kHz (default 62.5)\n"
+            "  -r, --cr CR           coding rate denominator 5..8 (default 8)\n"
+            "  -p, --preamble N      preamble length in symbols (default 16)\n"
+            "  -f, --delay-factor F  retransmit delay factor (default 1.0)\n"
+            "  -S, --seed N          random seed (default 1)\n"
+            "  -C, --capture FILE    record what node 0 hears and sends, for tools/mcap_replay\n"
+            "  -M, --multipart N     clients exchange N byte payloads in fragments (default 0, channel messages)\n",
+            name);
+}
+
+int main(int argc, char** argv) {
+    const char* topology        = NULL;
+    const char* capture         = NULL;
+    int         node_count      = 100;
+    double      density         = 2.0;
+    double      client_fraction = 0.0;
+    double      interval        = 30.0;
+    uint64_t    seed            = 1;
+
+    sim.message_count      = 20;
+    sim.radio.sf           = 8;
+    sim.radio.bw           = 62500;
+    sim.radio.cr           = 4;
+    sim.radio.preamble     = 16;
+    sim.radio.delay_factor = 1.0;
+
+    static const struct option options[] = {
+        {"topology", required_argument, NULL, 't'},
+        {"nodes", required_argument, NULL, 'n'},
+        {"density", required_argument, NULL, 'd'},
+        {"clients", required_argument, NULL, 'c'},
+        {"messages", required_argument, NULL, 'm'},
+        {"interval", required_argument, NULL, 'i'},
+        {"sf", required_argument, NULL, 's'},
+        {"bw", required_argument, NULL, 'b'},
+        {"cr", required_argument, NULL, 'r'},
+        {"preamble", required_argument, NULL, 'p'},
+        {"delay-factor", required_argument, NULL, 'f'},
+        {"seed", required_argument, NULL, 'S'},
+        {"capture", required_argument, NULL, 'C'},
+        {"multipart", required_argument, NULL, 'M'},
+        {NULL, 0, NULL, 0},
+    };
+
+    int option;
+    while ((option = getopt_long(argc, argv, "t:n:d:c:m:i:s:b:r:p:f:S:C:M:h", options, NULL)) != -1) {
+        switch (option) {
+            case 't':
+                topology = optarg;
+                break;
+            case 'n':
+                node_count = atoi(optarg);
+                break;
+            case 'd':
+                density = atof(optarg);
+                break;
+            case 'c':
+                client_fraction = atof(optarg);
+                break;
+            case 'm':
+                sim.message_count = atoi(optarg);
+                break;
+            case 'i':
+                interval = atof(optarg);
+                break;
+            case 's':
+                sim.radio.sf = atoi(optarg);
+                break;
+            case 'b':
+                sim.radio.bw = atof(optarg) * 1000;
+                break;
+            case 'r':
+                sim.radio.cr = atoi(optarg) - 4;
+                break;
+            case 'p':
+                sim.radio.preamble = atoi(optarg);
+                break;
+            case 'f':
+                sim.radio.delay_factor = atof(optarg);
+                break;
+            case 'S':
+                seed = strtoull(optarg, NULL, 0);
+                break;
+            case 'C':
+                capture = optarg;
+                break;
+            case 'M':
+                sim.multipart_size = strtoul(optarg, NULL, 0);
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (sim.radio.sf < 5 || sim.radio.sf > 12 || sim.radio.cr < 1 || sim.radio.cr > 4 || sim.radio.bw <= 0 ||
+        node_count < 2 || sim.message_count < 0 || density <= 0 || sim.multipart_size > MESHCORE_MULTIPART_MAX_SIZE) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    sim.random_state = seed ? seed : 1;
+
+    for (size_t i = 0; i < sizeof(sim.channel_secret) / 2; i++) {
+        unsigned int value;
+        sscanf(&CHANNEL_SECRET[i * 2], "%2x", &value);
+        sim.channel_secret[i] = value;  // Channel keys are 16 bytes, the rest of the HMAC key stays zero
+    }
+    SHA256_HASH channel_digest;
+    Sha256Calculate(sim.channel_secret, MESHCORE_CIPHER_KEY_SIZE, &channel_digest);
+    sim.channel_hash = channel_digest.bytes[0];
+
+    if (topology != NULL) {
+        if (!load_topology(topology)) {
+            return 1;
+        }
+    } else {
+        generate_topology(node_count, density, client_fraction);
+    }
+
+    int clients = 0;
+    for (int i = 0; i < sim.node_count; i++) {
+        clients += sim.nodes[i].repeater ? 0 : 1;
+    }
+    if (sim.multipart_size > 0 && clients < 2) {
+        fprintf(stderr, "Multipart payloads need at least two clients\n");
+        return 1;
+    }
+
+    sim.messages = calloc(sim.message_count ? sim.message_count : 1, sizeof(message_t));
+    for (int i = 0; i < sim.node_count; i++) {
+        node_t* node    = &sim.nodes[i];
+        node->delivered = calloc(sim.message_count ? sim.message_count : 1, 1);
+        if (sim.multipart_size > 0 && !node->repeater) {
+            node->multipart      = malloc(sizeof(meshcore_multipart_t));
+            node->multipart_wake = INT64_MAX;
+            meshcore_multipart_init(node->multipart, node->hash, random_next());
+            meshcore_multipart_set_types(node->multipart, 1U << MESHCORE_PAYLOAD_TYPE_RAW_CUSTOM);
+        }
+    }
+    for (int i = 0; i < sim.message_count; i++) {
+        do {
+            sim.messages[i].origin = random_next() % sim.node_count;
+        } while (sim.multipart_size > 0 && sim.nodes[sim.messages[i].origin].repeater);
+        schedule((int64_t)(i * interval * 1e6), EVENT_ORIGINATE, sim.messages[i].origin, i);
+    }
+
+    if (capture != NULL) {
+        sim.capture = fopen(capture, "wb");
+        if (sim.capture == NULL) {
+            perror(capture);
+            return 1;
+        }
+        capture_file_header_t header = {
+            .magic       = CAPTURE_MAGIC,
+            .version     = CAPTURE_VERSION,
+            .header_size = sizeof(capture_file_header_t),
+        };
+        fwrite(&header, sizeof(header), 1, sim.capture);
+    }
+
+    event_t event;
+    while (next_event(&event)) {
+        sim.now = event.time;
+        switch (event.type) {
+            case EVENT_ORIGINATE:
+                originate(event.node, event.transmission);
+                break;
+            case EVENT_TX_START:
+                start_transmission(event.node, event.transmission);
+                break;
+            case EVENT_TX_END:
+                end_transmission(event.node, event.transmission);
+                break;
+            case EVENT_MULTIPART:
+                multipart_wake(event.node, event.transmission);
+                break;
+        }
+    }
+
+    if (sim.capture != NULL) {
+        fclose(sim.capture);
+    }
+    report();
+    return 0;
+}
@@ -0,0 +1,323 @@
+// SPDX-FileCopyrightText: 2025 Nicolai Electronics
+// SPDX-License-Identifier: MIT
+
+// Benchmarks SHA-256: the generic and hardware accelerated compression, and the multi-buffer SHA-256 and batched HMAC
+// used for MAC checks at every lane count the host supports. Both compressions are first checked against the NIST
+// test vectors and every lane count against the sequential implementation, the tool exits non-zero on a mismatch so it
+// doubles as a regression test.
+
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "crypto/sha256.h"
+#include "crypto/sha256_multi.h"
+#include "meshcore/cipher.h"
+#include "meshcore/packet.h"
+
+#define MESSAGES     64    // Messages hashed per batch
+#define MAX_MESSAGE  1024  // Largest message size benchmarked
+#define CHECK_ROUNDS 2000  // Random batches compared against the sequential implementation per lane count
+
+static const uint32_t lane_counts[]   = {1, 4, 8};
+static const uint32_t message_sizes[] = {16, 64, 128, 176, 1024};  // 176: the largest encrypted group message
+static const uint32_t key_counts[]    = {1, 2, 4, 8};
+
+// NIST FIPS 180-2 example messages
+static const struct {
+    const char* message;
+    uint32_t    repeat;
+    const char* digest;
+} vectors[] = {
+    {"abc", 1, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+    {"", 1, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+    {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+     "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+    {"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+     1, "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1"},
+    {"a", 1000000, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"},
+};
+
+static uint8_t messages[MESSAGES][MAX_MESSAGE];
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void fill_random(uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        data[i] = rand();
+    }
+}
+
+static bool check_vectors(void) {
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+        Sha256Context context;
+        SHA256_HASH   digest;
+        char          hex[SHA256_HASH_SIZE * 2 + 1];
+        Sha256Initialise(&context);
+        for (uint32_t r = 0; r < vectors[i].repeat; r++) {
+            Sha256Update(&context, vectors[i].message, strlen(vectors[i].message));
+        }
+        Sha256Finalise(&context, &digest);
+        for (size_t j = 0; j < SHA256_HASH_SIZE; j++) {
+            snprintf(&hex[j * 2], 3, "%02x", digest.bytes[j]);
+        }
+        if (strcmp(hex, vectors[i].digest) != 0) {
+            fprintf(stderr, "NIST vector %zu: got %s, expected %s\n", i, hex, vectors[i].digest);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Finalise random contexts with random messages, partially buffered contexts included, and compare with Sha256Finalise
+static bool check_lanes(void) {
+    for (unsigned int round = 0; round < CHECK_ROUNDS; round++) {
+        uint32_t       count = 1 + rand() % MESSAGES;
+        Sha256Context  contexts[MESSAGES];
+        Sha256Context  expected_contexts[MESSAGES];
+        Sha256Context* context_pointers[MESSAGES];
+        const void*    buffers[MESSAGES];
+        uint32_t       sizes[MESSAGES];
+        SHA256_HASH    digests[MESSAGES];
+        SHA256_HASH    expected;
+
+        for (uint32_t i = 0; i < count; i++) {
+            Sha256Initialise(&contexts[i]);
+            Sha256Update(&contexts[i], messages[(i + 1) % MESSAGES], rand() % 200);
+            expected_contexts[i] = contexts[i];
+            context_pointers[i]  = &contexts[i];
+            buffers[i]           = messages[i];
+            sizes[i]             = rand() % (round % 2 ? MAX_MESSAGE : 200);
+        }
+        Sha256MultiFinalise(context_pointers, buffers, sizes, digests, count);
+
+        for (uint32_t i = 0; i < count; i++) {
+            Sha256Update(&expected_contexts[i], buffers[i], sizes[i]);
+            Sha256Finalise(&expected_contexts[i], &expected);
+            if (memcmp(digests[i].bytes, expected.bytes, SHA256_HASH_SIZE) != 0) {
+                fprintf(stderr, "Mismatch with %u lanes: message %u of %u, %u bytes\n", Sha256MultiLanes(), i, count,
+                        sizes[i]);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static double bench_single(uint32_t size, double duration) {
+    SHA256_HASH digest;
+    uint64_t    hashed = 0;
+
+    double start   = now_seconds();
+    double elapsed = 0;
+    while (elapsed < duration) {
+        for (uint32_t i = 0; i < MESSAGES; i++) {
+            Sha256Calculate(messages[i], size, &digest);
+        }
+        hashed  += MESSAGES;
+        elapsed  = now_seconds() - start;
+    }
+    return elapsed * 1e9 / hashed;
+}
+
+static double bench_hash(uint32_t size, double duration) {
+    Sha256Context  contexts[MESSAGES];
+    Sha256Context* context_pointers[MESSAGES];
+    const void*    buffers[MESSAGES];
+    uint32_t       sizes[MESSAGES];
+    SHA256_HASH    digests[MESSAGES];
+    uint64_t       hashed = 0;
+
+    for (uint32_t i = 0; i < MESSAGES; i++) {
+        context_pointers[i] = &contexts[i];
+        buffers[i]          = messages[i];
+        sizes[i]            = size;
+    }
+
+    double start   = now_seconds();
+    double elapsed = 0;
+    while (elapsed < duration) {
+        for (uint32_t i = 0; i < MESSAGES; i++) {
+            Sha256Initialise(&contexts[i]);
+        }
+        Sha256MultiFinalise(context_pointers, buffers, sizes, digests, MESSAGES);
+        hashed  += MESSAGES;
+        elapsed  = now_seconds() - start;
+    }
+    return elapsed * 1e9 / hashed;
+}
+
+// Time the MAC check of one frame against key_count channel keys that share the channel hash
+static double bench_hmac(uint32_t key_count, bool batched, double duration) {
+    meshcore_hmac_key_t     keys[8];
+    meshcore_hmac_request_t requests[8];
+    uint8_t                 macs[8][MESHCORE_CIPHER_MAC_SIZE];
+    uint64_t                checked = 0;
+
+    for (uint32_t i = 0; i < key_count; i++) {
+        meshcore_hmac_key_init(&keys[i], messages[i], MESHCORE_SHARED_SECRET_SIZE);
+        requests[i].key     = &keys[i];
+        requests[i].data    = messages[MESSAGES - 1];
+        requests[i].length  = 160;
+        requests[i].out_mac = macs[i];
+    }
+
+    double start   = now_seconds();
+    double elapsed = 0;
+    while (elapsed < duration) {
+        if (batched) {
+            meshcore_hmac_batch(requests, key_count, MESHCORE_CIPHER_MAC_SIZE);
+        } else {
+            for (uint32_t i = 0; i < key_count; i++) {
+                Sha256Context context;
+                meshcore_hmac_begin(requests[i].key, &context);
+                Sha256Update(&context, requests[i].data, requests[i].length);
+                meshcore_hmac_finish(requests[i].key, &context, macs[i], MESHCORE_CIPHER_MAC_SIZE);
+            }
+        }
+        checked++;
+        elapsed = now_seconds() - start;
+    }
+    return elapsed * 1e9 / checked;
+}
+
+static void usage(const char* name) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -t, --time SECONDS  time per measurement (default 0.2)\n"
+            "  -c, --check         only check the NIST vectors and compare every lane count against the sequential\n"
+            "                      implementation\n",
+            name);
+}
+
+int main(int argc, char** argv) {
+    double duration   = 0.2;
+    bool   check_only = false;
+
+    static const struct option options[] = {
+        {"time", required_argument, NULL, 't'},
+        {"check", no_argument, NULL, 'c'},
+        {NULL, 0, NULL, 0},
+    };
+
+    int option;
+    while ((option = getopt_long(argc, argv, "t:ch", options, NULL)) != -1) {
+        switch (option) {
+            case 't':
+                duration = strtod(optarg, NULL);
+                break;
+            case 'c':
+                check_only = true;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (duration <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    srand(1);
+    for (size_t i = 0; i < MESSAGES; i++) {
+        fill_random(messages[i], MAX_MESSAGE);
+    }
+
+    bool accelerated = Sha256SetAccelerated(false);
+    if (!check_vectors()) {
+        return 2;
+    }
+    printf("Generic:        matches NIST vectors\n");
+    accelerated = Sha256SetAccelerated(true);
+    if (accelerated) {
+        if (!check_vectors()) {
+            return 2;
+        }
+        printf("Accelerated:    matches NIST vectors\n");
+    } else {
+        printf("Accelerated:    not supported\n");
+    }
+
+    uint32_t default_lanes = Sha256MultiLanes();
+    printf("Default:        %u lanes\n", default_lanes);
+
+    bool supported[sizeof(lane_counts) / sizeof(lane_counts[0])];
+    for (size_t i = 0; i < sizeof(lane_counts) / sizeof(lane_counts[0]); i++) {
+        supported[i] = Sha256MultiSetLanes(lane_counts[i]);
+        if (!supported[i]) {
+            printf("%u lanes:        not supported\n", lane_counts[i]);
+            continue;
+        }
+        if (!check_lanes()) {
+            return 2;
+        }
+        printf("%u lanes:        matches sequential\n", lane_counts[i]);
+    }
+    if (check_only) {
+        return 0;
+    }
+
+    printf("\nSHA-256 of one message, ns per message (MB/s)\n%-8s %16s", "bytes", "generic");
+    if (accelerated) {
+        printf(" %16s", "accelerated");
+    }
+    printf("\n");
+    for (size_t s = 0; s < sizeof(message_sizes) / sizeof(message_sizes[0]); s++) {
+        printf("%-8u", message_sizes[s]);
+        for (int enabled = 0; enabled <= (accelerated ? 1 : 0); enabled++) {
+            Sha256SetAccelerated(enabled);
+            double ns = bench_single(message_sizes[s], duration);
+            printf(" %7.0f (%6.1f)", ns, message_sizes[s] * 1e3 / ns);
+        }
+        printf("\n");
+    }
+
+    printf("\nMulti-buffer SHA-256, ns per message (MB/s)\n%-8s", "bytes");
+    for (size_t i = 0; i < sizeof(lane_counts) / sizeof(lane_counts[0]); i++) {
+        if (supported[i]) {
+            printf(" %16u", lane_counts[i]);
+        }
+    }
+    printf("\n");
+    for (size_t s = 0; s < sizeof(message_sizes) / sizeof(message_sizes[0]); s++) {
+        printf("%-8u", message_sizes[s]);
+        for (size_t i = 0; i < sizeof(lane_counts) / sizeof(lane_counts[0]); i++) {
+            if (supported[i]) {
+                Sha256MultiSetLanes(lane_counts[i]);
+                double ns = bench_hash(message_sizes[s], duration);
+                printf(" %7.0f (%6.1f)", ns, message_sizes[s] * 1e3 / ns);
+            }
+        }
+        printf("\n");
+    }
+
+    printf("\nMAC check of a 160 byte frame against keys sharing a channel hash, ns per frame\n%-8s %10s", "keys",
+           "one by one");
+    for (size_t i = 0; i < sizeof(lane_counts) / sizeof(lane_counts[0]); i++) {
+        if (supported[i]) {
+            printf(" %8u lanes", lane_counts[i]);
+        }
+    }
+    printf("\n");
+    for (size_t k = 0; k < sizeof(key_counts) / sizeof(key_counts[0]); k++) {
+        printf("%-8u %10.0f", key_counts[k], bench_hmac(key_counts[k], false, duration));
+        for (size_t i = 0; i < sizeof(lane_counts) / sizeof(lane_counts[0]); i++) {
+            if (supported[i]) {
+                Sha256MultiSetLanes(lane_counts[i]);
+                printf(" %14.0f", bench_hmac(key_counts[k], true, duration));
+            }
+        }
+        printf("\n");
+    }
+
+    Sha256MultiSetLanes(default_lanes);
+    return 0;
+}